@@ -1,7 +1,9 @@
 #include "PGMimage.h"
+#include "profiler.h"
 #include <iostream>
 #include <cstdio>
 #include <cstring>
+#include <cctype>
 #include <algorithm>
 
 PGMImage::PGMImage() : Imagen() {
@@ -13,33 +15,52 @@ PGMImage::~PGMImage() {
 }
 
 void PGMImage::skipComments(FILE* file) {
+    // Saltar espacios y líneas de comentario (los comentarios suelen ir tras un salto de línea)
     int c;
-    while ((c = fgetc(file)) == '#') {
-        while ((c = fgetc(file)) != '\n' && c != EOF);
+    while ((c = fgetc(file)) != EOF) {
+        if (c == '#') {
+            while ((c = fgetc(file)) != '\n' && c != EOF);
+        } else if (!isspace(c)) {
+            break;
+        }
     }
     ungetc(c, file);
 }
 
 bool PGMImage::load(const char* filename) {
-    FILE* file = fopen(filename, "r");
+    PROFILE_ZONE("load");
+    
+    FILE* file = fopen(filename, "rb");
     if (!file) {
         std::cerr << "Error: Cannot open file " << filename << std::endl;
         return false;
     }
     
     // Leer magic number
-    if (fscanf(file, "%2s", magic) != 1) {
+    char file_magic[3];
+    if (fscanf(file, "%2s", file_magic) != 1) {
         std::cerr << "Error: Cannot read magic number" << std::endl;
         fclose(file);
         return false;
     }
     
-    // Verificar que sea P2
-    if (strcmp(magic, "P2") != 0) {
-        std::cerr << "Error: Not a valid PGM file (P2 expected)" << std::endl;
-        fclose(file);
+    bool success = read(file, file_magic);
+    fclose(file);
+    releaseRawBuffer();
+    return success;
+}
+
+bool PGMImage::read(FILE* file, const char* file_magic) {
+    // Verificar que sea P2 (ASCII) o P5 (binario); 'magic' guarda siempre P2
+    if (strcmp(file_magic, "P2") == 0) {
+        binary = false;
+    } else if (strcmp(file_magic, "P5") == 0) {
+        binary = true;
+    } else {
+        std::cerr << "Error: Not a valid PGM file (P2 or P5 expected)" << std::endl;
         return false;
     }
+    strcpy(magic, "P2");
     
     // Saltar comentarios
     skipComments(file);
@@ -47,7 +68,6 @@ bool PGMImage::load(const char* filename) {
     // Leer dimensiones
     if (fscanf(file, "%d %d", &width, &height) != 2) {
         std::cerr << "Error: Cannot read image dimensions" << std::endl;
-        fclose(file);
         return false;
     }
     
@@ -57,46 +77,74 @@ bool PGMImage::load(const char* filename) {
     // Leer valor máximo
     if (fscanf(file, "%d", &max_color) != 1) {
         std::cerr << "Error: Cannot read max color value" << std::endl;
-        fclose(file);
         return false;
     }
     
     // Calcular número de píxeles
     pixel_count = width * height;
     allocatePixels();
+    if (!pixels) {
+        // Sin memoria o fuera del presupuesto (el motivo ya se informó)
+        return false;
+    }
+    
+    // Lectura de los píxeles (ASCII o raw)
+    PROFILE_ZONE("parse");
+    
+    // Formato binario: bloque raw tras el header
+    if (binary) {
+        if (!readBinaryPixels(file)) {
+            std::cerr << "Error: Truncated pixel data" << std::endl;
+            return false;
+        }
+        return true;
+    }
     
     // Leer píxeles
     for (int i = 0; i < pixel_count; i++) {
         int value;
         if (fscanf(file, "%d", &value) != 1) {
             std::cerr << "Error: Cannot read pixel value at position " << i << std::endl;
-            fclose(file);
             return false;
         }
         pixels[i] = value;
     }
     
-    fclose(file);
     return true;
 }
 
 bool PGMImage::save(const char* filename) {
-    FILE* file = fopen(filename, "w");
+    PROFILE_ZONE("save");
+    
+    FILE* file = fopen(filename, "wb");
     if (!file) {
         std::cerr << "Error: Cannot create file " << filename << std::endl;
         return false;
     }
     
+    bool written = write(file);
+    written = (fclose(file) == 0) && written;
+    releaseRawBuffer();
+    if (!written) {
+        std::cerr << "Error: Cannot write pixel data to " << filename << std::endl;
+    }
+    return written;
+}
+
+bool PGMImage::write(FILE* file) {
     // Escribir header
-    fprintf(file, "%s\n%d %d\n%d\n", magic, width, height, max_color);
+    fprintf(file, "%s\n%d %d\n%d\n", binary ? "P5" : magic, width, height, max_color);
+
+    if (binary) {
+        return writeBinaryPixels(file);
+    }
     
     // Escribir píxeles
     for (int i = 0; i < pixel_count; i++) {
         fprintf(file, "%d\n", pixels[i]);
     }
     
-    fclose(file);
-    return true;
+    return !ferror(file);
 }
 
 int PGMImage::getGrayValue(int x, int y) const {
@@ -120,8 +168,13 @@ PGMImage* PGMImage::clone() const {
     copy->max_color = this->max_color;
     copy->pixel_count = this->pixel_count;
     strcpy(copy->magic, this->magic);
+    copy->binary = this->binary;
     
     copy->allocatePixels();
+    if (!copy->pixels) {
+        delete copy;
+        return nullptr;
+    }
     for (int i = 0; i < pixel_count; i++) {
         copy->pixels[i] = this->pixels[i];
     }
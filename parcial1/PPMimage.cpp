@@ -1,7 +1,10 @@
 #include "PPMimage.h"
+#include "numa_memory.h"
+#include "profiler.h"
 #include <iostream>
 #include <cstdio>
 #include <cstring>
+#include <cctype>
 #include <algorithm>
 
 PPMImage::PPMImage() : Imagen() {
@@ -13,43 +16,66 @@ PPMImage::~PPMImage() {
 }
 
 void PPMImage::allocatePixels() {
-    if (pixels) {
+    if (width <= 0 || height <= 0) {
         deallocatePixels();
+        return;
     }
-    if (width > 0 && height > 0) {
-        pixel_count = width * height * 3; // 3 componentes RGB
-        pixels = new int[pixel_count];
+    pixel_count = width * height * 3; // 3 componentes RGB
+    if (pixels && allocated_count == static_cast<size_t>(pixel_count)) {
+        return;
     }
+    deallocatePixels();
+    pixels = NumaMemory::allocate(pixel_count, height);
+    allocated_count = pixels ? pixel_count : 0;
 }
 
 void PPMImage::skipComments(FILE* file) {
+    // Saltar espacios y líneas de comentario (los comentarios suelen ir tras un salto de línea)
     int c;
-    while ((c = fgetc(file)) == '#') {
-        while ((c = fgetc(file)) != '\n' && c != EOF);
+    while ((c = fgetc(file)) != EOF) {
+        if (c == '#') {
+            while ((c = fgetc(file)) != '\n' && c != EOF);
+        } else if (!isspace(c)) {
+            break;
+        }
     }
     ungetc(c, file);
 }
 
 bool PPMImage::load(const char* filename) {
-    FILE* file = fopen(filename, "r");
+    PROFILE_ZONE("load");
+    
+    FILE* file = fopen(filename, "rb");
     if (!file) {
         std::cerr << "Error: Cannot open file " << filename << std::endl;
         return false;
     }
     
     // Leer magic number
-    if (fscanf(file, "%2s", magic) != 1) {
+    char file_magic[3];
+    if (fscanf(file, "%2s", file_magic) != 1) {
         std::cerr << "Error: Cannot read magic number" << std::endl;
         fclose(file);
         return false;
     }
     
-    // Verificar que sea P3
-    if (strcmp(magic, "P3") != 0) {
-        std::cerr << "Error: Not a valid PPM file (P3 expected)" << std::endl;
-        fclose(file);
+    bool success = read(file, file_magic);
+    fclose(file);
+    releaseRawBuffer();
+    return success;
+}
+
+bool PPMImage::read(FILE* file, const char* file_magic) {
+    // Verificar que sea P3 (ASCII) o P6 (binario); 'magic' guarda siempre P3
+    if (strcmp(file_magic, "P3") == 0) {
+        binary = false;
+    } else if (strcmp(file_magic, "P6") == 0) {
+        binary = true;
+    } else {
+        std::cerr << "Error: Not a valid PPM file (P3 or P6 expected)" << std::endl;
         return false;
     }
+    strcpy(magic, "P3");
     
     // Saltar comentarios
     skipComments(file);
@@ -57,7 +83,6 @@ bool PPMImage::load(const char* filename) {
     // Leer dimensiones
     if (fscanf(file, "%d %d", &width, &height) != 2) {
         std::cerr << "Error: Cannot read image dimensions" << std::endl;
-        fclose(file);
         return false;
     }
     
@@ -67,45 +92,73 @@ bool PPMImage::load(const char* filename) {
     // Leer valor máximo
     if (fscanf(file, "%d", &max_color) != 1) {
         std::cerr << "Error: Cannot read max color value" << std::endl;
-        fclose(file);
         return false;
     }
     
     // Asignar memoria para píxeles RGB
     allocatePixels();
+    if (!pixels) {
+        // Sin memoria o fuera del presupuesto (el motivo ya se informó)
+        return false;
+    }
+    
+    // Lectura de los píxeles (ASCII o raw)
+    PROFILE_ZONE("parse");
+    
+    // Formato binario: bloque raw tras el header
+    if (binary) {
+        if (!readBinaryPixels(file)) {
+            std::cerr << "Error: Truncated pixel data" << std::endl;
+            return false;
+        }
+        return true;
+    }
     
     // Leer píxeles RGB
     for (int i = 0; i < pixel_count; i++) {
         int value;
         if (fscanf(file, "%d", &value) != 1) {
             std::cerr << "Error: Cannot read pixel value at position " << i << std::endl;
-            fclose(file);
             return false;
         }
         pixels[i] = value;
     }
     
-    fclose(file);
     return true;
 }
 
 bool PPMImage::save(const char* filename) {
-    FILE* file = fopen(filename, "w");
+    PROFILE_ZONE("save");
+    
+    FILE* file = fopen(filename, "wb");
     if (!file) {
         std::cerr << "Error: Cannot create file " << filename << std::endl;
         return false;
     }
     
+    bool written = write(file);
+    written = (fclose(file) == 0) && written;
+    releaseRawBuffer();
+    if (!written) {
+        std::cerr << "Error: Cannot write pixel data to " << filename << std::endl;
+    }
+    return written;
+}
+
+bool PPMImage::write(FILE* file) {
     // Escribir header
-    fprintf(file, "%s\n%d %d\n%d\n", magic, width, height, max_color);
+    fprintf(file, "%s\n%d %d\n%d\n", binary ? "P6" : magic, width, height, max_color);
+
+    if (binary) {
+        return writeBinaryPixels(file);
+    }
     
     // Escribir píxeles RGB
     for (int i = 0; i < pixel_count; i++) {
         fprintf(file, "%d\n", pixels[i]);
     }
     
-    fclose(file);
-    return true;
+    return !ferror(file);
 }
 
 int PPMImage::getRGBIndex(int x, int y, int component) const {
@@ -144,8 +197,13 @@ PPMImage* PPMImage::clone() const {
     copy->height = this->height;
     copy->max_color = this->max_color;
     strcpy(copy->magic, this->magic);
+    copy->binary = this->binary;
     
     copy->allocatePixels();
+    if (!copy->pixels) {
+        delete copy;
+        return nullptr;
+    }
     for (int i = 0; i < pixel_count; i++) {
         copy->pixels[i] = this->pixels[i];
     }
@@ -16,6 +16,8 @@ public:
     // Implementación de métodos virtuales
     bool load(const char* filename) override;
     bool save(const char* filename) override;
+    bool read(FILE* file, const char* file_magic) override;
+    bool write(FILE* file) override;
     
     // Métodos específicos para PPM
     RGB getRGBValue(int x, int y) const;
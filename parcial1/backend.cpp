@@ -0,0 +1,239 @@
+#include "backend.h"
+#include "thread_pool.h"
+#include "tile_scheduler.h"
+#include "pthread_filter.h"
+#include "iterative_filter.h"
+#include <iostream>
+#include <cstring>
+#ifdef _OPENMP
+#include "omp_filter.h"
+#endif
+#ifdef ENABLE_MPI
+#include "mpi_decomposition.h"
+#endif
+
+// Un hilo: applyFilter (con el bloqueo de caché fijado por setTileSize) o el filtro iterativo
+class SequentialBackend : public Backend {
+public:
+    SequentialBackend() : block_width(0), block_height(0) {}
+
+    Kind getKind() const { return SEQUENTIAL; }
+    int getNumThreads() const { return 1; }
+
+    void setTileSize(int width, int height) {
+        block_width = width;
+        block_height = height;
+    }
+
+    bool apply(Imagen* input, Imagen* output, Filter::FilterType filter_type, int iterations, int time_block) {
+        if (iterations > 1) {
+            return IterativeFilter::apply(input, output, filter_type, iterations,
+                                          IterativeFilter::runSequential, 0, 0, time_block);
+        }
+        return Filter::applyFilter(input, output, filter_type, block_width, block_height);
+    }
+
+private:
+    int block_width;
+    int block_height;
+};
+
+// Pool persistente con tiles 2D y robo de trabajo
+class PthreadBackend : public Backend {
+public:
+    explicit PthreadBackend(int num_threads) : pool(num_threads), scheduler(pool) {}
+
+    Kind getKind() const { return PTHREAD; }
+    int getNumThreads() const { return pool.getNumThreads(); }
+
+    void setTileSize(int width, int height) {
+        if (width > 0 && height > 0) {
+            scheduler.setTileSize(width, height);
+        }
+    }
+
+    bool apply(Imagen* input, Imagen* output, Filter::FilterType filter_type, int iterations, int time_block) {
+        if (iterations > 1) {
+            return PthreadFilter::applyIterative(input, output, filter_type, iterations, time_block, 0, 0, pool);
+        }
+        return PthreadFilter::applyTiles(input, output, filter_type, scheduler);
+    }
+
+private:
+    ThreadPool pool;
+    TileScheduler scheduler;
+};
+
+#ifdef _OPENMP
+// Filas repartidas con schedule(runtime), estático por defecto
+class OmpBackend : public Backend {
+public:
+    explicit OmpBackend(int num_threads)
+        : num_threads(num_threads > 0 ? num_threads : ThreadPool::getHardwareConcurrency()) {
+        omp_set_schedule(omp_sched_static, 0);
+    }
+
+    Kind getKind() const { return OPENMP; }
+    int getNumThreads() const { return num_threads; }
+
+    bool apply(Imagen* input, Imagen* output, Filter::FilterType filter_type, int iterations, int time_block) {
+        return OmpFilter::apply(input, output, filter_type, num_threads, iterations, time_block);
+    }
+
+private:
+    int num_threads;
+};
+#endif
+
+#ifdef ENABLE_MPI
+// Bandas de filas con halo solapado con el cálculo (MpiDecomposition). MPI
+// debe estar iniciado con MPI_THREAD_FUNNELED para usar varios hilos por proceso.
+class MpiBackend : public Backend {
+public:
+    explicit MpiBackend(int num_threads) : num_threads(num_threads > 0 ? num_threads : 1) {
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_size(MPI_COMM_WORLD, &size);
+#ifdef _OPENMP
+        omp_set_num_threads(this->num_threads);
+#else
+        this->num_threads = 1;
+#endif
+    }
+
+    Kind getKind() const { return MPI; }
+    int getNumThreads() const { return num_threads; }
+    int getNumProcesses() const { return size; }
+    bool isRoot() const { return rank == 0; }
+
+    bool apply(Imagen* input, Imagen* output, Filter::FilterType filter_type, int iterations, int time_block) {
+        (void)time_block; // el halo es de un píxel: cada iteración intercambia halos
+        
+        // La raíz difunde el tamaño; ceros si no puede continuar
+        int header[4] = {0, 0, 0, 0};
+        if (rank == 0 && input && output && Filter::prepareOutput(input, output)) {
+            header[0] = input->getWidth();
+            header[1] = input->getHeight();
+            header[2] = (strcmp(input->getMagic(), "P3") == 0) ? 3 : 1;
+            header[3] = input->getMaxColor();
+        }
+        MPI_Bcast(header, 4, MPI_INT, 0, MPI_COMM_WORLD);
+        if (header[0] <= 0) {
+            return false;
+        }
+        
+        MpiDecomposition decomposition(MPI_COMM_WORLD, MpiDecomposition::LAYOUT_ROWS);
+        LocalBlock block;
+        if (!decomposition.setup(header[0], header[1], header[2], header[3], block)) {
+            return false;
+        }
+        
+        decomposition.scatter(rank == 0 ? input->getPixels() : nullptr, block);
+        
+        bool success = true;
+        for (int it = 0; it < iterations && success; it++) {
+            if (it > 0) {
+                decomposition.commitResult(block);
+            }
+            OverlapTiming timing;
+            success = decomposition.exchangeAndFilter(block, filter_type, timing);
+        }
+        
+        int local_success = success ? 1 : 0;
+        int all_success = 0;
+        MPI_Allreduce(&local_success, &all_success, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+        if (!all_success) {
+            return false;
+        }
+        
+        decomposition.gather(block, rank == 0 ? output->getPixels() : nullptr);
+        return true;
+    }
+
+    void cancel() {
+        if (rank == 0) {
+            int header[4] = {0, 0, 0, 0};
+            MPI_Bcast(header, 4, MPI_INT, 0, MPI_COMM_WORLD);
+        }
+    }
+
+private:
+    int num_threads;
+    int rank, size;
+};
+#endif
+
+Backend* Backend::create(Kind kind, int num_threads) {
+    switch (kind) {
+        case SEQUENTIAL:
+            return new SequentialBackend();
+        case PTHREAD:
+            return new PthreadBackend(num_threads);
+#ifdef _OPENMP
+        case OPENMP:
+            return new OmpBackend(num_threads);
+#endif
+#ifdef ENABLE_MPI
+        case MPI:
+            return new MpiBackend(num_threads);
+#endif
+        default:
+            std::cerr << "Error: Backend '" << kindToString(kind) << "' is not available in this build"
+                      << (kind == OPENMP ? " (compile with -fopenmp)" : kind == MPI ? " (compile with mpic++ -DENABLE_MPI)" : "")
+                      << std::endl;
+            return nullptr;
+    }
+}
+
+bool Backend::isAvailable(Kind kind) {
+    switch (kind) {
+        case SEQUENTIAL:
+        case PTHREAD:
+        case AUTO:
+            return true;
+        case OPENMP:
+#ifdef _OPENMP
+            return true;
+#else
+            return false;
+#endif
+        case MPI:
+#ifdef ENABLE_MPI
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+bool Backend::stringToKind(const char* name, Kind& kind) {
+    if (strcmp(name, "sequential") == 0) {
+        kind = SEQUENTIAL;
+    } else if (strcmp(name, "pthread") == 0) {
+        kind = PTHREAD;
+    } else if (strcmp(name, "omp") == 0) {
+        kind = OPENMP;
+    } else if (strcmp(name, "mpi") == 0) {
+        kind = MPI;
+    } else if (strcmp(name, "auto") == 0) {
+        kind = AUTO;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* Backend::kindToString(Kind kind) {
+    switch (kind) {
+        case SEQUENTIAL:
+            return "sequential";
+        case PTHREAD:
+            return "pthread";
+        case OPENMP:
+            return "omp";
+        case MPI:
+            return "mpi";
+        default:
+            return "auto";
+    }
+}
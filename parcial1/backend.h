@@ -0,0 +1,57 @@
+#ifndef BACKEND_H
+#define BACKEND_H
+
+#include "imagen.h"
+#include "filter.h"
+
+// Backend de ejecución: la misma interfaz para filtrar con el backend
+// secuencial, el pool de pthreads, OpenMP o MPI, de modo que un solo programa
+// (unified_processor) elige uno con --backend. Cada backend conserva sus
+// recursos (pool, equipo de OpenMP) entre llamadas a apply.
+//
+// OpenMP solo existe si se compila con -fopenmp y MPI con -DENABLE_MPI
+// (mpic++); create devuelve nullptr para los que no están compilados.
+class Backend {
+public:
+    enum Kind {
+        SEQUENTIAL,
+        PTHREAD,
+        OPENMP,
+        MPI,
+        AUTO            // lo decide BackendSelector según la imagen y la calibración
+    };
+
+    virtual ~Backend() {}
+
+    virtual Kind getKind() const = 0;
+
+    // Hilos por proceso
+    virtual int getNumThreads() const = 0;
+
+    // Procesos que cooperan (más de 1 solo en MPI)
+    virtual int getNumProcesses() const { return 1; }
+
+    // Solo el proceso raíz carga y guarda las imágenes
+    virtual bool isRoot() const { return true; }
+
+    // Tamaño de bloque o tile de la convolución (0 = filas completas)
+    virtual void setTileSize(int width, int height) { (void)width; (void)height; }
+
+    // Aplica el filtro 'iterations' veces. En MPI es colectiva: los procesos
+    // que no son raíz pasan input y output nulos.
+    virtual bool apply(Imagen* input, Imagen* output, Filter::FilterType filter_type,
+                       int iterations, int time_block) = 0;
+
+    // La raíz no puede continuar (p. ej. no cargó la imagen): en MPI libera
+    // a los procesos que esperan en apply, que devuelven false
+    virtual void cancel() {}
+
+    // num_threads <= 0 usa la concurrencia del hardware
+    static Backend* create(Kind kind, int num_threads);
+    static bool isAvailable(Kind kind);
+
+    static bool stringToKind(const char* name, Kind& kind);
+    static const char* kindToString(Kind kind);
+};
+
+#endif
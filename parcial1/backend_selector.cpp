@@ -0,0 +1,321 @@
+#include "backend_selector.h"
+#include "tile_autotuner.h"
+#include "thread_pool.h"
+#include "synthetic_image.h"
+#include "image_factory.h"
+#include "timer.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+const char* BackendSelector::DEFAULT_PROFILE_PATH = "backend_profile.conf";
+
+bool BackendSelector::loadProfile(const char* path, BackendCalibration& calibration) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    std::string line, machine;
+    BackendCalibration result;
+    int fields = 0;
+
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, eq);
+        double value = atof(line.c_str() + eq + 1);
+
+        if (key == "machine") {
+            machine = line.substr(eq + 1);
+        } else if (key == "pgm_pixel_ns") {
+            result.pgm_pixel_ns = value;
+            fields++;
+        } else if (key == "ppm_pixel_ns") {
+            result.ppm_pixel_ns = value;
+            fields++;
+        } else if (key == "pool_thread_us") {
+            result.pool_thread_us = value;
+            fields++;
+        } else if (key == "pool_dispatch_us") {
+            result.pool_dispatch_us = value;
+            fields++;
+        } else if (key == "omp_thread_us") {
+            result.omp_thread_us = value;
+            fields++;
+        } else if (key == "omp_region_us") {
+            result.omp_region_us = value;
+            fields++;
+        }
+    }
+
+    // Un perfil de otra máquina no sirve, ni uno sin OpenMP si este programa lo tiene
+    if (fields != 6 || result.pgm_pixel_ns <= 0.0 || result.ppm_pixel_ns <= 0.0 || machine != TileAutotuner::machineSignature() ||
+        (Backend::isAvailable(Backend::OPENMP) && result.omp_thread_us < 0.0)) {
+        return false;
+    }
+
+    result.loaded = true;
+    calibration = result;
+    return true;
+}
+
+bool BackendSelector::saveProfile(const char* path, const BackendCalibration& calibration) {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Error: Cannot write backend profile " << path << std::endl;
+        return false;
+    }
+
+    file << "# Backend costs measured by the calibration run (ns per pixel, us per thread/dispatch)" << std::endl;
+    file << "machine=" << TileAutotuner::machineSignature() << std::endl;
+    file << "pgm_pixel_ns=" << calibration.pgm_pixel_ns << std::endl;
+    file << "ppm_pixel_ns=" << calibration.ppm_pixel_ns << std::endl;
+    file << "pool_thread_us=" << calibration.pool_thread_us << std::endl;
+    file << "pool_dispatch_us=" << calibration.pool_dispatch_us << std::endl;
+    file << "omp_thread_us=" << calibration.omp_thread_us << std::endl;
+    file << "omp_region_us=" << calibration.omp_region_us << std::endl;
+    return true;
+}
+
+BackendCalibration BackendSelector::calibrate(bool verbose) {
+    BackendCalibration calibration;
+    // Al menos dos hilos, para medir el coste de crearlos aunque haya una sola CPU
+    const int threads = std::max(2, ThreadPool::getHardwareConcurrency());
+
+    if (verbose) {
+        std::cout << "Calibrating backends (" << threads << " threads)..." << std::endl;
+    }
+
+#ifdef _OPENMP
+    // Primero OpenMP: la primera región es la única que crea el equipo
+    {
+        Timer timer;
+        timer.start();
+        #pragma omp parallel num_threads(threads)
+        {
+            volatile int sink = omp_get_thread_num();
+            (void)sink;
+        }
+        timer.stop();
+        calibration.omp_thread_us = timer.getElapsedMilliseconds() * 1000.0 / threads;
+
+        timer.start();
+        for (int rep = 0; rep < DISPATCH_REPETITIONS; rep++) {
+            #pragma omp parallel num_threads(threads)
+            {
+                volatile int sink = omp_get_thread_num();
+                (void)sink;
+            }
+        }
+        timer.stop();
+        calibration.omp_region_us = timer.getElapsedMilliseconds() * 1000.0 / DISPATCH_REPETITIONS;
+    }
+#endif
+
+    // Crear y destruir el pool (mejor de varias repeticiones)
+    double best_spawn_ms = -1.0;
+    for (int rep = 0; rep < CALIBRATION_REPETITIONS; rep++) {
+        Timer timer;
+        timer.start();
+        {
+            ThreadPool pool(threads);
+            pool.parallelFor(0, threads, [](int, int, int) {});
+        }
+        timer.stop();
+        if (best_spawn_ms < 0 || timer.getElapsedMilliseconds() < best_spawn_ms) {
+            best_spawn_ms = timer.getElapsedMilliseconds();
+        }
+    }
+    calibration.pool_thread_us = best_spawn_ms * 1000.0 / threads;
+
+    {
+        ThreadPool pool(threads);
+        Timer timer;
+        timer.start();
+        for (int rep = 0; rep < DISPATCH_REPETITIONS; rep++) {
+            pool.parallelFor(0, threads, [](int, int, int) {});
+        }
+        timer.stop();
+        calibration.pool_dispatch_us = timer.getElapsedMilliseconds() * 1000.0 / DISPATCH_REPETITIONS;
+    }
+
+    // Coste por píxel de la convolución en un hilo, como lo ejecuta el
+    // backend secuencial: applyFilter sobre una salida nueva (incluye
+    // reservarla y tocar sus páginas por primera vez)
+    for (int channels = 1; channels <= 3; channels += 2) {
+        SyntheticImage::Spec spec;
+        spec.pattern = SyntheticImage::NATURAL;
+        spec.width = CALIBRATION_SIZE;
+        spec.height = CALIBRATION_SIZE;
+        spec.channels = channels;
+
+        Imagen* input = SyntheticImage::create(spec);
+        if (!input) {
+            std::cerr << "Warning: Cannot allocate the calibration images" << std::endl;
+            return calibration;
+        }
+
+        double best_ms = -1.0;
+        for (int rep = 0; rep < CALIBRATION_REPETITIONS; rep++) {
+            Imagen* output = ImageFactory::createOutput(input);
+            if (!output) {
+                std::cerr << "Warning: Cannot allocate the calibration images" << std::endl;
+                delete input;
+                return calibration;
+            }
+            Timer timer;
+            timer.start();
+            Filter::applyFilter(input, output, Filter::BLUR);
+            timer.stop();
+            delete output;
+            if (best_ms < 0 || timer.getElapsedMilliseconds() < best_ms) {
+                best_ms = timer.getElapsedMilliseconds();
+            }
+        }
+        const double pixel_ns = best_ms * 1e6 / (static_cast<double>(spec.width) * spec.height);
+        if (channels == 1) {
+            calibration.pgm_pixel_ns = pixel_ns;
+        } else {
+            calibration.ppm_pixel_ns = pixel_ns;
+        }
+
+        delete input;
+    }
+
+    if (verbose) {
+        std::cout << "  Convolution: " << calibration.pgm_pixel_ns << " ns/pixel (PGM), "
+                  << calibration.ppm_pixel_ns << " ns/pixel (PPM)" << std::endl;
+        std::cout << "  Pool: " << calibration.pool_thread_us << " us/thread to create, "
+                  << calibration.pool_dispatch_us << " us per dispatch" << std::endl;
+        if (calibration.omp_thread_us >= 0.0) {
+            std::cout << "  OpenMP: " << calibration.omp_thread_us << " us/thread to create, "
+                      << calibration.omp_region_us << " us per region" << std::endl;
+        }
+    }
+
+    calibration.loaded = true;
+    return calibration;
+}
+
+BackendCalibration BackendSelector::builtinCalibration() {
+    // Del orden de una CPU actual con -O2; los hilos se cobran caros para que,
+    // sin medir, solo se paralelicen imágenes claramente grandes
+    BackendCalibration calibration;
+    calibration.pgm_pixel_ns = 30.0;
+    calibration.ppm_pixel_ns = 40.0;
+    calibration.pool_thread_us = 100.0;
+    calibration.pool_dispatch_us = 20.0;
+    if (Backend::isAvailable(Backend::OPENMP)) {
+        calibration.omp_thread_us = 100.0;
+        calibration.omp_region_us = 20.0;
+    }
+    return calibration;
+}
+
+BackendCalibration BackendSelector::loadOrCalibrate(const char* path, bool force_calibration, bool verbose) {
+    // Solo se mide y se escribe un perfil si se pide
+    const bool may_calibrate = force_calibration || path;
+    if (!path) {
+        path = DEFAULT_PROFILE_PATH;
+    }
+
+    BackendCalibration calibration;
+    if (!force_calibration && loadProfile(path, calibration)) {
+        if (verbose) {
+            std::cout << "Backend profile loaded from " << path << ": " << calibration.pgm_pixel_ns << "/"
+                      << calibration.ppm_pixel_ns << " ns/pixel (PGM/PPM), pool thread "
+                      << calibration.pool_thread_us << " us" << std::endl;
+        }
+        return calibration;
+    }
+    if (!may_calibrate) {
+        if (verbose) {
+            std::cout << "No backend profile in " << path << ": using built-in costs "
+                      << "(--recalibrate measures this machine)" << std::endl;
+        }
+        return builtinCalibration();
+    }
+
+    calibration = calibrate(verbose);
+    if (!calibration.loaded) {
+        return builtinCalibration();
+    }
+    if (saveProfile(path, calibration) && verbose) {
+        std::cout << "Backend profile saved to " << path << std::endl;
+    }
+    return calibration;
+}
+
+BackendChoice BackendSelector::choose(const BackendCalibration& calibration, int width, int height, int channels,
+                                      int iterations, int max_threads, bool verbose) {
+    const int cpus = ThreadPool::getHardwareConcurrency();
+    if (max_threads <= 0) {
+        max_threads = cpus;
+    }
+    iterations = std::max(1, iterations);
+
+    const double pixels = static_cast<double>(width) * height;
+    const double pixel_ns = (channels == 3) ? calibration.ppm_pixel_ns : calibration.pgm_pixel_ns;
+    const double compute_ms = iterations * pixels * pixel_ns / 1e6;
+
+    BackendChoice best;
+    best.predicted_ms = compute_ms;
+
+    if (verbose) {
+        std::cout << "Backend auto: " << width << "x" << height << "x" << channels << ", " << iterations
+                  << " iteration(s), up to " << max_threads << " threads on " << cpus << " CPU(s)" << std::endl;
+        std::cout << "  sequential: " << compute_ms << " ms" << std::endl;
+    }
+
+    // Potencias de dos hasta max_threads, y max_threads
+    std::vector<int> counts;
+    for (int n = 2; n < max_threads; n *= 2) {
+        counts.push_back(n);
+    }
+    if (max_threads > 1) {
+        counts.push_back(max_threads);
+    }
+
+    for (size_t c = 0; c < counts.size(); c++) {
+        const int n = counts[c];
+        const double parallel_ms = compute_ms / std::min(n, cpus);
+
+        BackendChoice candidates[2];
+        candidates[0].kind = Backend::PTHREAD;
+        candidates[0].predicted_ms = (n * calibration.pool_thread_us +
+                                      iterations * calibration.pool_dispatch_us) / 1000.0 + parallel_ms;
+        candidates[1].kind = Backend::OPENMP;
+        candidates[1].predicted_ms = (n * calibration.omp_thread_us +
+                                      iterations * calibration.omp_region_us) / 1000.0 + parallel_ms;
+        const int num_candidates = calibration.omp_thread_us >= 0.0 ? 2 : 1;
+
+        for (int k = 0; k < num_candidates; k++) {
+            candidates[k].threads = n;
+            if (verbose) {
+                std::cout << "  " << Backend::kindToString(candidates[k].kind) << " x" << n << ": "
+                          << candidates[k].predicted_ms << " ms" << std::endl;
+            }
+            // Solo se cambia por una mejora clara: los hilos tienen costes que el modelo no ve
+            if (candidates[k].predicted_ms < best.predicted_ms * 0.9) {
+                best = candidates[k];
+            }
+        }
+    }
+
+    if (verbose) {
+        std::cout << "  Chosen: " << Backend::kindToString(best.kind) << " with " << best.threads
+                  << " thread(s) (predicted " << best.predicted_ms << " ms)" << std::endl;
+    }
+    return best;
+}
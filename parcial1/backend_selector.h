@@ -0,0 +1,73 @@
+#ifndef BACKEND_SELECTOR_H
+#define BACKEND_SELECTOR_H
+
+#include "backend.h"
+
+// Costes de esta máquina que decide --backend auto
+struct BackendCalibration {
+    double pgm_pixel_ns;      // convolución en un hilo, por píxel de un PGM
+    double ppm_pixel_ns;      // ídem en un PPM (tres canales en la misma pasada)
+    double pool_thread_us;    // crear y destruir un hilo del pool
+    double pool_dispatch_us;  // un parallelFor con el pool ya creado
+    double omp_thread_us;     // crear el equipo de OpenMP, por hilo (< 0 sin -fopenmp)
+    double omp_region_us;     // una región paralela con el equipo ya creado
+    bool loaded;
+
+    BackendCalibration() : pgm_pixel_ns(0.0), ppm_pixel_ns(0.0), pool_thread_us(0.0), pool_dispatch_us(0.0),
+                           omp_thread_us(-1.0), omp_region_us(-1.0), loaded(false) {}
+};
+
+// Backend y número de hilos elegidos, con el tiempo de filtro previsto
+struct BackendChoice {
+    Backend::Kind kind;
+    int threads;
+    double predicted_ms;
+
+    BackendChoice() : kind(Backend::SEQUENTIAL), threads(1), predicted_ms(0.0) {}
+};
+
+// Elige el backend según el tamaño de la imagen. Una ejecución de
+// calibración (menos de un segundo) mide el coste por píxel de la
+// convolución en PGM y PPM y lo que cuesta crear hilos y repartir trabajo;
+// se guarda en un perfil como el de tiles y las ejecuciones siguientes solo
+// lo leen. Solo se calibra si se pide; sin perfil se usan costes fijos
+// conservadores (builtinCalibration).
+//
+// Modelo: secuencial = N * t_píxel; paralelo con n hilos = n * t_hilo +
+// iteraciones * (t_reparto + N * t_píxel / min(n, CPUs)). El coste va por
+// píxel y por formato: un PPM hace sus tres canales en la misma pasada y
+// cuesta poco más que un PGM del mismo tamaño. En imágenes
+// pequeñas (lena) crear los hilos cuesta más de lo que ahorran y gana el
+// secuencial. No modela el límite de ancho de banda de memoria, así que en
+// imágenes enormes tiende a elegir todos los hilos.
+class BackendSelector {
+public:
+    static const char* DEFAULT_PROFILE_PATH;
+
+    static bool loadProfile(const char* path, BackendCalibration& calibration);
+    static bool saveProfile(const char* path, const BackendCalibration& calibration);
+
+    // Ejecuta la calibración. Conviene llamarla antes de cualquier región
+    // OpenMP: la creación del equipo solo se puede medir la primera vez.
+    static BackendCalibration calibrate(bool verbose);
+
+    // Costes fijos para cuando no hay perfil: sin medir ni escribir nada
+    static BackendCalibration builtinCalibration();
+
+    // Carga el perfil de 'path' (nullptr = DEFAULT_PROFILE_PATH). Calibra y lo
+    // guarda solo con force_calibration o una ruta explícita sin perfil
+    // válido; si no, usa builtinCalibration
+    static BackendCalibration loadOrCalibrate(const char* path, bool force_calibration, bool verbose);
+
+    // Mejor opción para width x height x channels con 'iterations' pasadas,
+    // probando hasta max_threads hilos (<= 0: la concurrencia del hardware)
+    static BackendChoice choose(const BackendCalibration& calibration, int width, int height, int channels,
+                                int iterations, int max_threads, bool verbose);
+
+private:
+    static const int CALIBRATION_SIZE = 1024;
+    static const int CALIBRATION_REPETITIONS = 3;
+    static const int DISPATCH_REPETITIONS = 50;
+};
+
+#endif
@@ -1,4 +1,6 @@
 #include "filter.h"
+#include "profiler.h"
+#include "result_cache.h"
 #include <iostream>
 #include <cstring>
 #include <algorithm>
@@ -32,22 +34,45 @@ Filter::~Filter() {
 }
 
 bool Filter::applyFilter(Imagen* input, Imagen* output, FilterType filter_type) {
+    PROFILE_ZONE("filter");
+    
     if (!input || !output) {
         std::cerr << "Error: Input or output image is null" << std::endl;
         return false;
     }
     
-    switch (filter_type) {
-        case BLUR:
-            return applyBlur(input, output);
-        case LAPLACE:
-            return applyLaplace(input, output);
-        case SHARPEN:
-            return applySharpen(input, output);
-        default:
-            std::cerr << "Error: Unknown filter type" << std::endl;
-            return false;
+    // Con la caché de resultados activa, un resultado ya guardado se sirve sin filtrar
+    return ResultCache::apply(input, output, filter_type, 1, [&]() {
+        switch (filter_type) {
+            case BLUR:
+                return applyBlur(input, output);
+            case LAPLACE:
+                return applyLaplace(input, output);
+            case SHARPEN:
+                return applySharpen(input, output);
+            default:
+                std::cerr << "Error: Unknown filter type" << std::endl;
+                return false;
+        }
+    });
+}
+
+bool Filter::applyFilter(Imagen* input, Imagen* output, FilterType filter_type,
+                         int block_width, int block_height) {
+    if (block_width <= 0 || block_height <= 0) {
+        return applyFilter(input, output, filter_type);
     }
+    
+    PROFILE_ZONE("filter");
+    
+    if (!input || !output) {
+        std::cerr << "Error: Input or output image is null" << std::endl;
+        return false;
+    }
+    
+    return ResultCache::apply(input, output, filter_type, 1, [&]() {
+        return applyFilterBlocked(input, output, filter_type, block_width, block_height);
+    });
 }
 
 bool Filter::applyBlur(Imagen* input, Imagen* output) {
@@ -97,18 +122,33 @@ bool Filter::applyConvolution(Imagen* input, Imagen* output, const float kernel[
 }
 
 bool Filter::applyConvolutionPGM(PGMImage* input, PGMImage* output, const float kernel[3][3]) {
-    int width = input->getWidth();
-    int height = input->getHeight();
-    
     // Configurar la imagen de salida
-    output->setWidth(width);
-    output->setHeight(height);
-    output->setMaxColor(input->getMaxColor());
-    output->allocatePixels();
+    if (!prepareOutput(input, output)) {
+        return false;
+    }
     
     // Aplicar convolución
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
+    convolveRegionPGM(input, output, kernel, 0, 0, input->getWidth(), input->getHeight());
+    
+    return true;
+}
+
+bool Filter::applyConvolutionPPM(PPMImage* input, PPMImage* output, const float kernel[3][3]) {
+    // Configurar la imagen de salida
+    if (!prepareOutput(input, output)) {
+        return false;
+    }
+    
+    // Aplicar convolución para cada canal RGB
+    convolveRegionPPM(input, output, kernel, 0, 0, input->getWidth(), input->getHeight());
+    
+    return true;
+}
+
+void Filter::convolveRegionPGM(PGMImage* input, PGMImage* output, const float kernel[3][3],
+                               int x0, int y0, int x1, int y1) {
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
             float sum = 0.0f;
             
             // Aplicar kernel 3x3
@@ -129,23 +169,12 @@ bool Filter::applyConvolutionPGM(PGMImage* input, PGMImage* output, const float
             output->setGrayValue(x, y, result);
         }
     }
-    
-    return true;
 }
 
-bool Filter::applyConvolutionPPM(PPMImage* input, PPMImage* output, const float kernel[3][3]) {
-    int width = input->getWidth();
-    int height = input->getHeight();
-    
-    // Configurar la imagen de salida
-    output->setWidth(width);
-    output->setHeight(height);
-    output->setMaxColor(input->getMaxColor());
-    output->allocatePixels();
-    
-    // Aplicar convolución para cada canal RGB
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
+void Filter::convolveRegionPPM(PPMImage* input, PPMImage* output, const float kernel[3][3],
+                               int x0, int y0, int x1, int y1) {
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
             float sum_r = 0.0f, sum_g = 0.0f, sum_b = 0.0f;
             
             // Aplicar kernel 3x3
@@ -172,10 +201,211 @@ bool Filter::applyConvolutionPPM(PPMImage* input, PPMImage* output, const float
             output->setRGBValue(x, y, result_r, result_g, result_b);
         }
     }
+}
+
+bool Filter::prepareOutput(Imagen* input, Imagen* output) {
+    if (!input || !output) {
+        std::cerr << "Error: Input or output image is null" << std::endl;
+        return false;
+    }
+    
+    output->setWidth(input->getWidth());
+    output->setHeight(input->getHeight());
+    output->setMaxColor(input->getMaxColor());
+    output->setBinary(input->isBinary());
+    output->allocatePixels();
+    
+    // Sin memoria o fuera del presupuesto (el motivo ya se informó)
+    return output->getPixels() != nullptr;
+}
+
+bool Filter::clipRegion(Imagen* image, int& x0, int& y0, int& x1, int& y1) {
+    x0 = std::max(0, x0);
+    y0 = std::max(0, y0);
+    x1 = std::min(image->getWidth(), x1);
+    y1 = std::min(image->getHeight(), y1);
+    return x0 < x1 && y0 < y1;
+}
+
+bool Filter::applyFilterRegion(Imagen* input, Imagen* output, FilterType filter_type,
+                               int x0, int y0, int x1, int y1) {
+    if (!input || !output) {
+        std::cerr << "Error: Input or output image is null" << std::endl;
+        return false;
+    }
+    
+    const float (*kernel)[3] = getKernel(filter_type);
+    if (!kernel) {
+        std::cerr << "Error: Unknown filter type" << std::endl;
+        return false;
+    }
+    
+    // Región vacía: nada que hacer
+    if (!clipRegion(input, x0, y0, x1, y1)) {
+        return true;
+    }
+    
+    if (strcmp(input->getMagic(), "P2") == 0) {
+        PGMImage* pgm_input = dynamic_cast<PGMImage*>(input);
+        PGMImage* pgm_output = dynamic_cast<PGMImage*>(output);
+        
+        if (!pgm_input || !pgm_output) {
+            std::cerr << "Error: Failed to cast to PGMImage" << std::endl;
+            return false;
+        }
+        
+        convolveRegionPGM(pgm_input, pgm_output, kernel, x0, y0, x1, y1);
+        return true;
+    }
+    else if (strcmp(input->getMagic(), "P3") == 0) {
+        PPMImage* ppm_input = dynamic_cast<PPMImage*>(input);
+        PPMImage* ppm_output = dynamic_cast<PPMImage*>(output);
+        
+        if (!ppm_input || !ppm_output) {
+            std::cerr << "Error: Failed to cast to PPMImage" << std::endl;
+            return false;
+        }
+        
+        convolveRegionPPM(ppm_input, ppm_output, kernel, x0, y0, x1, y1);
+        return true;
+    }
+    
+    return false;
+}
+
+bool Filter::applyPointOpRegion(Imagen* input, Imagen* output, PointOp op,
+                                int x0, int y0, int x1, int y1) {
+    if (!input || !output || !op) {
+        std::cerr << "Error: Input, output or operation is null" << std::endl;
+        return false;
+    }
+    
+    if (!clipRegion(input, x0, y0, x1, y1)) {
+        return true;
+    }
+    
+    // PGM: 1 valor por píxel, PPM: 3 valores (R, G, B) consecutivos
+    int components = (strcmp(input->getMagic(), "P3") == 0) ? 3 : 1;
+    int width = input->getWidth();
+    int max_color = input->getMaxColor();
+    const int* src = input->getPixels();
+    int* dst = output->getPixels();
+    
+    for (int y = y0; y < y1; y++) {
+        for (int i = (y * width + x0) * components; i < (y * width + x1) * components; i++) {
+            dst[i] = clampValue(op(src[i], max_color), 0, max_color);
+        }
+    }
+    
+    return true;
+}
+
+bool Filter::applyFilterBlocked(Imagen* input, Imagen* output, FilterType filter_type,
+                                int width, int height) {
+    if (!prepareOutput(input, output)) {
+        return false;
+    }
     
+    if (width <= 0 || height <= 0) {
+        return applyFilterRegion(input, output, filter_type, 0, 0, input->getWidth(), input->getHeight());
+    }
+    
+    for (int by = 0; by < input->getHeight(); by += height) {
+        for (int bx = 0; bx < input->getWidth(); bx += width) {
+            if (!applyFilterRegion(input, output, filter_type, bx, by, bx + width, by + height)) {
+                return false;
+            }
+        }
+    }
     return true;
 }
 
+void Filter::convolveWindow(const float kernel[3][3], int channels, int max_color,
+                            int image_width, int image_height,
+                            const int* src, int src_x, int src_y, int src_width,
+                            int* dst, int dst_x, int dst_y, int dst_width,
+                            int x0, int y0, int x1, int y1) {
+    const size_t src_stride = static_cast<size_t>(src_width) * channels;
+    const size_t dst_stride = static_cast<size_t>(dst_width) * channels;
+    
+    for (int y = y0; y < y1; y++) {
+        int* dst_row = dst + (y - dst_y) * dst_stride;
+        
+        // Píxeles con los 8 vecinos dentro de la imagen: sin comprobar bordes
+        int inner_x0 = x1, inner_x1 = x1;
+        if (y > 0 && y < image_height - 1) {
+            inner_x0 = std::min(x1, std::max(x0, 1));
+            inner_x1 = std::max(inner_x0, std::min(x1, image_width - 1));
+        }
+        
+        for (int x = x0; x < x1; x++) {
+            if (x == inner_x0 && inner_x0 < inner_x1) {
+                // Mismo orden de suma que el caso general, muestra a muestra
+                // (los canales van entrelazados: el vecino está a 'channels')
+                const int C = channels;
+                const int* above = src + (y - 1 - src_y) * src_stride + (inner_x0 - src_x) * C;
+                const int* center = above + src_stride;
+                const int* below = center + src_stride;
+                int* out = dst_row + (inner_x0 - dst_x) * C;
+                const int count = (inner_x1 - inner_x0) * C;
+                const float k00 = kernel[0][0], k01 = kernel[0][1], k02 = kernel[0][2];
+                const float k10 = kernel[1][0], k11 = kernel[1][1], k12 = kernel[1][2];
+                const float k20 = kernel[2][0], k21 = kernel[2][1], k22 = kernel[2][2];
+                for (int i = 0; i < count; i++) {
+                    float sum = 0.0f;
+                    sum += above[i - C] * k00;
+                    sum += above[i] * k01;
+                    sum += above[i + C] * k02;
+                    sum += center[i - C] * k10;
+                    sum += center[i] * k11;
+                    sum += center[i + C] * k12;
+                    sum += below[i - C] * k20;
+                    sum += below[i] * k21;
+                    sum += below[i + C] * k22;
+                    out[i] = clampValue(static_cast<int>(sum), 0, max_color);
+                }
+                x = inner_x1 - 1;
+                continue;
+            }
+            
+            for (int ch = 0; ch < channels; ch++) {
+                float sum = 0.0f;
+                
+                // Aplicar kernel 3x3 (los vecinos fuera de la imagen no cuentan)
+                for (int ky = -1; ky <= 1; ky++) {
+                    int ny = y + ky;
+                    if (ny < 0 || ny >= image_height) {
+                        continue;
+                    }
+                    const int* src_row = src + (ny - src_y) * src_stride;
+                    for (int kx = -1; kx <= 1; kx++) {
+                        int nx = x + kx;
+                        if (nx < 0 || nx >= image_width) {
+                            continue;
+                        }
+                        sum += src_row[(nx - src_x) * channels + ch] * kernel[ky + 1][kx + 1];
+                    }
+                }
+                
+                dst_row[(x - dst_x) * channels + ch] = clampValue(static_cast<int>(sum), 0, max_color);
+            }
+        }
+    }
+}
+
+const float (*Filter::getKernel(FilterType filter_type))[3] {
+    switch (filter_type) {
+        case BLUR:
+            return BLUR_KERNEL;
+        case LAPLACE:
+            return LAPLACE_KERNEL;
+        case SHARPEN:
+            return SHARPEN_KERNEL;
+        default:
+            return nullptr;
+    }
+}
+
 Filter::FilterType Filter::stringToFilterType(const char* filter_name) {
     if (strcmp(filter_name, "blur") == 0) {
         return BLUR;
@@ -189,6 +419,15 @@ Filter::FilterType Filter::stringToFilterType(const char* filter_name) {
     return BLUR;
 }
 
+bool Filter::stringToFilterType(const char* filter_name, FilterType& filter_type) {
+    if (!filter_name || (strcmp(filter_name, "blur") != 0 && strcmp(filter_name, "laplace") != 0 &&
+                         strcmp(filter_name, "sharpen") != 0)) {
+        return false;
+    }
+    filter_type = stringToFilterType(filter_name);
+    return true;
+}
+
 const char* Filter::filterTypeToString(FilterType filter_type) {
     switch (filter_type) {
         case BLUR:
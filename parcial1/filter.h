@@ -21,6 +21,46 @@ public:
     // Método principal para aplicar filtro
     static bool applyFilter(Imagen* input, Imagen* output, FilterType filter_type);
     
+    // Igual, recorriendo la imagen en bloques de block_width x block_height
+    // (0 = filas completas); el resultado no depende del tamaño de bloque
+    static bool applyFilter(Imagen* input, Imagen* output, FilterType filter_type,
+                            int block_width, int block_height);
+    
+    // Función para operaciones punto a punto (valor, max_color) -> nuevo valor
+    typedef int (*PointOp)(int value, int max_color);
+    
+    // Configura dimensiones y memoria de la salida sin aplicar ningún filtro
+    static bool prepareOutput(Imagen* input, Imagen* output);
+    
+    // Aplican el filtro u operación solo sobre la región [x0, x1) x [y0, y1).
+    // La salida debe estar preparada con prepareOutput; regiones disjuntas
+    // pueden procesarse en paralelo desde varios hilos.
+    static bool applyFilterRegion(Imagen* input, Imagen* output, FilterType filter_type,
+                                  int x0, int y0, int x1, int y1);
+    static bool applyPointOpRegion(Imagen* input, Imagen* output, PointOp op,
+                                   int x0, int y0, int x1, int y1);
+    
+    // Bloqueo de caché 2D del motor de convolución, sin caché de resultados
+    // ni zona de perfilado (lo usa el autotuner para medir cada candidato)
+    static bool applyFilterBlocked(Imagen* input, Imagen* output, FilterType filter_type,
+                                   int block_width, int block_height);
+    
+    // Convolución 3x3 sobre buffers crudos con 'channels' enteros por píxel.
+    // 'src' guarda una ventana de la imagen global (image_width x image_height)
+    // que empieza en (src_x, src_y) y tiene src_width píxeles por fila; 'dst'
+    // igual con (dst_x, dst_y, dst_width). Calcula la región global
+    // [x0, x1) x [y0, y1) con el mismo orden de suma y el mismo borde que
+    // applyFilter; la ventana de 'src' debe cubrir la región más un píxel
+    // por lado (salvo en los bordes de la imagen).
+    static void convolveWindow(const float kernel[3][3], int channels, int max_color,
+                               int image_width, int image_height,
+                               const int* src, int src_x, int src_y, int src_width,
+                               int* dst, int dst_x, int dst_y, int dst_width,
+                               int x0, int y0, int x1, int y1);
+    
+    // Kernel 3x3 asociado a cada tipo de filtro
+    static const float (*getKernel(FilterType filter_type))[3];
+    
     // Métodos específicos para cada filtro
     static bool applyBlur(Imagen* input, Imagen* output);
     static bool applyLaplace(Imagen* input, Imagen* output);
@@ -28,6 +68,8 @@ public:
     
     // Método para convertir string a FilterType
     static FilterType stringToFilterType(const char* filter_name);
+    // Igual, pero false si el nombre no es blur, laplace ni sharpen
+    static bool stringToFilterType(const char* filter_name, FilterType& filter_type);
     static const char* filterTypeToString(FilterType filter_type);
     static const float BLUR_KERNEL[3][3];
     static const float LAPLACE_KERNEL[3][3];
@@ -44,6 +86,11 @@ private:
     // Métodos para PGM y PPM específicamente
     static bool applyConvolutionPGM(PGMImage* input, PGMImage* output, const float kernel[3][3]);
     static bool applyConvolutionPPM(PPMImage* input, PPMImage* output, const float kernel[3][3]);
+    static void convolveRegionPGM(PGMImage* input, PGMImage* output, const float kernel[3][3],
+                                  int x0, int y0, int x1, int y1);
+    static void convolveRegionPPM(PPMImage* input, PPMImage* output, const float kernel[3][3],
+                                  int x0, int y0, int x1, int y1);
+    static bool clipRegion(Imagen* image, int& x0, int& y0, int& x1, int& y1);
     
     // Método para clamping de valores
     static int clampValue(int value, int min_val, int max_val);
@@ -0,0 +1,261 @@
+#include "frame_stream.h"
+#include "PGMimage.h"
+#include "PPMimage.h"
+#include "timer.h"
+#include "profiler.h"
+#include <iostream>
+#include <algorithm>
+#include <deque>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <pthread.h>
+
+// Un frame en tránsito: entrada, salida y cuándo empezó a leerse
+struct FrameSlot {
+    Imagen* input;
+    Imagen* output;
+    long long start_us;
+
+    FrameSlot() : input(nullptr), output(nullptr), start_us(0) {}
+};
+
+// Cola bloqueante entre etapas; nullptr marca el final del flujo
+class SlotQueue {
+public:
+    SlotQueue() {
+        pthread_mutex_init(&mutex, nullptr);
+        pthread_cond_init(&cond, nullptr);
+    }
+
+    ~SlotQueue() {
+        pthread_mutex_destroy(&mutex);
+        pthread_cond_destroy(&cond);
+    }
+
+    void push(FrameSlot* slot) {
+        pthread_mutex_lock(&mutex);
+        slots.push_back(slot);
+        pthread_cond_signal(&cond);
+        pthread_mutex_unlock(&mutex);
+    }
+
+    FrameSlot* pop() {
+        pthread_mutex_lock(&mutex);
+        while (slots.empty()) {
+            pthread_cond_wait(&cond, &mutex);
+        }
+        FrameSlot* slot = slots.front();
+        slots.pop_front();
+        pthread_mutex_unlock(&mutex);
+        return slot;
+    }
+
+private:
+    std::deque<FrameSlot*> slots;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+};
+
+// Estado compartido por las tres etapas
+struct StreamPipeline {
+    FILE* input;
+    FILE* output;
+    bool has_filter;
+    SlotQueue free_slots, decoded, filtered;
+    std::atomic<bool> stop;        // una etapa falló: las demás dejan de trabajar
+    bool decode_error, encode_error;
+    double decode_ms, encode_ms;
+    std::vector<double> latencies_ms;
+    long long last_write_us;
+
+    StreamPipeline() : input(nullptr), output(nullptr), has_filter(true), stop(false), decode_error(false),
+                       encode_error(false), decode_ms(0.0), encode_ms(0.0), last_write_us(0) {}
+};
+
+static bool isColor(const Imagen* image) {
+    return strcmp(image->getMagic(), "P3") == 0;
+}
+
+double StreamStats::getLatencyPercentile(double p) const {
+    if (latencies_ms.empty()) {
+        return 0.0;
+    }
+    std::vector<double> sorted(latencies_ms);
+    std::sort(sorted.begin(), sorted.end());
+    size_t rank = static_cast<size_t>(p / 100.0 * sorted.size() + 0.999999);
+    rank = std::max<size_t>(1, std::min(rank, sorted.size()));
+    return sorted[rank - 1];
+}
+
+int FrameStream::readFrame(FILE* file, Imagen*& frame) {
+    // Entre frames puede haber espacios; EOF aquí es el final normal del flujo
+    int c;
+    while ((c = fgetc(file)) != EOF && isspace(c));
+    if (c == EOF) {
+        return 0;
+    }
+
+    char magic[3] = {static_cast<char>(c), static_cast<char>(fgetc(file)), '\0'};
+    const bool gray = strcmp(magic, "P2") == 0 || strcmp(magic, "P5") == 0;
+    const bool color = strcmp(magic, "P3") == 0 || strcmp(magic, "P6") == 0;
+    if (!gray && !color) {
+        std::cerr << "Error: Expected a PNM frame (P2, P3, P5 or P6), found '" << magic << "'" << std::endl;
+        return -1;
+    }
+
+    // Un frame de otro formato que el anterior necesita otra clase de imagen
+    if (frame && isColor(frame) != color) {
+        delete frame;
+        frame = nullptr;
+    }
+    if (!frame) {
+        frame = color ? static_cast<Imagen*>(new PPMImage()) : static_cast<Imagen*>(new PGMImage());
+    }
+
+    return frame->read(file, magic) ? 1 : -1;
+}
+
+static void* decodeStage(void* arg) {
+    StreamPipeline* pipeline = static_cast<StreamPipeline*>(arg);
+    Timer timer;
+
+    while (true) {
+        FrameSlot* slot = pipeline->free_slots.pop();
+        if (pipeline->stop) {
+            break;
+        }
+
+        slot->start_us = Timer::getTimestampMicroseconds();
+        timer.start();
+        int result;
+        {
+            PROFILE_ZONE("decode");
+            result = FrameStream::readFrame(pipeline->input, slot->input);
+        }
+        timer.stop();
+
+        if (result <= 0) {
+            pipeline->decode_error = result < 0;
+            break;
+        }
+        pipeline->decode_ms += timer.getElapsedMilliseconds();
+        pipeline->decoded.push(slot);
+    }
+
+    pipeline->decoded.push(nullptr);
+    return nullptr;
+}
+
+static void* encodeStage(void* arg) {
+    StreamPipeline* pipeline = static_cast<StreamPipeline*>(arg);
+    Timer timer;
+
+    while (FrameSlot* slot = pipeline->filtered.pop()) {
+        if (!pipeline->stop) {
+            timer.start();
+            bool written;
+            {
+                PROFILE_ZONE("encode");
+                // Sin filtro el frame sale tal como entró
+                Imagen* frame = pipeline->has_filter ? slot->output : slot->input;
+                written = frame->write(pipeline->output) && fflush(pipeline->output) == 0;
+            }
+            timer.stop();
+
+            if (written) {
+                pipeline->last_write_us = Timer::getTimestampMicroseconds();
+                pipeline->encode_ms += timer.getElapsedMilliseconds();
+                pipeline->latencies_ms.push_back((pipeline->last_write_us - slot->start_us) / 1000.0);
+            } else {
+                std::cerr << "Error: Cannot write frame " << pipeline->latencies_ms.size() << std::endl;
+                pipeline->encode_error = true;
+                pipeline->stop = true;
+            }
+        }
+        pipeline->free_slots.push(slot);
+    }
+    return nullptr;
+}
+
+bool FrameStream::run(FILE* input, FILE* output, const BackendFactory& create_backend, Backend*& backend,
+                      bool has_filter, Filter::FilterType filter_type, int iterations, int time_block,
+                      int depth, StreamStats& stats) {
+    StreamPipeline pipeline;
+    pipeline.input = input;
+    pipeline.output = output;
+    pipeline.has_filter = has_filter;
+
+    // Anillo de ranuras: un frame en cada etapa (y más si depth > 3 para absorber variaciones)
+    std::vector<FrameSlot> slots(std::max(1, depth));
+    for (size_t i = 0; i < slots.size(); i++) {
+        pipeline.free_slots.push(&slots[i]);
+    }
+
+    pthread_t decoder, encoder;
+    pthread_create(&decoder, nullptr, decodeStage, &pipeline);
+    pthread_create(&encoder, nullptr, encodeStage, &pipeline);
+
+    const long long start_us = Timer::getTimestampMicroseconds();
+    bool filter_error = false;
+    int frame_index = 0;
+    Timer timer;
+
+    // Etapa de filtrado en este hilo
+    while (FrameSlot* slot = pipeline.decoded.pop()) {
+        if (pipeline.stop || !has_filter) {
+            pipeline.filtered.push(slot);
+            continue;
+        }
+
+        if (frame_index == 0) {
+            backend = create_backend(slot->input);
+        }
+
+        // La salida de la ranura se reutiliza mientras el formato no cambie
+        if (slot->output && isColor(slot->output) != isColor(slot->input)) {
+            delete slot->output;
+            slot->output = nullptr;
+        }
+        if (!slot->output) {
+            slot->output = isColor(slot->input) ? static_cast<Imagen*>(new PPMImage())
+                                                : static_cast<Imagen*>(new PGMImage());
+        }
+
+        timer.start();
+        bool success = backend && backend->apply(slot->input, slot->output, filter_type, iterations, time_block);
+        timer.stop();
+        stats.filter_ms += timer.getElapsedMilliseconds();
+
+        if (!success) {
+            std::cerr << "Error: Cannot filter frame " << frame_index << std::endl;
+            filter_error = true;
+            pipeline.stop = true;
+        }
+        frame_index++;
+        pipeline.filtered.push(slot);
+    }
+
+    // El decodificador ya terminó (envió el nullptr); el codificador vacía lo pendiente
+    pipeline.filtered.push(nullptr);
+    pthread_join(encoder, nullptr);
+    pthread_join(decoder, nullptr);
+
+    // En MPI los demás procesos esperan otro frame: se les avisa del final
+    if (has_filter && backend && !filter_error) {
+        backend->cancel();
+    }
+
+    stats.frames = static_cast<int>(pipeline.latencies_ms.size());
+    stats.decode_ms = pipeline.decode_ms;
+    stats.encode_ms = pipeline.encode_ms;
+    stats.latencies_ms.swap(pipeline.latencies_ms);
+    stats.total_ms = pipeline.last_write_us > 0 ? (pipeline.last_write_us - start_us) / 1000.0 : 0.0;
+
+    for (size_t i = 0; i < slots.size(); i++) {
+        delete slots[i].input;
+        delete slots[i].output;
+    }
+
+    return !pipeline.decode_error && !filter_error && !pipeline.encode_error;
+}
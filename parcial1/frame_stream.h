@@ -0,0 +1,54 @@
+#ifndef FRAME_STREAM_H
+#define FRAME_STREAM_H
+
+#include <cstdio>
+#include <vector>
+#include <functional>
+#include "imagen.h"
+#include "filter.h"
+#include "backend.h"
+
+// Resultados de un flujo de frames
+struct StreamStats {
+    int frames;
+    double total_ms;                  // de la primera lectura a la última escritura
+    double decode_ms, filter_ms, encode_ms;  // tiempo total de cada etapa
+    std::vector<double> latencies_ms; // por frame: desde que empieza a leerse hasta que se escribe
+
+    StreamStats() : frames(0), total_ms(0.0), decode_ms(0.0), filter_ms(0.0), encode_ms(0.0) {}
+
+    double getFramesPerSecond() const { return total_ms > 0.0 ? frames / (total_ms / 1000.0) : 0.0; }
+
+    // Percentil (0-100) de la latencia por frame, por rango más cercano
+    double getLatencyPercentile(double p) const;
+};
+
+// Modo flujo: procesa frames PGM/PPM concatenados, como los que emiten las
+// herramientas netpbm o una cámara por una tubería. Tres etapas en tubería:
+// un hilo decodifica, el hilo que llama filtra con el backend y otro hilo
+// codifica, de modo que mientras se filtra el frame i se lee el i+1 y se
+// escribe el i-1. Los frames circulan por un anillo de 'depth' ranuras con
+// entrada y salida preasignadas: en régimen estable no se reserva memoria.
+class FrameStream {
+public:
+    // Crea el backend al ver el primer frame (auto elige según su tamaño)
+    typedef std::function<Backend*(const Imagen* first_frame)> BackendFactory;
+
+    static const int DEFAULT_DEPTH = 3;
+
+    // Lee el siguiente frame; crea 'frame' si es nullptr y lo reutiliza si no.
+    // Devuelve 1 si leyó un frame, 0 al final del flujo y -1 si hubo error.
+    static int readFrame(FILE* file, Imagen*& frame);
+
+    // Filtra todos los frames de 'input' y los escribe en 'output'. Sin filtro
+    // (has_filter = false) solo copia, útil para medir la E/S. Con el primer
+    // frame se llama a create_backend y el resultado queda en 'backend', que
+    // libera quien llama. El filtro se ejecuta en el hilo que llama (necesario
+    // para MPI) y al final se llama a backend->cancel() para liberar a los
+    // procesos MPI que esperan otro frame.
+    static bool run(FILE* input, FILE* output, const BackendFactory& create_backend, Backend*& backend,
+                    bool has_filter, Filter::FilterType filter_type, int iterations, int time_block,
+                    int depth, StreamStats& stats);
+};
+
+#endif
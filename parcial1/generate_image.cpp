@@ -0,0 +1,83 @@
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include "synthetic_image.h"
+#include "timer.h"
+
+void printUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " output_file [options]" << std::endl;
+    std::cout << "  output_file:  .pgm (grayscale) or .ppm (color)" << std::endl;
+    std::cout << "  --pattern p:  noise, gradient, checkerboard or natural (default: natural)" << std::endl;
+    std::cout << "  --size WxH:   Image size, up to " << SyntheticImage::MAX_DIMENSION << "x"
+              << SyntheticImage::MAX_DIMENSION << " (default: 1024x1024)" << std::endl;
+    std::cout << "  --seed N:     Seed for the noise patterns (default: 1)" << std::endl;
+    std::cout << "  --ascii:      Write P2/P3 instead of binary P5/P6" << std::endl;
+    std::cout << std::endl;
+    std::cout << "The processors also accept a synthetic input directly, without a file:" << std::endl;
+    std::cout << "  synth:pattern[:WxH][:pgm|ppm][:seed]   e.g. synth:natural:8192x8192:ppm" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    const char* output_filename = argv[1];
+    SyntheticImage::Spec spec;
+    bool binary = true;
+
+    std::string name(output_filename);
+    spec.channels = (name.size() >= 4 && name.compare(name.size() - 4, 4, ".ppm") == 0) ? 3 : 1;
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--ascii") == 0) {
+            binary = false;
+        } else if (i + 1 >= argc) {
+            printUsage(argv[0]);
+            return 1;
+        } else if (strcmp(argv[i], "--pattern") == 0) {
+            if (!SyntheticImage::stringToPattern(argv[++i], spec.pattern)) {
+                std::cerr << "Error: Unknown pattern '" << argv[i] << "'" << std::endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--size") == 0) {
+            if (sscanf(argv[++i], "%dx%d", &spec.width, &spec.height) != 2) {
+                std::cerr << "Error: Invalid size '" << argv[i] << "'" << std::endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            spec.seed = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 10));
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (spec.width <= 0 || spec.height <= 0 || spec.width > SyntheticImage::MAX_DIMENSION ||
+        spec.height > SyntheticImage::MAX_DIMENSION) {
+        std::cerr << "Error: Size must be between 1x1 and " << SyntheticImage::MAX_DIMENSION << "x"
+                  << SyntheticImage::MAX_DIMENSION << std::endl;
+        return 1;
+    }
+
+    std::cout << "Generating " << SyntheticImage::patternToString(spec.pattern) << " "
+              << (spec.channels == 3 ? "PPM" : "PGM") << " " << spec.width << "x" << spec.height
+              << (binary ? " (binary)" : " (ASCII)") << ", seed " << spec.seed << "..." << std::endl;
+
+    Timer timer;
+    timer.start();
+    bool success = SyntheticImage::write(spec, output_filename, binary);
+    timer.stop();
+
+    if (!success) {
+        return 1;
+    }
+
+    const double megapixels = static_cast<double>(spec.width) * spec.height / 1e6;
+    std::cout << "Saved " << output_filename << " in " << timer.getElapsedMilliseconds() << " ms ("
+              << megapixels / timer.getElapsedSeconds() << " MPix/s)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,25 @@
+#ifndef IMAGE_FACTORY_H
+#define IMAGE_FACTORY_H
+
+#include "imagen.h"
+
+// Creación de imágenes compartida por todos los programas: detecta el
+// formato por el magic number (o genera una imagen "synth:..."), crea la
+// salida del mismo formato y comprueba el presupuesto de memoria antes de
+// cargar.
+class ImageFactory {
+public:
+    // Carga un PGM/PPM o genera una imagen sintética; nullptr si falla
+    static Imagen* load(const char* source);
+
+    // Copia de la entrada con el mismo formato, lista para usar como salida
+    static Imagen* createOutput(Imagen* input);
+
+    // Tamaño de la entrada sin cargar los píxeles (archivo o "synth:...")
+    static bool readSize(const char* source, int& width, int& height, int& channels);
+
+    // Falla antes de cargar si 'buffers' rasters del tamaño de la entrada no caben en el presupuesto
+    static bool checkMemoryBudget(const char* source, int buffers);
+};
+
+#endif
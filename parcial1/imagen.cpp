@@ -1,8 +1,11 @@
 #include "imagen.h"
+#include "numa_memory.h"
 #include <cstdlib>
 #include <cstring>
+#include <vector>
+#include <cctype>
 
-Imagen::Imagen() : magic(nullptr), width(0), height(0), max_color(0), pixels(nullptr), pixel_count(0) {
+Imagen::Imagen() : magic(nullptr), width(0), height(0), max_color(0), pixels(nullptr), pixel_count(0), allocated_count(0), binary(false) {
     magic = new char[3];
 }
 
@@ -14,18 +17,26 @@ Imagen::~Imagen() {
 }
 
 void Imagen::allocatePixels() {
+    if (width > 0 && height > 0) {
+        pixel_count = width * height;
+    }
+    if (pixels && allocated_count == static_cast<size_t>(pixel_count)) {
+        return;
+    }
     if (pixels) {
         deallocatePixels();
     }
     if (pixel_count > 0) {
-        pixels = new int[pixel_count];
+        pixels = NumaMemory::allocate(pixel_count, height);
+        allocated_count = pixels ? pixel_count : 0;
     }
 }
 
 void Imagen::deallocatePixels() {
     if (pixels) {
-        delete[] pixels;
+        NumaMemory::release(pixels, allocated_count);
         pixels = nullptr;
+        allocated_count = 0;
     }
 }
 
@@ -35,4 +46,69 @@ bool Imagen::isValidCoordinate(int x, int y) const {
 
 int Imagen::getPixelIndex(int x, int y) const {
     return y * width + x;
-}
\ No newline at end of file
+}
+
+bool Imagen::readBinaryPixels(FILE* file) {
+    // Tras max_color viene un único carácter de espacio y luego los datos
+    fgetc(file);
+
+    const int sample_size = getBinarySampleSize(max_color);
+    std::vector<unsigned char>& buffer = raw_buffer;
+    buffer.resize(static_cast<size_t>(pixel_count) * sample_size);
+    if (fread(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+        return false;
+    }
+
+    for (int i = 0; i < pixel_count; i++) {
+        if (sample_size == 1) {
+            pixels[i] = buffer[i];
+        } else {
+            pixels[i] = (buffer[2 * i] << 8) | buffer[2 * i + 1];
+        }
+    }
+    return true;
+}
+
+bool Imagen::writeBinaryPixels(FILE* file) {
+    const int sample_size = getBinarySampleSize(max_color);
+    std::vector<unsigned char>& buffer = raw_buffer;
+    buffer.resize(static_cast<size_t>(pixel_count) * sample_size);
+
+    for (int i = 0; i < pixel_count; i++) {
+        if (sample_size == 1) {
+            buffer[i] = static_cast<unsigned char>(pixels[i]);
+        } else {
+            buffer[2 * i] = static_cast<unsigned char>(pixels[i] >> 8);
+            buffer[2 * i + 1] = static_cast<unsigned char>(pixels[i] & 0xFF);
+        }
+    }
+    return fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+}
+
+bool Imagen::readHeader(const char* filename, int& width, int& height, int& channels) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        return false;
+    }
+
+    char magic[3] = {0, 0, 0};
+    bool valid = fscanf(file, "%2s", magic) == 1 && magic[0] == 'P' &&
+                 (magic[1] == '2' || magic[1] == '3' || magic[1] == '5' || magic[1] == '6');
+    channels = (magic[1] == '3' || magic[1] == '6') ? 3 : 1;
+
+    // Ancho y alto, con espacios y comentarios entre medias
+    int* fields[2] = {&width, &height};
+    for (int f = 0; f < 2 && valid; f++) {
+        int c;
+        while ((c = fgetc(file)) != EOF && (isspace(c) || c == '#')) {
+            if (c == '#') {
+                while ((c = fgetc(file)) != '\n' && c != EOF);
+            }
+        }
+        ungetc(c, file);
+        valid = fscanf(file, "%d", fields[f]) == 1 && *fields[f] > 0;
+    }
+
+    fclose(file);
+    return valid;
+}
@@ -2,6 +2,9 @@
 #define IMAGEN_H
 
 #include <string>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
 
 class Imagen {
 protected:
@@ -11,6 +14,14 @@ protected:
     int max_color;
     int* pixels;
     int pixel_count;
+    size_t allocated_count; // enteros reservados en 'pixels' (para liberarlos)
+    bool binary;            // true = P5/P6 (raw), false = P2/P3 (ASCII)
+    std::vector<unsigned char> raw_buffer; // bytes raw de P5/P6, reutilizados entre frames
+
+    // Píxeles en formato raw: 1 byte por muestra si max_color < 256, si no 2 bytes big-endian
+    bool readBinaryPixels(FILE* file);
+    bool writeBinaryPixels(FILE* file);
+    void releaseRawBuffer() { std::vector<unsigned char>().swap(raw_buffer); }
 
 public:
     Imagen();
@@ -20,6 +31,13 @@ public:
     virtual bool load(const char* filename) = 0;
     virtual bool save(const char* filename) = 0;
     
+    // Leen o escriben un frame (header y píxeles) en un archivo ya abierto,
+    // p. ej. frames concatenados en una tubería. 'file_magic' es el magic
+    // number ya leído. Si el tamaño no cambia se reutilizan el raster y el
+    // buffer raw del frame anterior.
+    virtual bool read(FILE* file, const char* file_magic) = 0;
+    virtual bool write(FILE* file) = 0;
+    
     // Getters
     int getWidth() const { return width; }
     int getHeight() const { return height; }
@@ -27,17 +45,27 @@ public:
     int* getPixels() const { return pixels; }
     int getPixelCount() const { return pixel_count; }
     char* getMagic() const { return magic; }
+    bool isBinary() const { return binary; }
     
     // Setters
     void setWidth(int w) { width = w; }
     void setHeight(int h) { height = h; }
     void setMaxColor(int mc) { max_color = mc; }
+    void setBinary(bool b) { binary = b; }
     
     // Métodos utilitarios
+    // Reserva el raster; si ya hay uno del mismo tamaño se reutiliza
     virtual void allocatePixels();
     virtual void deallocatePixels();
     bool isValidCoordinate(int x, int y) const;
     int getPixelIndex(int x, int y) const;
+
+    // Lee solo el header de un archivo PGM/PPM (P2, P3, P5 o P6) para conocer
+    // su tamaño sin cargar los píxeles; channels es 1 (PGM) o 3 (PPM)
+    static bool readHeader(const char* filename, int& width, int& height, int& channels);
+
+    // Bytes por muestra en la codificación raw (P5/P6)
+    static int getBinarySampleSize(int max_color) { return max_color < 256 ? 1 : 2; }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include "incremental_filter.h"
+#include "image_factory.h"
+#include "profiler.h"
+#include <iostream>
+#include <algorithm>
+
+// Por debajo de este área repartir entre hilos cuesta más que el cálculo
+static const long long PARALLEL_MIN_PIXELS = 1 << 16;
+
+IncrementalFilter::IncrementalFilter(const std::vector<Filter::FilterType>& chain, ThreadPool* pool)
+    : chain(chain), pool(pool), width(0), height(0), pixel_count(0), last_pixels(0) {}
+
+IncrementalFilter::~IncrementalFilter() {
+    releaseStages();
+}
+
+void IncrementalFilter::releaseStages() {
+    for (size_t i = 0; i < stages.size(); i++) {
+        delete stages[i];
+    }
+    stages.clear();
+}
+
+bool IncrementalFilter::matches(const Imagen* image, int width, int height, int pixel_count) {
+    return image && image->getPixels() && image->getWidth() == width && image->getHeight() == height &&
+           image->getPixelCount() == pixel_count;
+}
+
+bool IncrementalFilter::initialize(Imagen* input, Imagen* output) {
+    PROFILE_ZONE("incremental_init");
+
+    if (chain.empty()) {
+        std::cerr << "Error: Empty filter chain" << std::endl;
+        return false;
+    }
+    if (!input || !output || !input->getPixels()) {
+        std::cerr << "Error: Input or output image is null" << std::endl;
+        return false;
+    }
+
+    releaseStages();
+    width = height = pixel_count = 0;
+
+    // Etapa k: de la salida de la k - 1 (o la entrada) a la suya (o 'output')
+    Imagen* source = input;
+    for (size_t k = 0; k < chain.size(); k++) {
+        Imagen* target = output;
+        if (k + 1 < chain.size()) {
+            target = ImageFactory::createOutput(input);
+            if (!target) {
+                std::cerr << "Error: Cannot create intermediate image for the filter chain" << std::endl;
+                releaseStages();
+                return false;
+            }
+            stages.push_back(target);
+        }
+        if (!Filter::applyFilter(source, target, chain[k])) {
+            releaseStages();
+            return false;
+        }
+        source = target;
+    }
+
+    width = input->getWidth();
+    height = input->getHeight();
+    pixel_count = input->getPixelCount();
+    last_region.clear();
+    last_pixels = 0;
+    return true;
+}
+
+bool IncrementalFilter::update(Imagen* input, Imagen* output, const std::vector<DirtyRect>& changed) {
+    PROFILE_ZONE("incremental_update");
+
+    if (pixel_count == 0) {
+        std::cerr << "Error: Incremental filter used before initialize" << std::endl;
+        return false;
+    }
+    if (!matches(input, width, height, pixel_count) || !matches(output, width, height, pixel_count)) {
+        std::cerr << "Error: Image size changed since initialize (" << width << "x" << height << ")" << std::endl;
+        return false;
+    }
+
+    last_region.clear();
+    last_pixels = 0;
+
+    // Cada etapa amplía la zona afectada en el radio del kernel
+    std::vector<DirtyRect> region;
+    Imagen* source = input;
+    for (size_t k = 0; k < chain.size(); k++) {
+        Imagen* target = (k + 1 < chain.size()) ? stages[k] : output;
+        expandRegion(changed, static_cast<int>(k + 1) * KERNEL_RADIUS, width, height, region);
+        last_pixels += recompute(source, target, chain[k], region, pool);
+        source = target;
+    }
+
+    last_region.swap(region);
+    return true;
+}
+
+bool IncrementalFilter::applyRegions(Imagen* input, Imagen* output, Filter::FilterType filter_type,
+                                     const std::vector<DirtyRect>& changed, ThreadPool* pool) {
+    if (!input || !input->getPixels() ||
+        !matches(output, input->getWidth(), input->getHeight(), input->getPixelCount())) {
+        std::cerr << "Error: The output must hold the previous result of the filter on this image" << std::endl;
+        return false;
+    }
+    if (!Filter::getKernel(filter_type)) {
+        std::cerr << "Error: Unknown filter type" << std::endl;
+        return false;
+    }
+
+    std::vector<DirtyRect> region;
+    expandRegion(changed, KERNEL_RADIUS, input->getWidth(), input->getHeight(), region);
+    recompute(input, output, filter_type, region, pool);
+    return true;
+}
+
+void IncrementalFilter::expandRegion(const std::vector<DirtyRect>& changed, int margin, int width, int height,
+                                     std::vector<DirtyRect>& region) {
+    region.clear();
+    for (size_t i = 0; i < changed.size(); i++) {
+        DirtyRect rect(std::max(0, changed[i].x0 - margin), std::max(0, changed[i].y0 - margin),
+                       std::min(width, changed[i].x1 + margin), std::min(height, changed[i].y1 + margin));
+        if (rect.getArea() > 0) {
+            region.push_back(rect);
+        }
+    }
+
+    // Fusionar dos rectángulos solo si su caja envolvente no cubre más que
+    // ambos por separado (uno contiene al otro, o se solapan alineados); si
+    // no, se dejan los dos y la parte común se calcula dos veces, con el
+    // mismo resultado
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t i = 0; i < region.size() && !merged; i++) {
+            for (size_t j = i + 1; j < region.size() && !merged; j++) {
+                const DirtyRect& a = region[i];
+                const DirtyRect& b = region[j];
+                DirtyRect box(std::min(a.x0, b.x0), std::min(a.y0, b.y0), std::max(a.x1, b.x1), std::max(a.y1, b.y1));
+                const bool touch = a.x0 <= b.x1 && b.x0 <= a.x1 && a.y0 <= b.y1 && b.y0 <= a.y1;
+                if (touch && box.getArea() <= a.getArea() + b.getArea()) {
+                    region[i] = box;
+                    region.erase(region.begin() + j);
+                    merged = true;
+                }
+            }
+        }
+    }
+}
+
+long long IncrementalFilter::recompute(Imagen* src, Imagen* dst, Filter::FilterType filter_type,
+                                       const std::vector<DirtyRect>& region, ThreadPool* pool) {
+    const float (*kernel)[3] = Filter::getKernel(filter_type);
+    const int width = src->getWidth();
+    const int height = src->getHeight();
+    const int channels = src->getPixelCount() / (width * height);
+    const int max_color = src->getMaxColor();
+    const int* src_pixels = src->getPixels();
+    int* dst_pixels = dst->getPixels();
+
+    // Ventanas sobre los rasters completos: se escribe directamente en la salida persistente
+    long long pixels = 0;
+    for (size_t i = 0; i < region.size(); i++) {
+        const DirtyRect& rect = region[i];
+        if (pool && pool->getNumThreads() > 1 && rect.getArea() >= PARALLEL_MIN_PIXELS) {
+            pool->parallelFor(rect.y0, rect.y1, [&](int begin, int end, int) {
+                Filter::convolveWindow(kernel, channels, max_color, width, height, src_pixels, 0, 0, width,
+                                       dst_pixels, 0, 0, width, rect.x0, begin, rect.x1, end);
+            });
+        } else {
+            Filter::convolveWindow(kernel, channels, max_color, width, height, src_pixels, 0, 0, width,
+                                   dst_pixels, 0, 0, width, rect.x0, rect.y0, rect.x1, rect.y1);
+        }
+        pixels += rect.getArea();
+    }
+    return pixels;
+}
@@ -0,0 +1,81 @@
+#ifndef INCREMENTAL_FILTER_H
+#define INCREMENTAL_FILTER_H
+
+#include <vector>
+#include "imagen.h"
+#include "filter.h"
+#include "thread_pool.h"
+
+// Rectángulo [x0, x1) x [y0, y1) en píxeles
+struct DirtyRect {
+    int x0, y0, x1, y1;
+    DirtyRect(int left = 0, int top = 0, int right = 0, int bottom = 0)
+        : x0(left), y0(top), x1(right), y1(bottom) {}
+
+    long long getArea() const {
+        return (x1 > x0 && y1 > y0) ? static_cast<long long>(x1 - x0) * (y1 - y0) : 0;
+    }
+};
+
+// Recálculo incremental de una cadena de filtros 3x3 para retoques
+// interactivos: tras filtrar la imagen completa una vez, cada edición solo
+// recalcula la zona afectada de la salida. Un cambio en un rectángulo de la
+// entrada afecta a ese rectángulo crecido en el radio del kernel (1 píxel)
+// por cada filtro de la cadena, así que la etapa k se recalcula en los
+// rectángulos crecidos k + 1 píxeles. Las salidas intermedias de la cadena
+// se guardan entre ediciones y la salida final se actualiza en el lugar.
+//
+// El resultado es idéntico a volver a aplicar la cadena completa con
+// Filter::applyFilter sobre la entrada editada.
+class IncrementalFilter {
+public:
+    static const int KERNEL_RADIUS = 1;
+
+    // Con un pool, las zonas grandes se reparten por filas entre sus hilos
+    explicit IncrementalFilter(const std::vector<Filter::FilterType>& chain, ThreadPool* pool = nullptr);
+    ~IncrementalFilter();
+
+    // Aplica la cadena completa a 'input' y deja el resultado en 'output',
+    // que pasa a ser la salida persistente de las siguientes actualizaciones
+    bool initialize(Imagen* input, Imagen* output);
+
+    // 'input' (la misma imagen de initialize) ya tiene los cambios dentro de
+    // 'changed'; recalcula solo la zona afectada de 'output'
+    bool update(Imagen* input, Imagen* output, const std::vector<DirtyRect>& changed);
+
+    // Zona de la salida recalculada en la última actualización y píxeles
+    // recalculados sumando todas las etapas
+    const std::vector<DirtyRect>& getLastRegion() const { return last_region; }
+    long long getLastPixels() const { return last_pixels; }
+
+    int getChainLength() const { return static_cast<int>(chain.size()); }
+
+    // Un solo filtro, sin estado: 'output' debe tener el resultado del filtro
+    // sobre la entrada anterior a los cambios
+    static bool applyRegions(Imagen* input, Imagen* output, Filter::FilterType filter_type,
+                             const std::vector<DirtyRect>& changed, ThreadPool* pool = nullptr);
+
+    // Crece cada rectángulo 'margin' píxeles, lo recorta a la imagen y fusiona
+    // los que se solapan cuando la unión no añade trabajo
+    static void expandRegion(const std::vector<DirtyRect>& changed, int margin, int width, int height,
+                             std::vector<DirtyRect>& region);
+
+private:
+    std::vector<Filter::FilterType> chain;
+    std::vector<Imagen*> stages;        // salidas intermedias (chain.size() - 1)
+    ThreadPool* pool;
+    int width, height, pixel_count;
+    std::vector<DirtyRect> last_region;
+    long long last_pixels;
+
+    void releaseStages();
+    static bool matches(const Imagen* image, int width, int height, int pixel_count);
+    static long long recompute(Imagen* src, Imagen* dst, Filter::FilterType filter_type,
+                               const std::vector<DirtyRect>& region, ThreadPool* pool);
+
+    // No copiable
+    IncrementalFilter(const IncrementalFilter&);
+    IncrementalFilter& operator=(const IncrementalFilter&);
+};
+
+#endif
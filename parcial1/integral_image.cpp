@@ -0,0 +1,255 @@
+#include "integral_image.h"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+// Número de columnas que procesa cada hilo en la segunda pasada (8 líneas de caché)
+static const int COLUMN_BLOCK = 64;
+
+IntegralImage::IntegralImage() : width(0), height(0), channels(0), sums(nullptr), squared_sums(nullptr) {
+}
+
+IntegralImage::~IntegralImage() {
+    clear();
+}
+
+void IntegralImage::clear() {
+    delete[] sums;
+    delete[] squared_sums;
+    sums = nullptr;
+    squared_sums = nullptr;
+    width = 0;
+    height = 0;
+    channels = 0;
+}
+
+bool IntegralImage::build(const Imagen* image, bool with_squares) {
+    if (!image) {
+        return false;
+    }
+
+    if (strcmp(image->getMagic(), "P2") == 0) {
+        return build(dynamic_cast<const PGMImage*>(image), with_squares);
+    } else if (strcmp(image->getMagic(), "P3") == 0) {
+        return build(dynamic_cast<const PPMImage*>(image), with_squares);
+    }
+
+    std::cerr << "Error: Unsupported image format for integral image" << std::endl;
+    return false;
+}
+
+bool IntegralImage::build(const PGMImage* image, bool with_squares) {
+    if (!image) {
+        return false;
+    }
+    return buildFromPixels(image->getPixels(), image->getWidth(), image->getHeight(), 1, with_squares);
+}
+
+bool IntegralImage::build(const PPMImage* image, bool with_squares) {
+    if (!image) {
+        return false;
+    }
+    return buildFromPixels(image->getPixels(), image->getWidth(), image->getHeight(), 3, with_squares);
+}
+
+bool IntegralImage::buildFromPixels(const int* pixels, int w, int h, int c, bool with_squares) {
+    clear();
+    if (!pixels || w <= 0 || h <= 0) {
+        std::cerr << "Error: Cannot build integral image from empty image" << std::endl;
+        return false;
+    }
+
+    width = w;
+    height = h;
+    channels = c;
+
+    const size_t stride = static_cast<size_t>(width) + 1;
+    const size_t plane = stride * (static_cast<size_t>(height) + 1);
+    sums = new long long[plane * channels];
+    if (with_squares) {
+        squared_sums = new long long[plane * channels];
+    }
+
+    long long* sq = squared_sums;
+
+    // Primera pasada: suma prefija de cada fila (filas independientes)
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int y = -1; y < height; y++) {
+        for (int ch = 0; ch < channels; ch++) {
+            long long* row = sums + ch * plane + (y + 1) * stride;
+            long long* row_sq = sq ? sq + ch * plane + (y + 1) * stride : nullptr;
+
+            if (y < 0) {
+                // Fila de ceros
+                std::fill(row, row + stride, 0LL);
+                if (row_sq) std::fill(row_sq, row_sq + stride, 0LL);
+                continue;
+            }
+
+            const int* src = pixels + static_cast<size_t>(y) * width * channels + ch;
+            long long acc = 0;
+            long long acc_sq = 0;
+            row[0] = 0;
+            if (row_sq) row_sq[0] = 0;
+
+            for (int x = 0; x < width; x++) {
+                long long value = src[static_cast<size_t>(x) * channels];
+                acc += value;
+                row[x + 1] = acc;
+                if (row_sq) {
+                    acc_sq += value * value;
+                    row_sq[x + 1] = acc_sq;
+                }
+            }
+        }
+    }
+
+    // Segunda pasada: acumular en vertical, repartiendo bloques de columnas
+    const int num_blocks = (static_cast<int>(stride) + COLUMN_BLOCK - 1) / COLUMN_BLOCK;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int task = 0; task < num_blocks * channels; task++) {
+        int ch = task / num_blocks;
+        size_t x_begin = static_cast<size_t>(task % num_blocks) * COLUMN_BLOCK;
+        size_t x_end = std::min(stride, x_begin + COLUMN_BLOCK);
+
+        long long* base = sums + ch * plane;
+        long long* base_sq = sq ? sq + ch * plane : nullptr;
+
+        for (int y = 2; y <= height; y++) {
+            long long* row = base + y * stride;
+            const long long* prev = row - stride;
+            for (size_t x = x_begin; x < x_end; x++) {
+                row[x] += prev[x];
+            }
+            if (base_sq) {
+                long long* row_sq = base_sq + y * stride;
+                const long long* prev_sq = row_sq - stride;
+                for (size_t x = x_begin; x < x_end; x++) {
+                    row_sq[x] += prev_sq[x];
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+bool IntegralImage::clipWindow(int& x0, int& y0, int& x1, int& y1) const {
+    if (x0 > x1) std::swap(x0, x1);
+    if (y0 > y1) std::swap(y0, y1);
+
+    x0 = std::max(0, x0);
+    y0 = std::max(0, y0);
+    x1 = std::min(width - 1, x1);
+    y1 = std::min(height - 1, y1);
+
+    return x0 <= x1 && y0 <= y1;
+}
+
+long long IntegralImage::lookup(const long long* table, int x0, int y0, int x1, int y1, int channel) const {
+    if (!table || channel < 0 || channel >= channels || !clipWindow(x0, y0, x1, y1)) {
+        return 0;
+    }
+
+    const size_t stride = static_cast<size_t>(width) + 1;
+    const long long* plane = table + channel * stride * (static_cast<size_t>(height) + 1);
+
+    // S(x1+1, y1+1) - S(x0, y1+1) - S(x1+1, y0) + S(x0, y0)
+    return plane[(y1 + 1) * stride + (x1 + 1)]
+         - plane[(y1 + 1) * stride + x0]
+         - plane[y0 * stride + (x1 + 1)]
+         + plane[y0 * stride + x0];
+}
+
+long long IntegralImage::getWindowSum(int x0, int y0, int x1, int y1, int channel) const {
+    return lookup(sums, x0, y0, x1, y1, channel);
+}
+
+long long IntegralImage::getWindowSquaredSum(int x0, int y0, int x1, int y1, int channel) const {
+    if (!squared_sums) {
+        std::cerr << "Error: Integral image was built without squared sums" << std::endl;
+        return 0;
+    }
+    return lookup(squared_sums, x0, y0, x1, y1, channel);
+}
+
+int IntegralImage::getWindowArea(int x0, int y0, int x1, int y1) const {
+    if (!clipWindow(x0, y0, x1, y1)) {
+        return 0;
+    }
+    return (x1 - x0 + 1) * (y1 - y0 + 1);
+}
+
+double IntegralImage::getLocalMean(int x, int y, int radius, int channel) const {
+    int area = getWindowArea(x - radius, y - radius, x + radius, y + radius);
+    if (area == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(getWindowSum(x - radius, y - radius, x + radius, y + radius, channel)) / area;
+}
+
+double IntegralImage::getLocalVariance(int x, int y, int radius, int channel) const {
+    int area = getWindowArea(x - radius, y - radius, x + radius, y + radius);
+    if (area == 0 || !squared_sums) {
+        return 0.0;
+    }
+
+    double mean = static_cast<double>(getWindowSum(x - radius, y - radius, x + radius, y + radius, channel)) / area;
+    double mean_sq = static_cast<double>(getWindowSquaredSum(x - radius, y - radius, x + radius, y + radius, channel)) / area;
+
+    // E[x^2] - E[x]^2, protegido contra valores negativos por redondeo
+    return std::max(0.0, mean_sq - mean * mean);
+}
+
+bool IntegralImage::applyBoxBlur(Imagen* input, Imagen* output, int radius) {
+    if (!input || !output) {
+        std::cerr << "Error: Input or output image is null" << std::endl;
+        return false;
+    }
+    if (radius < 0) {
+        std::cerr << "Error: Box blur radius must be non-negative" << std::endl;
+        return false;
+    }
+
+    IntegralImage integral;
+    if (!integral.build(input)) {
+        return false;
+    }
+
+    int width = input->getWidth();
+    int height = input->getHeight();
+    int max_color = input->getMaxColor();
+    int num_channels = integral.getChannels();
+
+    // Configurar la imagen de salida
+    output->setWidth(width);
+    output->setHeight(height);
+    output->setMaxColor(max_color);
+    output->allocatePixels();
+
+    int* out = output->getPixels();
+    if (!out) {
+        return false;
+    }
+    const long long kernel_area = static_cast<long long>(2 * radius + 1) * (2 * radius + 1);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            for (int ch = 0; ch < num_channels; ch++) {
+                long long sum = integral.getWindowSum(x - radius, y - radius, x + radius, y + radius, ch);
+                long long value = sum / kernel_area;
+                out[(static_cast<size_t>(y) * width + x) * num_channels + ch] =
+                    static_cast<int>(std::max(0LL, std::min(static_cast<long long>(max_color), value)));
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef INTEGRAL_IMAGE_H
+#define INTEGRAL_IMAGE_H
+
+#include "imagen.h"
+#include "PGMimage.h"
+#include "PPMimage.h"
+
+// Tabla de áreas sumadas (integral image). Cada canal se guarda en un plano
+// de (width + 1) x (height + 1) acumuladores de 64 bits, con la primera fila
+// y la primera columna en cero, de modo que la suma de cualquier ventana se
+// obtiene con cuatro lecturas.
+class IntegralImage {
+public:
+    IntegralImage();
+    ~IntegralImage();
+
+    // Construcción (PGM: 1 canal, PPM: 3 canales R, G, B)
+    bool build(const Imagen* image, bool with_squares = false);
+    bool build(const PGMImage* image, bool with_squares = false);
+    bool build(const PPMImage* image, bool with_squares = false);
+    void clear();
+
+    // Getters
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getChannels() const { return channels; }
+    bool hasSquares() const { return squared_sums != nullptr; }
+
+    // Consultas sobre la ventana [x0, x1] x [y0, y1] (inclusiva, recortada a la imagen)
+    long long getWindowSum(int x0, int y0, int x1, int y1, int channel = 0) const;
+    long long getWindowSquaredSum(int x0, int y0, int x1, int y1, int channel = 0) const;
+    int getWindowArea(int x0, int y0, int x1, int y1) const;
+
+    // Media y varianza locales en la ventana de radio 'radius' centrada en (x, y).
+    // Solo se cuentan los píxeles que caen dentro de la imagen.
+    double getLocalMean(int x, int y, int radius, int channel = 0) const;
+    double getLocalVariance(int x, int y, int radius, int channel = 0) const;
+
+    // Box blur de radio arbitrario. Usa el mismo borde que Filter::BLUR
+    // (relleno con ceros y división por (2r+1)^2), así que radius = 1
+    // equivale al blur 3x3 salvo redondeo.
+    static bool applyBoxBlur(Imagen* input, Imagen* output, int radius);
+
+private:
+    int width;
+    int height;
+    int channels;
+    long long* sums;
+    long long* squared_sums;
+
+    bool buildFromPixels(const int* pixels, int w, int h, int c, bool with_squares);
+    bool clipWindow(int& x0, int& y0, int& x1, int& y1) const;
+    long long lookup(const long long* table, int x0, int y0, int x1, int y1, int channel) const;
+
+    // No copiable
+    IntegralImage(const IntegralImage&);
+    IntegralImage& operator=(const IntegralImage&);
+};
+
+#endif
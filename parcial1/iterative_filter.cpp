@@ -0,0 +1,154 @@
+#include "iterative_filter.h"
+#include "numa_memory.h"
+#include "result_cache.h"
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+// Buffers locales de cada hilo (entrada y salida del tile con su halo).
+// Se reutilizan entre tiles y pasadas para no reservar memoria en el bucle.
+static thread_local std::vector<int> tile_front;
+static thread_local std::vector<int> tile_back;
+
+void IterativeFilter::runSequential(int count, const TileTask& tile) {
+    for (int i = 0; i < count; i++) {
+        tile(i);
+    }
+}
+
+void IterativeFilter::processTile(const Pass& pass, int x0, int y0, int x1, int y1) {
+    const int W = pass.width;
+    const int H = pass.height;
+    const int C = pass.channels;
+
+    // Región local: el tile más un halo de 'steps' píxeles, recortado a la imagen
+    const int ox = std::max(0, x0 - pass.steps);
+    const int oy = std::max(0, y0 - pass.steps);
+    const int lw = std::min(W, x1 + pass.steps) - ox;
+    const int lh = std::min(H, y1 + pass.steps) - oy;
+    const size_t local_size = static_cast<size_t>(lw) * lh * C;
+
+    if (tile_front.size() < local_size) {
+        tile_front.resize(local_size);
+        tile_back.resize(local_size);
+    }
+    int* current = tile_front.data();
+    int* next = tile_back.data();
+
+    // Copiar la región de entrada
+    for (int ly = 0; ly < lh; ly++) {
+        memcpy(current + static_cast<size_t>(ly) * lw * C,
+               pass.src + (static_cast<size_t>(oy + ly) * W + ox) * C,
+               static_cast<size_t>(lw) * C * sizeof(int));
+    }
+
+    // Zona válida en coordenadas locales [vx0, vx1) x [vy0, vy1)
+    int vx0 = 0, vy0 = 0, vx1 = lw, vy1 = lh;
+
+    for (int step = 0; step < pass.steps; step++) {
+        // Se encoge un píxel por lado, salvo donde coincide con el borde real
+        int nx0 = (ox + vx0 == 0) ? vx0 : vx0 + 1;
+        int ny0 = (oy + vy0 == 0) ? vy0 : vy0 + 1;
+        int nx1 = (ox + vx1 == W) ? vx1 : vx1 - 1;
+        int ny1 = (oy + vy1 == H) ? vy1 : vy1 - 1;
+
+        Filter::convolveWindow(pass.kernel, C, pass.max_color, W, H,
+                               current, ox, oy, lw, next, ox, oy, lw,
+                               ox + nx0, oy + ny0, ox + nx1, oy + ny1);
+
+        std::swap(current, next);
+        vx0 = nx0;
+        vy0 = ny0;
+        vx1 = nx1;
+        vy1 = ny1;
+    }
+
+    // Escribir solo el tile propio
+    for (int y = y0; y < y1; y++) {
+        memcpy(pass.dst + (static_cast<size_t>(y) * W + x0) * C,
+               current + (static_cast<size_t>(y - oy) * lw + (x0 - ox)) * C,
+               static_cast<size_t>(x1 - x0) * C * sizeof(int));
+    }
+}
+
+bool IterativeFilter::apply(Imagen* input, Imagen* output, Filter::FilterType filter_type, int iterations,
+                            const TileRunner& runner, int tile_width, int tile_height, int time_block) {
+    // El resultado no depende del reparto ni del bloqueo: la caché lo sirve para cualquier backend
+    return ResultCache::apply(input, output, filter_type, iterations, [&]() {
+        return applyPasses(input, output, filter_type, iterations, runner, tile_width, tile_height, time_block);
+    });
+}
+
+bool IterativeFilter::applyPasses(Imagen* input, Imagen* output, Filter::FilterType filter_type, int iterations,
+                                  const TileRunner& runner, int tile_width, int tile_height, int time_block) {
+    if (iterations < 1) {
+        std::cerr << "Error: Number of iterations must be at least 1" << std::endl;
+        return false;
+    }
+
+    const float (*kernel)[3] = Filter::getKernel(filter_type);
+    if (!kernel) {
+        std::cerr << "Error: Unknown filter type" << std::endl;
+        return false;
+    }
+
+    if (!Filter::prepareOutput(input, output)) {
+        return false;
+    }
+
+    const int width = input->getWidth();
+    const int height = input->getHeight();
+    const int count = input->getPixelCount();
+    if (count == 0) {
+        return true;
+    }
+
+    tile_width = tile_width > 0 ? tile_width : DEFAULT_TILE_WIDTH;
+    tile_height = tile_height > 0 ? tile_height : DEFAULT_TILE_HEIGHT;
+    time_block = time_block > 0 ? time_block : DEFAULT_TIME_BLOCK;
+
+    // Segundo buffer del ping-pong; la entrada no se modifica
+    int* scratch = NumaMemory::allocate(count, height);
+    if (!scratch) {
+        return false;
+    }
+
+    Pass pass;
+    pass.width = width;
+    pass.height = height;
+    pass.channels = count / (width * height);
+    pass.max_color = input->getMaxColor();
+    pass.kernel = kernel;
+
+    const int tiles_x = (width + tile_width - 1) / tile_width;
+    const int tiles_y = (height + tile_height - 1) / tile_height;
+
+    // Elegir el buffer de la primera pasada para que la última escriba en 'output'
+    const int num_passes = (iterations + time_block - 1) / time_block;
+    int* buffers[2] = {output->getPixels(), scratch};
+    int target = (num_passes % 2 == 1) ? 0 : 1;
+
+    const int* src = input->getPixels();
+    int remaining = iterations;
+
+    for (int p = 0; p < num_passes; p++) {
+        pass.src = src;
+        pass.dst = buffers[target];
+        pass.steps = std::min(time_block, remaining);
+
+        runner(tiles_x * tiles_y, [&](int index) {
+            int tx = index % tiles_x;
+            int ty = index / tiles_x;
+            processTile(pass, tx * tile_width, ty * tile_height,
+                        std::min(width, (tx + 1) * tile_width), std::min(height, (ty + 1) * tile_height));
+        });
+
+        remaining -= pass.steps;
+        src = buffers[target];
+        target = 1 - target;
+    }
+
+    NumaMemory::release(scratch, count);
+    return true;
+}
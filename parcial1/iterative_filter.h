@@ -0,0 +1,50 @@
+#ifndef ITERATIVE_FILTER_H
+#define ITERATIVE_FILTER_H
+
+#include <functional>
+#include "imagen.h"
+#include "filter.h"
+
+// Aplica el mismo filtro N veces seguidas (suavizado tipo difusión).
+// Usa dos buffers preasignados que se alternan (ping-pong) y bloqueo
+// temporal: cada tile se copia con un halo de T píxeles y se le aplican T
+// iteraciones seguidas mientras sigue en caché. En cada iteración la zona
+// válida se encoge un píxel por lado (trapecio), salvo en los bordes reales
+// de la imagen. El resultado es idéntico a llamar N veces a Filter::applyFilter.
+class IterativeFilter {
+public:
+    // Ejecuta tile(i) para i en [0, count). Cada backend decide cómo repartirlo;
+    // las llamadas son independientes y pueden ir en paralelo.
+    typedef std::function<void(int index)> TileTask;
+    typedef std::function<void(int count, const TileTask& tile)> TileRunner;
+
+    // Valores por defecto: la entrada y la salida locales de un tile PPM con
+    // su halo ocupan unos 300 KB
+    static const int DEFAULT_TILE_WIDTH = 128;
+    static const int DEFAULT_TILE_HEIGHT = 64;
+    static const int DEFAULT_TIME_BLOCK = 8;
+
+    // Recorre los tiles en el hilo actual
+    static void runSequential(int count, const TileTask& tile);
+
+    // time_block = iteraciones por pasada sobre la imagen (1 = ping-pong sin bloqueo temporal)
+    static bool apply(Imagen* input, Imagen* output, Filter::FilterType filter_type, int iterations,
+                      const TileRunner& runner = runSequential,
+                      int tile_width = DEFAULT_TILE_WIDTH, int tile_height = DEFAULT_TILE_HEIGHT,
+                      int time_block = DEFAULT_TIME_BLOCK);
+
+private:
+    struct Pass {
+        const int* src;
+        int* dst;
+        int width, height, channels, max_color;
+        const float (*kernel)[3];
+        int steps;
+    };
+
+    static bool applyPasses(Imagen* input, Imagen* output, Filter::FilterType filter_type, int iterations,
+                            const TileRunner& runner, int tile_width, int tile_height, int time_block);
+    static void processTile(const Pass& pass, int x0, int y0, int x1, int y1);
+};
+
+#endif
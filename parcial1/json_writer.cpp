@@ -0,0 +1,37 @@
+#include "json_writer.h"
+#include <ostream>
+#include <cstdlib>
+#include <cmath>
+#include <cstdio>
+
+void JsonWriter::writeString(std::ostream& out, const std::string& value) {
+    out << "\"";
+    for (size_t i = 0; i < value.size(); i++) {
+        const char c = value[i];
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (c == '\n') {
+            out << "\\n";
+        } else if (c == '\t') {
+            out << "\\t";
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+            out << escaped;
+        } else {
+            out << c;
+        }
+    }
+    out << "\"";
+}
+
+bool JsonWriter::isNumber(const std::string& value) {
+    if (value.empty() || value.find_first_not_of("0123456789+-.eE") != std::string::npos ||
+        !(value[0] == '-' || (value[0] >= '0' && value[0] <= '9')) ||
+        !(value[value.size() - 1] >= '0' && value[value.size() - 1] <= '9')) {
+        return false;
+    }
+    char* end = nullptr;
+    double number = strtod(value.c_str(), &end);
+    return end == value.c_str() + value.size() && std::isfinite(number);
+}
@@ -0,0 +1,19 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <string>
+#include <iosfwd>
+
+// Piezas para escribir JSON a mano (los resultados de los benchmarks son
+// objetos planos, una línea por ejecución)
+class JsonWriter {
+public:
+    // Cadena entre comillas, escapando comillas, barras y caracteres de control
+    static void writeString(std::ostream& out, const std::string& value);
+
+    // Número JSON: strtod lo consume entero, es finito y no usa formas que
+    // JSON no admite (hex, "inf", espacios, '+' inicial, ".5" o "5.")
+    static bool isNumber(const std::string& value);
+};
+
+#endif
@@ -0,0 +1,149 @@
+#include "memory_tracker.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+static std::atomic<size_t> current_bytes(0);
+static std::atomic<size_t> peak_bytes(0);
+static size_t budget_bytes = 0;
+
+MemoryTracker::MemoryTracker()
+    : start_bytes(0), end_bytes(0), phase_peak_bytes(0), phase_peak_rss(0), rss_is_phase_peak(false) {}
+
+bool MemoryTracker::reserve(size_t bytes) {
+    size_t now = current_bytes.fetch_add(bytes) + bytes;
+    if (budget_bytes > 0 && now > budget_bytes) {
+        current_bytes.fetch_sub(bytes);
+        std::cerr << "Error: Memory budget exceeded: a " << toMegabytes(bytes) << " MB image buffer does not fit ("
+                  << toMegabytes(now - bytes) << " MB already in use, budget " << toMegabytes(budget_bytes)
+                  << " MB)" << std::endl;
+        return false;
+    }
+
+    size_t peak = peak_bytes.load();
+    while (now > peak && !peak_bytes.compare_exchange_weak(peak, now)) {
+    }
+    return true;
+}
+
+void MemoryTracker::release(size_t bytes) {
+    current_bytes.fetch_sub(bytes);
+}
+
+size_t MemoryTracker::getCurrentBytes() {
+    return current_bytes.load();
+}
+
+size_t MemoryTracker::getPeakBytes() {
+    return peak_bytes.load();
+}
+
+void MemoryTracker::resetPeakBytes() {
+    peak_bytes.store(current_bytes.load());
+}
+
+void MemoryTracker::setBudget(size_t bytes) {
+    budget_bytes = bytes;
+}
+
+size_t MemoryTracker::getBudget() {
+    return budget_bytes;
+}
+
+bool MemoryTracker::fits(size_t bytes, const char* what) {
+    const size_t in_use = current_bytes.load();
+    if (budget_bytes == 0 || in_use + bytes <= budget_bytes) {
+        return true;
+    }
+    std::cerr << "Error: " << what << " need " << toMegabytes(bytes) << " MB but only "
+              << toMegabytes(budget_bytes > in_use ? budget_bytes - in_use : 0) << " MB of the "
+              << toMegabytes(budget_bytes) << " MB budget are free (--mem-budget)" << std::endl;
+    return false;
+}
+
+bool MemoryTracker::parseSize(const char* text, size_t& bytes) {
+    char* end = nullptr;
+    double value = strtod(text, &end);
+    if (end == text || value < 0) {
+        return false;
+    }
+
+    double multiplier = 1.0;
+    if (*end == 'K' || *end == 'k') {
+        multiplier = 1024.0;
+        end++;
+    } else if (*end == 'M' || *end == 'm') {
+        multiplier = 1024.0 * 1024.0;
+        end++;
+    } else if (*end == 'G' || *end == 'g') {
+        multiplier = 1024.0 * 1024.0 * 1024.0;
+        end++;
+    }
+    // Se admite "MB", "GiB"...
+    if (*end == 'i') {
+        end++;
+    }
+    if (*end == 'B' || *end == 'b') {
+        end++;
+    }
+    if (*end != '\0') {
+        return false;
+    }
+
+    bytes = static_cast<size_t>(value * multiplier);
+    return true;
+}
+
+// Lee un campo "Nombre:   1234 kB" de /proc/self/status
+static size_t readStatusField(const char* field) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    const size_t length = strlen(field);
+    while (std::getline(status, line)) {
+        if (line.compare(0, length, field) == 0) {
+            return static_cast<size_t>(strtoull(line.c_str() + length, nullptr, 10)) * 1024;
+        }
+    }
+    return 0;
+}
+
+size_t MemoryTracker::getResidentBytes() {
+    return readStatusField("VmRSS:");
+}
+
+size_t MemoryTracker::getPeakResidentBytes() {
+    return readStatusField("VmHWM:");
+}
+
+bool MemoryTracker::resetPeakResident() {
+    // Escribir 5 en clear_refs reinicia VmHWM al RSS actual (Linux >= 4.0)
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    if (!clear_refs) {
+        return false;
+    }
+    clear_refs << "5" << std::endl;
+    return static_cast<bool>(clear_refs);
+}
+
+void MemoryTracker::start() {
+    resetPeakBytes();
+    rss_is_phase_peak = resetPeakResident();
+    start_bytes = current_bytes.load();
+}
+
+void MemoryTracker::stop() {
+    end_bytes = current_bytes.load();
+    phase_peak_bytes = peak_bytes.load();
+    phase_peak_rss = getPeakResidentBytes();
+}
+
+void MemoryTracker::report(const char* label) const {
+    const double delta = toMegabytes(end_bytes) - toMegabytes(start_bytes);
+    std::cout << "  " << label << " memory: image buffers " << toMegabytes(end_bytes) << " MB (peak "
+              << toMegabytes(phase_peak_bytes) << " MB, " << (delta >= 0 ? "+" : "") << delta << " MB), "
+              << (rss_is_phase_peak ? "peak RSS " : "peak RSS since start ") << toMegabytes(phase_peak_rss)
+              << " MB" << std::endl;
+}
@@ -0,0 +1,65 @@
+#ifndef MEMORY_TRACKER_H
+#define MEMORY_TRACKER_H
+
+#include <cstddef>
+
+// Contabilidad de memoria. NumaMemory registra aquí cada buffer de píxeles
+// que reserva y libera (imágenes, clones, salidas de los filtros, buffers
+// temporales de las iteraciones), así se conoce cuánto ocupan los rasters
+// en cada momento y su pico. Además se lee el RSS del proceso de /proc.
+//
+// Con un presupuesto (setBudget) una reserva que lo superaría falla antes
+// de tocar la memoria con un mensaje que indica cuánto falta.
+//
+// Un objeto MemoryTracker mide una fase como PerfCounters: start/stop
+// alrededor del trabajo y report para imprimir el resultado junto al tiempo.
+class MemoryTracker {
+public:
+    MemoryTracker();
+
+    // Contabilidad global. reserve devuelve false (e imprime el motivo) si
+    // los bytes no caben en el presupuesto; en ese caso no se registran.
+    static bool reserve(size_t bytes);
+    static void release(size_t bytes);
+
+    static size_t getCurrentBytes();
+    static size_t getPeakBytes();
+
+    // 0 = sin límite
+    static void setBudget(size_t bytes);
+    static size_t getBudget();
+
+    // Comprueba de antemano si caben 'bytes' más; si no, explica qué no cabe
+    static bool fits(size_t bytes, const char* what);
+
+    // "512M", "2G", "1048576"... (sufijos K, M y G en potencias de 1024)
+    static bool parseSize(const char* text, size_t& bytes);
+
+    // RSS actual y pico del proceso (VmRSS / VmHWM); 0 si no hay /proc
+    static size_t getResidentBytes();
+    static size_t getPeakResidentBytes();
+
+    // Delimitan una fase: el pico de buffers y el de RSS se reinician en start
+    void start();
+    void stop();
+
+    size_t getPhasePeakBytes() const { return phase_peak_bytes; }
+    size_t getPhasePeakResidentBytes() const { return phase_peak_rss; }
+
+    // Imprime "  <label> memory: image buffers ... MB (peak ..., +/-...), peak RSS ... MB"
+    void report(const char* label) const;
+
+    static double toMegabytes(size_t bytes) { return bytes / (1024.0 * 1024.0); }
+
+private:
+    size_t start_bytes;
+    size_t end_bytes;
+    size_t phase_peak_bytes;
+    size_t phase_peak_rss;
+    bool rss_is_phase_peak;   // false si no se pudo reiniciar VmHWM: pico desde el inicio
+
+    static bool resetPeakResident();
+    static void resetPeakBytes();
+};
+
+#endif
@@ -0,0 +1,417 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <omp.h>
+#include "imagen.h"
+#include "PGMimage.h"
+#include "PPMimage.h"
+#include "filter.h"
+#include "synthetic_image.h"
+#include "thread_pool.h"
+#include "tile_scheduler.h"
+#include "numa_memory.h"
+#include "roofline.h"
+#include "timer.h"
+
+// Microbenchmark del núcleo de convolución. A diferencia de los procesadores,
+// la imagen y la salida se preparan una sola vez por tamaño y solo se mide el
+// recorrido del kernel (Filter::applyFilterRegion) con cada backend. Con
+// tamaños de 64x64 a 16Kx16K se ve en qué punto cada camino deja de caber en
+// caché y pasa a depender del ancho de banda de DRAM. Con --roofline se miden
+// además los techos de la máquina y cada caso se compara con lo alcanzable.
+
+struct MicroConfig {
+    std::vector<int> sizes;
+    std::vector<std::string> backends;
+    std::vector<std::string> formats;
+    std::vector<std::string> filters;
+    int num_threads;
+    int repetitions;
+    double min_sample_ms;  // sin --flush, cada muestra repite el kernel hasta durar esto
+    bool pin;
+    bool flush;
+    bool roofline;
+    size_t flush_bytes;
+    size_t max_bytes;      // los tamaños que no caben se saltan
+    const char* csv_file;
+    SyntheticImage::Pattern pattern;
+
+    MicroConfig() : num_threads(ThreadPool::getHardwareConcurrency()), repetitions(5), min_sample_ms(20.0),
+                    pin(false), flush(false), roofline(false), flush_bytes(static_cast<size_t>(64) << 20), max_bytes(0),
+                    csv_file(nullptr), pattern(SyntheticImage::NATURAL) {}
+};
+
+// Contexto de un backend: pool y planificador persistentes
+struct BackendContext {
+    ThreadPool* pool;
+    TileScheduler* scheduler;
+    int num_threads;
+    int block_width, block_height;
+};
+
+void printUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [options]" << std::endl;
+    std::cout << "  --sizes a,b:     Square image sizes (default: 64,128,...,16384)" << std::endl;
+    std::cout << "  --backends a,b:  sequential, blocked, pthread, tiles, omp (default: all)" << std::endl;
+    std::cout << "  --formats a,b:   pgm, ppm (default: both)" << std::endl;
+    std::cout << "  --filters a,b:   blur, laplace, sharpen (default: all)" << std::endl;
+    std::cout << "  --pattern p:     Synthetic content: noise, gradient, checkerboard, natural (default)" << std::endl;
+    std::cout << "  --t N:           Threads for the parallel backends (default: hardware concurrency)" << std::endl;
+    std::cout << "  --reps N:        Samples per case; the median is reported (default: 5)" << std::endl;
+    std::cout << "  --min-ms T:      Minimum duration of one sample without --flush (default: 20)" << std::endl;
+    std::cout << "  --pin:           Pin the main thread, pool threads and OpenMP threads to CPUs" << std::endl;
+    std::cout << "  --flush:         Evict the caches before every run (one run per sample)" << std::endl;
+    std::cout << "  --flush-mb N:    Size of the eviction buffer (default: 64)" << std::endl;
+    std::cout << "  --max-mb N:      Skip sizes whose input + output exceed N MB (default: half of RAM)" << std::endl;
+    std::cout << "  --roofline:      Measure bandwidth and FLOP ceilings and report each case against them" << std::endl;
+    std::cout << "  --csv file:      Also write the results as CSV" << std::endl;
+}
+
+std::vector<std::string> splitList(const char* text) {
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// Recorre un buffer mayor que la caché de último nivel para desalojar la imagen
+void flushCaches(std::vector<char>& buffer) {
+    static unsigned char value = 0;
+    value++;
+    for (size_t i = 0; i < buffer.size(); i += 64) {
+        buffer[i] = static_cast<char>(buffer[i] + value);
+    }
+}
+
+Imagen* createTestImage(bool color, int size, SyntheticImage::Pattern pattern) {
+    SyntheticImage::Spec spec;
+    spec.pattern = pattern;
+    spec.width = size;
+    spec.height = size;
+    spec.channels = color ? 3 : 1;
+    return SyntheticImage::create(spec);
+}
+
+// Una pasada del kernel sobre toda la imagen con el backend indicado
+bool runKernel(const std::string& backend, Imagen* input, Imagen* output, Filter::FilterType filter_type,
+               BackendContext& context) {
+    const int width = input->getWidth();
+    const int height = input->getHeight();
+
+    if (backend == "sequential") {
+        return Filter::applyFilterRegion(input, output, filter_type, 0, 0, width, height);
+    }
+    if (backend == "blocked") {
+        bool success = true;
+        for (int by = 0; by < height; by += context.block_height) {
+            for (int bx = 0; bx < width; bx += context.block_width) {
+                success = Filter::applyFilterRegion(input, output, filter_type, bx, by,
+                                                    std::min(width, bx + context.block_width),
+                                                    std::min(height, by + context.block_height)) && success;
+            }
+        }
+        return success;
+    }
+    // En los backends paralelos cualquier trozo que falle invalida la pasada
+    if (backend == "pthread") {
+        std::atomic<bool> success(true);
+        context.pool->parallelFor(0, height, [&](int start_row, int end_row, int) {
+            if (!Filter::applyFilterRegion(input, output, filter_type, 0, start_row, width, end_row)) {
+                success = false;
+            }
+        });
+        return success;
+    }
+    if (backend == "tiles") {
+        std::atomic<bool> success(true);
+        context.scheduler->run(width, height, [&](const Tile& tile, int) {
+            if (!Filter::applyFilterRegion(input, output, filter_type, tile.x0, tile.y0, tile.x1, tile.y1)) {
+                success = false;
+            }
+        });
+        return success;
+    }
+    if (backend == "omp") {
+        bool success = true;
+        #pragma omp parallel for schedule(static) num_threads(context.num_threads) reduction(&&:success)
+        for (int y = 0; y < height; y++) {
+            success = Filter::applyFilterRegion(input, output, filter_type, 0, y, width, y + 1) && success;
+        }
+        return success;
+    }
+    return false;
+}
+
+bool isKnownBackend(const std::string& backend) {
+    return backend == "sequential" || backend == "blocked" || backend == "pthread" || backend == "tiles" ||
+           backend == "omp";
+}
+
+// Mediana de los ms por pasada del kernel en 'ms'; false si alguna pasada falla
+bool measure(const MicroConfig& config, const std::string& backend, Imagen* input, Imagen* output,
+             Filter::FilterType filter_type, BackendContext& context, std::vector<char>& flush_buffer, double& ms) {
+    // Calentamiento: páginas tocadas y pool despierto
+    if (!runKernel(backend, input, output, filter_type, context)) {
+        return false;
+    }
+
+    std::vector<double> samples;
+    for (int rep = 0; rep < config.repetitions; rep++) {
+        if (config.flush) {
+            flushCaches(flush_buffer);
+        }
+
+        Timer timer;
+        int runs = 0;
+        timer.start();
+        do {
+            if (!runKernel(backend, input, output, filter_type, context)) {
+                return false;
+            }
+            runs++;
+        } while (!config.flush && timer.getCurrentElapsedMilliseconds() < config.min_sample_ms);
+        timer.stop();
+
+        samples.push_back(timer.getElapsedMilliseconds() / runs);
+    }
+
+    std::sort(samples.begin(), samples.end());
+    ms = samples[samples.size() / 2];
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    MicroConfig config;
+    for (int size = 64; size <= 16384; size *= 2) {
+        config.sizes.push_back(size);
+    }
+    config.backends = splitList("sequential,blocked,pthread,tiles,omp");
+    config.formats = splitList("pgm,ppm");
+    config.filters = splitList("blur,laplace,sharpen");
+
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (pages > 0 && page_size > 0) {
+        config.max_bytes = static_cast<size_t>(pages) * page_size / 2;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--pin") == 0) {
+            config.pin = true;
+        } else if (strcmp(argv[i], "--flush") == 0) {
+            config.flush = true;
+        } else if (strcmp(argv[i], "--roofline") == 0) {
+            config.roofline = true;
+        } else if (i + 1 >= argc) {
+            printUsage(argv[0]);
+            return 1;
+        } else if (strcmp(argv[i], "--sizes") == 0) {
+            std::vector<std::string> sizes = splitList(argv[++i]);
+            config.sizes.clear();
+            for (size_t s = 0; s < sizes.size(); s++) {
+                config.sizes.push_back(std::max(1, atoi(sizes[s].c_str())));
+            }
+        } else if (strcmp(argv[i], "--backends") == 0) {
+            config.backends = splitList(argv[++i]);
+        } else if (strcmp(argv[i], "--formats") == 0) {
+            config.formats = splitList(argv[++i]);
+        } else if (strcmp(argv[i], "--filters") == 0) {
+            config.filters = splitList(argv[++i]);
+        } else if (strcmp(argv[i], "--t") == 0) {
+            config.num_threads = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--reps") == 0) {
+            config.repetitions = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--min-ms") == 0) {
+            config.min_sample_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--flush-mb") == 0) {
+            config.flush_bytes = static_cast<size_t>(std::max(1, atoi(argv[++i]))) << 20;
+        } else if (strcmp(argv[i], "--max-mb") == 0) {
+            config.max_bytes = static_cast<size_t>(std::max(1, atoi(argv[++i]))) << 20;
+        } else if (strcmp(argv[i], "--csv") == 0) {
+            config.csv_file = argv[++i];
+        } else if (strcmp(argv[i], "--pattern") == 0) {
+            i++;
+            if (!SyntheticImage::stringToPattern(argv[i], config.pattern)) {
+                std::cerr << "Error: Unknown pattern '" << argv[i] << "'" << std::endl;
+                return 1;
+            }
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Nombres mal escritos se rechazan antes de medir nada
+    for (size_t b = 0; b < config.backends.size(); b++) {
+        if (!isKnownBackend(config.backends[b])) {
+            std::cerr << "Error: Unknown backend '" << config.backends[b] << "'" << std::endl;
+            return 1;
+        }
+    }
+    for (size_t f = 0; f < config.formats.size(); f++) {
+        if (config.formats[f] != "pgm" && config.formats[f] != "ppm") {
+            std::cerr << "Error: Unknown format '" << config.formats[f] << "'" << std::endl;
+            return 1;
+        }
+    }
+    for (size_t k = 0; k < config.filters.size(); k++) {
+        Filter::FilterType filter_type;
+        if (!Filter::stringToFilterType(config.filters[k].c_str(), filter_type)) {
+            std::cerr << "Error: Unknown filter '" << config.filters[k] << "'" << std::endl;
+            return 1;
+        }
+    }
+
+    ThreadPool pool(config.num_threads);
+    TileScheduler scheduler(pool);
+    BackendContext context;
+    context.pool = &pool;
+    context.scheduler = &scheduler;
+    context.num_threads = config.num_threads;
+
+    if (config.pin) {
+        std::vector<int> cpus = NumaMemory::getAllowedCpus();
+        bool pinned = !cpus.empty() && NumaMemory::pinCurrentThread(cpus[0]) && NumaMemory::pinPoolThreads(pool);
+        // Los hilos de OpenMP persisten entre regiones: basta fijarlos una vez
+        #pragma omp parallel num_threads(config.num_threads) reduction(&&:pinned)
+        {
+            pinned = !cpus.empty() && NumaMemory::pinCurrentThread(cpus[omp_get_thread_num() % cpus.size()]) && pinned;
+        }
+        if (!pinned) {
+            std::cerr << "Warning: Could not pin all threads" << std::endl;
+        }
+    }
+
+    std::vector<char> flush_buffer(config.flush ? config.flush_bytes : 0, 0);
+
+    std::ofstream csv;
+    if (config.csv_file) {
+        csv.open(config.csv_file);
+        if (!csv) {
+            std::cerr << "Error: Cannot open " << config.csv_file << std::endl;
+            return 1;
+        }
+        csv << "backend,format,filter,width,height,threads,ns_per_pixel,mpix_s,gb_s,gflop_s,intensity";
+        csv << (config.roofline ? ",attainable_gflop_s,roofline_pct\n" : "\n");
+    }
+
+    std::cout << "=== Convolution Microbenchmark ===" << std::endl;
+    std::cout << "Threads: " << config.num_threads << (config.pin ? " (pinned)" : "")
+              << ", samples: " << config.repetitions
+              << (config.flush ? ", caches flushed before each run" : ", warm caches")
+              << ", content: " << SyntheticImage::patternToString(config.pattern) << std::endl;
+
+    // Techos con un hilo (sequential, blocked) y con todo el pool
+    Roofline::Ceilings single_ceilings, pool_ceilings;
+    if (config.roofline) {
+        std::cout << "Measuring roofline ceilings..." << std::endl;
+        single_ceilings = Roofline::measure(nullptr);
+        Roofline::printCeilings(single_ceilings);
+        if (config.num_threads > 1) {
+            pool_ceilings = Roofline::measure(&pool);
+            Roofline::printCeilings(pool_ceilings);
+        } else {
+            pool_ceilings = single_ceilings;
+        }
+        std::cout << "Arithmetic intensity: " << Roofline::getArithmeticIntensity(1) << " flop/byte ("
+                  << Roofline::getFlopsPerPixel(1) << " flops, " << Roofline::getBytesPerPixel(1)
+                  << " bytes per sample)" << std::endl;
+        std::cout << std::endl;
+    }
+
+    std::cout << "backend\tformat\tfilter\tsize\tns/pixel\tMPix/s\tGB/s\tGFLOP/s"
+              << (config.roofline ? "\tattainable\t% roofline\tbound" : "") << std::endl;
+
+    for (size_t f = 0; f < config.formats.size(); f++) {
+        const bool color = config.formats[f] == "ppm";
+        const int channels = color ? 3 : 1;
+
+        for (size_t s = 0; s < config.sizes.size(); s++) {
+            const int size = config.sizes[s];
+            const size_t pixels = static_cast<size_t>(size) * size;
+            // Entrada y salida: un int por muestra
+            const size_t raster_bytes = pixels * channels * sizeof(int);
+            if (config.max_bytes > 0 && 2 * raster_bytes > config.max_bytes) {
+                std::cout << "Skipping " << config.formats[f] << " " << size << "x" << size << ": needs "
+                          << (2 * raster_bytes >> 20) << " MB" << std::endl;
+                continue;
+            }
+
+            Imagen* input = createTestImage(color, size, config.pattern);
+            Imagen* output = color ? static_cast<Imagen*>(new PPMImage()) : static_cast<Imagen*>(new PGMImage());
+            if (!input || !Filter::prepareOutput(input, output) || !output->getPixels()) {
+                std::cerr << "Error: Cannot allocate " << size << "x" << size << " image" << std::endl;
+                delete input;
+                delete output;
+                return 1;
+            }
+
+            TileScheduler::getDefaultTileSize(channels * static_cast<int>(sizeof(int)),
+                                              context.block_width, context.block_height);
+            scheduler.setTileSize(context.block_width, context.block_height);
+
+            for (size_t b = 0; b < config.backends.size(); b++) {
+                const std::string& backend = config.backends[b];
+                for (size_t k = 0; k < config.filters.size(); k++) {
+                    Filter::FilterType filter_type = Filter::stringToFilterType(config.filters[k].c_str());
+                    double ms = 0.0;
+                    if (!measure(config, backend, input, output, filter_type, context, flush_buffer, ms)) {
+                        std::cerr << "Error: " << backend << " failed on " << config.formats[f] << " " << size
+                                  << "x" << size << " (" << config.filters[k] << ")" << std::endl;
+                        delete input;
+                        delete output;
+                        return 1;
+                    }
+
+                    const double ns_per_pixel = ms * 1e6 / pixels;
+                    const double mpix_s = pixels / (ms * 1e3);
+                    // Tráfico mínimo: leer la entrada y escribir la salida una vez
+                    const double gb_s = 2.0 * raster_bytes / (ms * 1e6);
+                    const int threads = (backend == "sequential" || backend == "blocked") ? 1 : config.num_threads;
+                    const double intensity = Roofline::getArithmeticIntensity(channels);
+                    const double gflop_s = Roofline::getFlopsPerPixel(channels) * pixels / (ms * 1e6);
+
+                    std::cout << backend << "\t" << config.formats[f] << "\t" << config.filters[k] << "\t"
+                              << size << "x" << size << "\t" << ns_per_pixel << "\t" << mpix_s << "\t" << gb_s
+                              << "\t" << gflop_s;
+
+                    double attainable = 0.0;
+                    if (config.roofline) {
+                        const Roofline::Ceilings& ceilings = (threads == 1) ? single_ceilings : pool_ceilings;
+                        attainable = Roofline::getAttainableGflops(ceilings, intensity);
+                        std::cout << "\t" << attainable << "\t" << 100.0 * gflop_s / attainable << "\t"
+                                  << (intensity < ceilings.getRidgePoint() ? "memory" : "compute");
+                    }
+                    std::cout << std::endl;
+
+                    if (csv.is_open()) {
+                        csv << backend << "," << config.formats[f] << "," << config.filters[k] << "," << size
+                            << "," << size << "," << threads << "," << ns_per_pixel << "," << mpix_s << ","
+                            << gb_s << "," << gflop_s << "," << intensity;
+                        if (config.roofline) {
+                            csv << "," << attainable << "," << 100.0 * gflop_s / attainable;
+                        }
+                        csv << "\n";
+                    }
+                }
+            }
+
+            delete input;
+            delete output;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,235 @@
+#include "mpi_batch.h"
+#include "filter.h"
+#include "timer.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <sys/stat.h>
+
+// Etiquetas del protocolo maestro/trabajador
+static const int TAG_READY = 200;  // trabajador -> maestro: {tarea terminada o -1, éxito}
+static const int TAG_TASK = 201;   // maestro -> trabajador: índice de tarea o -1 para terminar
+
+bool MpiBatch::readTaskFile(const char* path, std::string& text) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Error: Cannot open task file " << path << std::endl;
+        return false;
+    }
+    std::ostringstream content;
+    content << file.rdbuf();
+    text = content.str();
+    return true;
+}
+
+bool MpiBatch::parseTasks(const std::string& text, const char* path, bool report, std::vector<BatchTask>& tasks) {
+    std::istringstream lines(text);
+    std::string line;
+    int line_number = 0;
+    bool valid = true;
+    while (std::getline(lines, line)) {
+        line_number++;
+        std::istringstream fields(line);
+        BatchTask task;
+        std::string extra;
+        if (!(fields >> task.input) || task.input[0] == '#') {
+            continue; // línea en blanco o comentario
+        }
+
+        // Una línea mal escrita se informa en vez de cambiar qué se procesa
+        Filter::FilterType filter_type;
+        const char* problem = nullptr;
+        if (!(fields >> task.output >> task.filter)) {
+            problem = "expected 'input output filter'";
+        } else if (fields >> extra) {
+            problem = "unexpected text after the filter";
+        } else if (!Filter::stringToFilterType(task.filter.c_str(), filter_type)) {
+            problem = "unknown filter (use blur, laplace or sharpen)";
+        }
+        if (problem) {
+            if (report) {
+                std::cerr << "Error: " << path << ":" << line_number << ": " << problem << std::endl;
+            }
+            valid = false;
+            continue;
+        }
+        tasks.push_back(task);
+    }
+    return valid;
+}
+
+std::vector<int> MpiBatch::largestFirst(const std::vector<BatchTask>& tasks) {
+    // Las tareas grandes primero evitan que una sola quede rezagada al final
+    std::vector<int> order(tasks.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = static_cast<int>(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return tasks[a].file_size > tasks[b].file_size;
+    });
+    return order;
+}
+
+bool MpiBatch::runTask(int rank, const BatchTask& task, const TaskFunction& process, double& busy_ms) {
+    Timer timer;
+    timer.start();
+    bool success = process(task);
+    timer.stop();
+
+    busy_ms += timer.getElapsedMilliseconds();
+    std::cout << "Process " << rank << ": " << task.input << " -> " << task.output << " (" << task.filter << ") "
+              << (success ? "done" : "FAILED") << " in " << timer.getElapsedMilliseconds() << " ms" << std::endl;
+    return success;
+}
+
+void MpiBatch::runMaster(MPI_Comm comm, const std::vector<BatchTask>& tasks, std::vector<int>& failed) {
+    int size;
+    MPI_Comm_size(comm, &size);
+
+    std::vector<int> order = largestFirst(tasks);
+
+    size_t next = 0;
+    int active_workers = size - 1;
+    while (active_workers > 0) {
+        int report[2];
+        MPI_Status status;
+        MPI_Recv(report, 2, MPI_INT, MPI_ANY_SOURCE, TAG_READY, comm, &status);
+        if (report[0] >= 0 && !report[1]) {
+            failed.push_back(report[0]);
+        }
+
+        int assignment = (next < order.size()) ? order[next++] : -1;
+        MPI_Send(&assignment, 1, MPI_INT, status.MPI_SOURCE, TAG_TASK, comm);
+        if (assignment < 0) {
+            active_workers--;
+        }
+    }
+}
+
+void MpiBatch::runWorker(MPI_Comm comm, const std::vector<BatchTask>& tasks, const TaskFunction& process,
+                         int& completed, double& busy_ms) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    int report[2] = {-1, 1};
+    while (true) {
+        MPI_Send(report, 2, MPI_INT, 0, TAG_READY, comm);
+
+        int assignment;
+        MPI_Recv(&assignment, 1, MPI_INT, 0, TAG_TASK, comm, MPI_STATUS_IGNORE);
+        if (assignment < 0) {
+            break;
+        }
+
+        bool success = runTask(rank, tasks[assignment], process, busy_ms);
+        completed++;
+
+        report[0] = assignment;
+        report[1] = success ? 1 : 0;
+    }
+}
+
+bool MpiBatch::run(MPI_Comm comm, const char* task_file, const TaskFunction& process) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    Timer wall_timer;
+    wall_timer.start();
+
+    // El rango 0 lee el archivo de tareas y lo difunde; cada rango lo interpreta
+    std::string text;
+    int header[2] = {0, 0}; // ok, longitud
+    if (rank == 0 && readTaskFile(task_file, text)) {
+        header[0] = 1;
+        header[1] = static_cast<int>(text.size());
+    }
+    MPI_Bcast(header, 2, MPI_INT, 0, comm);
+    if (!header[0]) {
+        return false;
+    }
+    text.resize(header[1]);
+    MPI_Bcast(&text[0], header[1], MPI_CHAR, 0, comm);
+
+    // Todos los rangos interpretan el mismo texto: la decisión es la misma en todos
+    std::vector<BatchTask> tasks;
+    if (!parseTasks(text, task_file, rank == 0, tasks)) {
+        return false;
+    }
+    if (tasks.empty()) {
+        if (rank == 0) {
+            std::cerr << "Error: No tasks in " << task_file << std::endl;
+        }
+        return false;
+    }
+
+    if (rank == 0) {
+        for (size_t i = 0; i < tasks.size(); i++) {
+            struct stat info;
+            tasks[i].file_size = (stat(tasks[i].input.c_str(), &info) == 0) ? info.st_size : 0;
+        }
+        std::cout << "Batch: " << tasks.size() << " tasks, " << (size > 1 ? size - 1 : 1)
+                  << " worker(s)" << std::endl;
+    }
+
+    int completed = 0;
+    double busy_ms = 0.0;
+    std::vector<int> failed;
+
+    if (size == 1) {
+        // Sin trabajadores: el rango 0 recorre la cola él mismo
+        std::vector<int> order = largestFirst(tasks);
+        for (size_t i = 0; i < order.size(); i++) {
+            if (!runTask(rank, tasks[order[i]], process, busy_ms)) {
+                failed.push_back(order[i]);
+            }
+            completed++;
+        }
+    } else if (rank == 0) {
+        runMaster(comm, tasks, failed);
+    } else {
+        runWorker(comm, tasks, process, completed, busy_ms);
+    }
+
+    wall_timer.stop();
+
+    // Utilización por rango: tareas, tiempo ocupado y tiempo total
+    double local_stats[3] = {static_cast<double>(completed), busy_ms, wall_timer.getElapsedMilliseconds()};
+    std::vector<double> all_stats(rank == 0 ? 3 * size : 0);
+    MPI_Gather(local_stats, 3, MPI_DOUBLE, rank == 0 ? all_stats.data() : nullptr, 3, MPI_DOUBLE, 0, comm);
+
+    if (rank == 0) {
+        // La utilización se mide sobre la duración total del lote, así el
+        // tiempo ocioso de un rango que terminó antes también cuenta
+        double makespan = 0.0;
+        for (int r = 0; r < size; r++) {
+            makespan = std::max(makespan, all_stats[3 * r + 2]);
+        }
+
+        std::cout << std::endl << "=== Batch Utilization ===" << std::endl;
+        std::cout << "Total time: " << makespan << " ms" << std::endl;
+        for (int r = 0; r < size; r++) {
+            double tasks_done = all_stats[3 * r];
+            double busy = all_stats[3 * r + 1];
+            std::cout << "Process " << r << ": ";
+            if (r == 0 && size > 1) {
+                std::cout << "master (dispatch only)" << std::endl;
+                continue;
+            }
+            std::cout << static_cast<int>(tasks_done) << " tasks, busy " << busy << " ms ("
+                      << (makespan > 0 ? 100.0 * busy / makespan : 0.0) << "%)" << std::endl;
+        }
+
+        if (!failed.empty()) {
+            std::cerr << failed.size() << " task(s) failed:" << std::endl;
+            for (size_t i = 0; i < failed.size(); i++) {
+                std::cerr << "  " << tasks[failed[i]].input << std::endl;
+            }
+        }
+    }
+
+    int all_ok = failed.empty() ? 1 : 0;
+    MPI_Bcast(&all_ok, 1, MPI_INT, 0, comm);
+    return all_ok != 0;
+}
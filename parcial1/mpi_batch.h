@@ -0,0 +1,44 @@
+#ifndef MPI_BATCH_H
+#define MPI_BATCH_H
+
+#include <mpi.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+// Una entrada del archivo de tareas: "entrada salida filtro" (blur, laplace o sharpen)
+struct BatchTask {
+    std::string input;
+    std::string output;
+    std::string filter;
+    long long file_size;  // tamaño de la entrada en bytes (para ordenar)
+
+    BatchTask() : file_size(0) {}
+};
+
+// Modo lote maestro/trabajador: el rango 0 guarda la cola de tareas ordenada
+// de mayor a menor archivo y la reparte dinámicamente a los rangos libres,
+// que leen y escriben sus archivos por su cuenta. Con un solo proceso el
+// rango 0 ejecuta todas las tareas. Al final se informa la utilización de
+// cada rango (tiempo ocupado / tiempo total).
+class MpiBatch {
+public:
+    // Procesa una tarea completa; devuelve false si falló
+    typedef std::function<bool(const BatchTask& task)> TaskFunction;
+
+    // Colectiva: devuelve true en todos los rangos si todas las tareas terminaron
+    // bien. Si alguna línea del archivo no es válida no se ejecuta ninguna
+    static bool run(MPI_Comm comm, const char* task_file, const TaskFunction& process);
+
+private:
+    static bool readTaskFile(const char* path, std::string& text);
+    // false si alguna línea no es válida; con 'report' las informa con su número
+    static bool parseTasks(const std::string& text, const char* path, bool report, std::vector<BatchTask>& tasks);
+    static std::vector<int> largestFirst(const std::vector<BatchTask>& tasks);
+    static bool runTask(int rank, const BatchTask& task, const TaskFunction& process, double& busy_ms);
+    static void runMaster(MPI_Comm comm, const std::vector<BatchTask>& tasks, std::vector<int>& failed);
+    static void runWorker(MPI_Comm comm, const std::vector<BatchTask>& tasks, const TaskFunction& process,
+                          int& completed, double& busy_ms);
+};
+
+#endif
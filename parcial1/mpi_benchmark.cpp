@@ -0,0 +1,142 @@
+#include "mpi_benchmark.h"
+#include "json_writer.h"
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+
+MpiBenchmark::MpiBenchmark(MPI_Comm benchmark_comm) : comm(benchmark_comm), rank(0) {
+    MPI_Comm_rank(comm, &rank);
+    for (int p = 0; p < NUM_PHASES; p++) {
+        totals[p] = 0.0;
+        counts[p] = 0;
+    }
+}
+
+const char* MpiBenchmark::phaseToString(Phase phase) {
+    switch (phase) {
+        case LOAD: return "load";
+        case SCATTER: return "scatter";
+        case HALO: return "halo";
+        case COMPUTE: return "compute";
+        case GATHER: return "gather";
+        case SAVE: return "save";
+        default: return "unknown";
+    }
+}
+
+void MpiBenchmark::begin(Phase phase) {
+    (void)phase;
+    // Sin la barrera, la fase incluiría lo que cada rango espera a los demás
+    MPI_Barrier(comm);
+    timer.start();
+}
+
+void MpiBenchmark::end(Phase phase) {
+    timer.stop();
+    totals[phase] += timer.getElapsedMilliseconds();
+    counts[phase]++;
+}
+
+void MpiBenchmark::reduce() {
+    int size;
+    MPI_Comm_size(comm, &size);
+
+    double local[NUM_PHASES];
+    for (int p = 0; p < NUM_PHASES; p++) {
+        local[p] = counts[p] > 0 ? totals[p] / counts[p] : 0.0;
+    }
+
+    double min[NUM_PHASES], max[NUM_PHASES], sum[NUM_PHASES];
+    MPI_Reduce(local, min, NUM_PHASES, MPI_DOUBLE, MPI_MIN, 0, comm);
+    MPI_Reduce(local, max, NUM_PHASES, MPI_DOUBLE, MPI_MAX, 0, comm);
+    MPI_Reduce(local, sum, NUM_PHASES, MPI_DOUBLE, MPI_SUM, 0, comm);
+
+    if (rank == 0) {
+        for (int p = 0; p < NUM_PHASES; p++) {
+            summaries[p].min = min[p];
+            summaries[p].max = max[p];
+            summaries[p].mean = sum[p] / size;
+        }
+    }
+}
+
+void MpiBenchmark::print(const Labels& labels) const {
+    std::cout << std::endl << "=== MPI Benchmark ===" << std::endl;
+    for (size_t i = 0; i < labels.size(); i++) {
+        std::cout << labels[i].first << ": " << labels[i].second << std::endl;
+    }
+    std::cout << "Phase      min ms      max ms     mean ms" << std::endl;
+    for (int p = 0; p < NUM_PHASES; p++) {
+        const Summary& s = summaries[p];
+        std::cout << phaseToString(static_cast<Phase>(p)) << "\t" << s.min << "\t" << s.max << "\t" << s.mean
+                  << std::endl;
+    }
+}
+
+bool MpiBenchmark::appendCsv(const char* path, const Labels& labels) const {
+    // La cabecera solo se escribe si el archivo está vacío, así varias
+    // ejecuciones (una por número de rangos) acaban en la misma tabla
+    bool write_header = true;
+    {
+        std::ifstream existing(path);
+        write_header = !existing || existing.peek() == std::ifstream::traits_type::eof();
+    }
+
+    std::ofstream file(path, std::ios::app);
+    if (!file) {
+        std::cerr << "Error: Cannot open " << path << std::endl;
+        return false;
+    }
+
+    if (write_header) {
+        for (size_t i = 0; i < labels.size(); i++) {
+            file << labels[i].first << ",";
+        }
+        for (int p = 0; p < NUM_PHASES; p++) {
+            const char* name = phaseToString(static_cast<Phase>(p));
+            file << name << "_min_ms," << name << "_max_ms," << name << "_mean_ms"
+                 << (p + 1 < NUM_PHASES ? "," : "\n");
+        }
+    }
+
+    for (size_t i = 0; i < labels.size(); i++) {
+        file << labels[i].second << ",";
+    }
+    for (int p = 0; p < NUM_PHASES; p++) {
+        const Summary& s = summaries[p];
+        file << s.min << "," << s.max << "," << s.mean << (p + 1 < NUM_PHASES ? "," : "\n");
+    }
+    return static_cast<bool>(file);
+}
+
+bool MpiBenchmark::appendJson(const char* path, const Labels& labels) const {
+    // Un objeto por línea (JSON Lines)
+    std::ofstream file(path, std::ios::app);
+    if (!file) {
+        std::cerr << "Error: Cannot open " << path << std::endl;
+        return false;
+    }
+
+    file << "{";
+    for (size_t i = 0; i < labels.size(); i++) {
+        // Los valores numéricos van sin comillas
+        const std::string& value = labels[i].second;
+        JsonWriter::writeString(file, labels[i].first);
+        file << ": ";
+        if (JsonWriter::isNumber(value)) {
+            file << value;
+        } else {
+            JsonWriter::writeString(file, value);
+        }
+        file << ", ";
+    }
+    file << "\"phases\": {";
+    for (int p = 0; p < NUM_PHASES; p++) {
+        const Summary& s = summaries[p];
+        file << "\"" << phaseToString(static_cast<Phase>(p)) << "\": {\"min_ms\": " << s.min
+             << ", \"max_ms\": " << s.max << ", \"mean_ms\": " << s.mean << "}"
+             << (p + 1 < NUM_PHASES ? ", " : "");
+    }
+    file << "}}" << std::endl;
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,61 @@
+#ifndef MPI_BENCHMARK_H
+#define MPI_BENCHMARK_H
+
+#include <mpi.h>
+#include <string>
+#include <vector>
+#include <utility>
+#include "timer.h"
+
+// Medición de fases para estudios de escalado. Cada fase empieza con una
+// barrera para que todos los rangos arranquen juntos; cada rango promedia
+// sus repeticiones y al final se reducen al rango 0 el mínimo, el máximo y
+// la media entre rangos. El resultado se guarda como una fila CSV o un
+// objeto JSON por ejecución.
+class MpiBenchmark {
+public:
+    enum Phase {
+        LOAD,
+        SCATTER,
+        HALO,
+        COMPUTE,
+        GATHER,
+        SAVE,
+        NUM_PHASES
+    };
+
+    struct Summary {
+        double min, max, mean;  // ms, entre rangos
+        Summary() : min(0.0), max(0.0), mean(0.0) {}
+    };
+
+    // Pares (campo, valor) que describen la ejecución (rangos, imagen, ...)
+    typedef std::vector<std::pair<std::string, std::string> > Labels;
+
+    explicit MpiBenchmark(MPI_Comm comm);
+
+    // Colectivas: begin sincroniza con una barrera y arranca el cronómetro
+    void begin(Phase phase);
+    void end(Phase phase);
+
+    // Colectiva: calcula los resúmenes (válidos en el rango 0)
+    void reduce();
+
+    const Summary& getSummary(Phase phase) const { return summaries[phase]; }
+    static const char* phaseToString(Phase phase);
+
+    // Solo en el rango 0
+    void print(const Labels& labels) const;
+    bool appendCsv(const char* path, const Labels& labels) const;
+    bool appendJson(const char* path, const Labels& labels) const;
+
+private:
+    MPI_Comm comm;
+    int rank;
+    Timer timer;
+    double totals[NUM_PHASES];
+    int counts[NUM_PHASES];
+    Summary summaries[NUM_PHASES];
+};
+
+#endif
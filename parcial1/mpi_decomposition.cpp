@@ -0,0 +1,498 @@
+#include "mpi_decomposition.h"
+#include "timer.h"
+#include "profiler.h"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Etiquetas de los mensajes punto a punto
+static const int TAG_SCATTER = 100;
+static const int TAG_GATHER = 101;
+static const int TAG_HALO = 110; // + dirección del envío
+
+// Desplazamiento (fila, columna) de una dirección: las 8 celdas vecinas de
+// una malla 3x3 sin la central, en orden de lectura
+static void directionOffset(int direction, int& dy, int& dx) {
+    int cell = direction < 4 ? direction : direction + 1;
+    dy = cell / 3 - 1;
+    dx = cell % 3 - 1;
+}
+
+MpiDecomposition::MpiDecomposition(MPI_Comm comm, Layout grid_layout)
+    : cart_comm(MPI_COMM_NULL), layout(grid_layout), rank(0), size(1),
+      image_width(0), image_height(0), channels(1), max_color(0), column_type(MPI_DATATYPE_NULL) {
+    for (int d = 0; d < NUM_DIRECTIONS; d++) {
+        neighbors[d] = MPI_PROC_NULL;
+    }
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    dims[0] = size;
+    dims[1] = 1;
+
+    // El comunicador base se duplica para no mezclar mensajes con otros módulos
+    MPI_Comm_dup(comm, &cart_comm);
+}
+
+MpiDecomposition::~MpiDecomposition() {
+    // Si MPI ya se finalizó, el comunicador ya no existe
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+    if (finalized) {
+        return;
+    }
+    if (column_type != MPI_DATATYPE_NULL) {
+        MPI_Type_free(&column_type);
+    }
+    if (cart_comm != MPI_COMM_NULL) {
+        MPI_Comm_free(&cart_comm);
+    }
+}
+
+void MpiDecomposition::chooseGrid(int num_ranks, int width, int height, Layout grid_layout, int grid[2]) {
+    grid[0] = num_ranks;
+    grid[1] = 1;
+    if (grid_layout == LAYOUT_ROWS) {
+        return;
+    }
+
+    // Elegir la factorización que minimiza el volumen de halo por rango:
+    // 2 filas de width/px píxeles si hay vecinos verticales y 2 columnas de
+    // height/py píxeles si hay vecinos horizontales
+    double best_cost = -1.0;
+    for (int px = 1; px <= num_ranks; px++) {
+        if (num_ranks % px != 0) {
+            continue;
+        }
+        int py = num_ranks / px;
+        if (px > width || py > height) {
+            continue;
+        }
+        double cost = (py > 1 ? 2.0 * width / px : 0.0) + (px > 1 ? 2.0 * height / py : 0.0);
+        if (best_cost < 0 || cost < best_cost) {
+            best_cost = cost;
+            grid[0] = py;
+            grid[1] = px;
+        }
+    }
+}
+
+bool MpiDecomposition::setup(int width, int height, int num_channels, int max_value, LocalBlock& block) {
+    image_width = width;
+    image_height = height;
+    channels = num_channels;
+    max_color = max_value;
+
+    chooseGrid(size, width, height, layout, dims);
+    if (dims[0] > height || dims[1] > width) {
+        if (rank == 0) {
+            std::cerr << "Error: Cannot split a " << width << "x" << height << " image among "
+                      << size << " processes" << std::endl;
+        }
+        return false;
+    }
+
+    // Malla cartesiana sin periodicidad y sin reordenar rangos
+    MPI_Comm grid_comm;
+    int periods[2] = {0, 0};
+    MPI_Cart_create(cart_comm, 2, dims, periods, 0, &grid_comm);
+    MPI_Comm_free(&cart_comm);
+    cart_comm = grid_comm;
+
+    // Vecinos de las 8 direcciones (las esquinas también hacen falta para el 3x3)
+    int coords[2];
+    MPI_Cart_coords(cart_comm, rank, 2, coords);
+    for (int d = 0; d < NUM_DIRECTIONS; d++) {
+        int dy, dx;
+        directionOffset(d, dy, dx);
+        int neighbor_coords[2] = {coords[0] + dy, coords[1] + dx};
+        neighbors[d] = MPI_PROC_NULL;
+        if (neighbor_coords[0] >= 0 && neighbor_coords[0] < dims[0] &&
+            neighbor_coords[1] >= 0 && neighbor_coords[1] < dims[1]) {
+            MPI_Cart_rank(cart_comm, neighbor_coords, &neighbors[d]);
+        }
+    }
+
+    getBlockBounds(rank, block.x0, block.y0, block.width, block.height);
+    block.halo_up = (neighbors[UP] != MPI_PROC_NULL) ? 1 : 0;
+    block.halo_down = (neighbors[DOWN] != MPI_PROC_NULL) ? 1 : 0;
+    block.halo_left = (neighbors[LEFT] != MPI_PROC_NULL) ? 1 : 0;
+    block.halo_right = (neighbors[RIGHT] != MPI_PROC_NULL) ? 1 : 0;
+    block.padded_width = block.width + block.halo_left + block.halo_right;
+    block.padded_height = block.height + block.halo_up + block.halo_down;
+    block.data.assign(static_cast<size_t>(block.padded_width) * block.padded_height * channels, 0);
+    block.result.assign(static_cast<size_t>(block.width) * block.height * channels, 0);
+
+    if (column_type != MPI_DATATYPE_NULL) {
+        MPI_Type_free(&column_type);
+    }
+    MPI_Type_vector(block.height, channels, block.padded_width * channels, MPI_INT, &column_type);
+    MPI_Type_commit(&column_type);
+
+    return true;
+}
+
+void MpiDecomposition::getBlockBounds(int block_rank, int& x0, int& y0, int& width, int& height) const {
+    int cy = block_rank / dims[1];
+    int cx = block_rank % dims[1];
+
+    y0 = static_cast<int>(static_cast<long long>(cy) * image_height / dims[0]);
+    x0 = static_cast<int>(static_cast<long long>(cx) * image_width / dims[1]);
+    height = static_cast<int>(static_cast<long long>(cy + 1) * image_height / dims[0]) - y0;
+    width = static_cast<int>(static_cast<long long>(cx + 1) * image_width / dims[1]) - x0;
+}
+
+MPI_Datatype MpiDecomposition::createGlobalBlockType(int block_rank) const {
+    int x0, y0, width, height;
+    getBlockBounds(block_rank, x0, y0, width, height);
+
+    int sizes[2] = {image_height, image_width * channels};
+    int subsizes[2] = {height, width * channels};
+    int starts[2] = {y0, x0 * channels};
+
+    MPI_Datatype type;
+    MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C, MPI_INT, &type);
+    MPI_Type_commit(&type);
+    return type;
+}
+
+void MpiDecomposition::scatter(const int* global_pixels, LocalBlock& block) {
+    PROFILE_ZONE("scatter");
+
+    if (layout == LAYOUT_ROWS) {
+        // Bandas de filas contiguas: un solo MPI_Scatterv
+        std::vector<int> counts(size), displs(size);
+        for (int r = 0; r < size; r++) {
+            int x0, y0, width, height;
+            getBlockBounds(r, x0, y0, width, height);
+            counts[r] = width * height * channels;
+            displs[r] = y0 * image_width * channels;
+        }
+
+        int* recv = block.data.data() + static_cast<size_t>(block.halo_up) * block.padded_width * channels;
+        MPI_Scatterv(global_pixels, counts.data(), displs.data(), MPI_INT,
+                     recv, counts[rank], MPI_INT, 0, cart_comm);
+        return;
+    }
+
+    // Bloques 2D: el rango 0 envía un subarray a cada rango (incluido él mismo)
+    std::vector<MPI_Request> requests;
+    std::vector<MPI_Datatype> types;
+    if (rank == 0) {
+        for (int r = 0; r < size; r++) {
+            types.push_back(createGlobalBlockType(r));
+            MPI_Request request;
+            MPI_Isend(global_pixels, 1, types.back(), r, TAG_SCATTER, cart_comm, &request);
+            requests.push_back(request);
+        }
+    }
+
+    int sizes[2] = {block.padded_height, block.padded_width * channels};
+    int subsizes[2] = {block.height, block.width * channels};
+    int starts[2] = {block.halo_up, block.halo_left * channels};
+    MPI_Datatype local_type;
+    MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C, MPI_INT, &local_type);
+    MPI_Type_commit(&local_type);
+
+    MPI_Recv(block.data.data(), 1, local_type, 0, TAG_SCATTER, cart_comm, MPI_STATUS_IGNORE);
+    MPI_Type_free(&local_type);
+
+    if (!requests.empty()) {
+        MPI_Waitall(static_cast<int>(requests.size()), requests.data(), MPI_STATUSES_IGNORE);
+    }
+    for (size_t i = 0; i < types.size(); i++) {
+        MPI_Type_free(&types[i]);
+    }
+}
+
+void MpiDecomposition::getHaloRegion(const LocalBlock& block, int direction, bool send, int*& buffer,
+                                     int& count, MPI_Datatype& type) const {
+    int dy, dx;
+    directionOffset(direction, dy, dx);
+
+    // Al enviar se usan las filas/columnas propias junto a ese lado; al recibir, el halo
+    int row, col;
+    if (dy < 0) {
+        row = send ? block.halo_up : 0;
+    } else if (dy > 0) {
+        row = send ? block.halo_up + block.height - 1 : block.halo_up + block.height;
+    } else {
+        row = block.halo_up;
+    }
+    if (dx < 0) {
+        col = send ? block.halo_left : 0;
+    } else if (dx > 0) {
+        col = send ? block.halo_left + block.width - 1 : block.halo_left + block.width;
+    } else {
+        col = block.halo_left;
+    }
+
+    buffer = const_cast<int*>(block.data.data()) +
+             (static_cast<size_t>(row) * block.padded_width + col) * channels;
+
+    if (dy != 0 && dx == 0) {
+        count = block.width * channels;   // fila propia contigua
+        type = MPI_INT;
+    } else if (dy == 0) {
+        count = 1;                        // columna propia
+        type = column_type;
+    } else {
+        count = channels;                 // esquina: un píxel
+        type = MPI_INT;
+    }
+}
+
+void MpiDecomposition::startHaloExchange(LocalBlock& block) {
+    halo_requests.clear();
+
+    // Primero las recepciones, para que los envíos encuentren el buffer listo
+    for (int d = 0; d < NUM_DIRECTIONS; d++) {
+        if (neighbors[d] == MPI_PROC_NULL) {
+            continue;
+        }
+        int* buffer;
+        int count;
+        MPI_Datatype type;
+        getHaloRegion(block, d, false, buffer, count, type);
+
+        // El vecino de la dirección d envía con la etiqueta de la opuesta
+        MPI_Request request;
+        MPI_Irecv(buffer, count, type, neighbors[d], TAG_HALO + (NUM_DIRECTIONS - 1 - d), cart_comm, &request);
+        halo_requests.push_back(request);
+    }
+
+    for (int d = 0; d < NUM_DIRECTIONS; d++) {
+        if (neighbors[d] == MPI_PROC_NULL) {
+            continue;
+        }
+        int* buffer;
+        int count;
+        MPI_Datatype type;
+        getHaloRegion(block, d, true, buffer, count, type);
+
+        MPI_Request request;
+        MPI_Isend(buffer, count, type, neighbors[d], TAG_HALO + d, cart_comm, &request);
+        halo_requests.push_back(request);
+    }
+}
+
+bool MpiDecomposition::testHaloExchange() {
+    if (halo_requests.empty()) {
+        return true;
+    }
+    int done = 0;
+    MPI_Testall(static_cast<int>(halo_requests.size()), halo_requests.data(), &done, MPI_STATUSES_IGNORE);
+    if (done) {
+        halo_requests.clear();
+    }
+    return done != 0;
+}
+
+void MpiDecomposition::finishHaloExchange() {
+    if (!halo_requests.empty()) {
+        MPI_Waitall(static_cast<int>(halo_requests.size()), halo_requests.data(), MPI_STATUSES_IGNORE);
+        halo_requests.clear();
+    }
+}
+
+void MpiDecomposition::exchangeHalos(LocalBlock& block) {
+    PROFILE_ZONE("halo");
+
+    startHaloExchange(block);
+    finishHaloExchange();
+}
+
+void MpiDecomposition::commitResult(LocalBlock& block) const {
+    const size_t row_count = static_cast<size_t>(block.width) * channels;
+    for (int y = 0; y < block.height; y++) {
+        memcpy(block.data.data() + (static_cast<size_t>(y + block.halo_up) * block.padded_width + block.halo_left) * channels,
+               block.result.data() + y * row_count, row_count * sizeof(int));
+    }
+}
+
+void MpiDecomposition::convolve(LocalBlock& block, const float kernel[3][3], int x0, int y0, int x1, int y1) const {
+    Filter::convolveWindow(kernel, channels, max_color, image_width, image_height,
+                           block.data.data(), block.x0 - block.halo_left, block.y0 - block.halo_up, block.padded_width,
+                           block.result.data(), block.x0, block.y0, block.width,
+                           x0, y0, x1, y1);
+}
+
+bool MpiDecomposition::filter(LocalBlock& block, Filter::FilterType filter_type) const {
+    const float (*kernel)[3] = Filter::getKernel(filter_type);
+    if (!kernel) {
+        std::cerr << "Process " << rank << ": Unknown filter type" << std::endl;
+        return false;
+    }
+
+    // Sin comunicación de por medio: las filas se reparten entre los hilos
+    const int x1 = block.x0 + block.width;
+    const int y1 = block.y0 + block.height;
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+        PROFILE_ZONE("band");
+#ifdef _OPENMP
+        #pragma omp for schedule(static)
+#endif
+        for (int y = block.y0; y < y1; y++) {
+            convolve(block, kernel, block.x0, y, x1, y + 1);
+        }
+    }
+    return true;
+}
+
+bool MpiDecomposition::exchangeAndFilter(LocalBlock& block, Filter::FilterType filter_type, OverlapTiming& timing) {
+    const float (*kernel)[3] = Filter::getKernel(filter_type);
+    if (!kernel) {
+        std::cerr << "Process " << rank << ": Unknown filter type" << std::endl;
+        return false;
+    }
+
+    const int x0 = block.x0;
+    const int y0 = block.y0;
+    const int x1 = block.x0 + block.width;
+    const int y1 = block.y0 + block.height;
+
+    // Interior: píxeles cuyo vecindario 3x3 no toca el halo
+    const int ix0 = std::min(x1, x0 + block.halo_left);
+    const int iy0 = std::min(y1, y0 + block.halo_up);
+    const int ix1 = std::max(ix0, x1 - block.halo_right);
+    const int iy1 = std::max(iy0, y1 - block.halo_down);
+
+    // Bordes: filas superior/inferior completas y columnas laterales del interior
+    const int border[4][4] = {
+        {x0, y0, x1, iy0},
+        {x0, iy1, x1, y1},
+        {x0, iy0, ix0, iy1},
+        {ix1, iy0, x1, iy1}
+    };
+
+    Timer total_timer, comm_timer, wait_timer, interior_timer, boundary_timer;
+    bool comm_done = false;
+    total_timer.start();
+    interior_timer.start();
+
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+#ifdef _OPENMP
+        const bool main_thread = omp_get_thread_num() == 0;
+#else
+        const bool main_thread = true;
+#endif
+
+        // Solo el hilo principal habla con MPI; los demás empiezan con el interior
+#ifdef _OPENMP
+        #pragma omp master
+#endif
+        {
+            comm_timer.start();
+            startHaloExchange(block);
+        }
+
+        {
+            PROFILE_ZONE("interior");
+#ifdef _OPENMP
+            #pragma omp for schedule(dynamic, 4) nowait
+#endif
+            for (int y = iy0; y < iy1; y++) {
+                convolve(block, kernel, ix0, y, ix1, y + 1);
+
+                // Entre filas, el hilo principal hace progresar los mensajes y
+                // anota cuándo terminó la comunicación
+                if (main_thread && !comm_done && testHaloExchange()) {
+                    comm_timer.stop();
+                    comm_done = true;
+                }
+            }
+        }
+
+#ifdef _OPENMP
+        #pragma omp barrier
+        #pragma omp master
+#endif
+        {
+            interior_timer.stop();
+            if (!comm_done) {
+                PROFILE_ZONE("halo wait");
+                wait_timer.start();
+                finishHaloExchange();
+                wait_timer.stop();
+                comm_timer.stop();
+            }
+            boundary_timer.start();
+        }
+
+        // Los bordes necesitan el halo completo
+#ifdef _OPENMP
+        #pragma omp barrier
+        #pragma omp for schedule(static)
+#endif
+        for (int r = 0; r < 4; r++) {
+            if (border[r][0] < border[r][2] && border[r][1] < border[r][3]) {
+                PROFILE_ZONE("boundary");
+                convolve(block, kernel, border[r][0], border[r][1], border[r][2], border[r][3]);
+            }
+        }
+    }
+
+    boundary_timer.stop();
+    total_timer.stop();
+
+    timing.comm = comm_timer.getElapsedMilliseconds();
+    timing.exposed = wait_timer.getElapsedMilliseconds();
+    timing.hidden = std::max(0.0, timing.comm - timing.exposed);
+    timing.interior = interior_timer.getElapsedMilliseconds();
+    timing.boundary = boundary_timer.getElapsedMilliseconds();
+    timing.total = total_timer.getElapsedMilliseconds();
+    return true;
+}
+
+void MpiDecomposition::gather(const LocalBlock& block, int* global_pixels) {
+    PROFILE_ZONE("gather");
+
+    if (layout == LAYOUT_ROWS) {
+        std::vector<int> counts(size), displs(size);
+        for (int r = 0; r < size; r++) {
+            int x0, y0, width, height;
+            getBlockBounds(r, x0, y0, width, height);
+            counts[r] = width * height * channels;
+            displs[r] = y0 * image_width * channels;
+        }
+
+        MPI_Gatherv(block.result.data(), counts[rank], MPI_INT,
+                    global_pixels, counts.data(), displs.data(), MPI_INT, 0, cart_comm);
+        return;
+    }
+
+    // Bloques 2D: cada rango envía su resultado contiguo y el rango 0 lo
+    // coloca en la imagen global con un subarray
+    MPI_Request request;
+    MPI_Isend(block.result.data(), static_cast<int>(block.result.size()), MPI_INT, 0, TAG_GATHER,
+              cart_comm, &request);
+
+    if (rank == 0) {
+        for (int r = 0; r < size; r++) {
+            MPI_Datatype type = createGlobalBlockType(r);
+            MPI_Recv(global_pixels, 1, type, r, TAG_GATHER, cart_comm, MPI_STATUS_IGNORE);
+            MPI_Type_free(&type);
+        }
+    }
+
+    MPI_Wait(&request, MPI_STATUS_IGNORE);
+}
+
+MpiDecomposition::Layout MpiDecomposition::stringToLayout(const char* name) {
+    if (strcmp(name, "blocks") == 0) {
+        return LAYOUT_BLOCKS;
+    }
+    return LAYOUT_ROWS;
+}
+
+const char* MpiDecomposition::layoutToString(Layout grid_layout) {
+    return grid_layout == LAYOUT_BLOCKS ? "blocks" : "rows";
+}
@@ -0,0 +1,126 @@
+#ifndef MPI_DECOMPOSITION_H
+#define MPI_DECOMPOSITION_H
+
+#include <mpi.h>
+#include <vector>
+#include "filter.h"
+
+// Trozo de la imagen que procesa un rango. 'data' guarda la región propia
+// más una fila/columna de halo en cada lado donde hay un vecino (en los
+// bordes de la imagen no hace falta: la convolución los trata como ceros).
+struct LocalBlock {
+    int x0, y0;                  // esquina global de la región propia
+    int width, height;           // tamaño de la región propia
+    int halo_left, halo_right;   // 1 si hay vecino en ese lado, 0 si no
+    int halo_up, halo_down;
+    int padded_width;            // width + halo_left + halo_right
+    int padded_height;           // height + halo_up + halo_down
+    std::vector<int> data;       // entrada con halo
+    std::vector<int> result;     // salida, solo la región propia
+
+    LocalBlock() : x0(0), y0(0), width(0), height(0), halo_left(0), halo_right(0),
+                   halo_up(0), halo_down(0), padded_width(0), padded_height(0) {}
+};
+
+// Tiempos de un filtrado con solapamiento (ms, medidos en el rango local)
+struct OverlapTiming {
+    double comm;       // desde que se publican los mensajes hasta que llega el halo
+    double exposed;    // tiempo bloqueado en MPI_Waitall tras terminar el interior
+    double hidden;     // comunicación solapada con cálculo (comm - exposed)
+    double interior;   // interior, en paralelo con la comunicación
+    double boundary;   // bordes que dependen del halo
+    double total;
+
+    OverlapTiming() : comm(0.0), exposed(0.0), hidden(0.0), interior(0.0), boundary(0.0), total(0.0) {}
+
+    OverlapTiming& operator+=(const OverlapTiming& other) {
+        comm += other.comm;
+        exposed += other.exposed;
+        hidden += other.hidden;
+        interior += other.interior;
+        boundary += other.boundary;
+        total += other.total;
+        return *this;
+    }
+};
+
+// Descomposición de dominio para el backend MPI. Con LAYOUT_ROWS cada rango
+// recibe una banda de filas (MPI_Scatterv / MPI_Gatherv); con LAYOUT_BLOCKS
+// los rangos forman una malla cartesiana 2D elegida para minimizar el halo,
+// útil en imágenes muy anchas. Solo el rango 0 necesita la imagen completa.
+class MpiDecomposition {
+public:
+    enum Layout {
+        LAYOUT_ROWS,
+        LAYOUT_BLOCKS
+    };
+
+    MpiDecomposition(MPI_Comm comm, Layout layout);
+    ~MpiDecomposition();
+
+    // Colectiva: calcula el reparto de una imagen width x height y prepara 'block'
+    bool setup(int width, int height, int channels, int max_color, LocalBlock& block);
+
+    // Colectivas: 'global_pixels' solo se usa en el rango 0
+    void scatter(const int* global_pixels, LocalBlock& block);
+    void gather(const LocalBlock& block, int* global_pixels);
+
+    // Intercambio de halos no bloqueante con los 8 vecinos (filas, columnas y
+    // esquinas): start publica MPI_Irecv/MPI_Isend, test hace progresar y
+    // comprueba si llegaron, finish espera con MPI_Waitall
+    void startHaloExchange(LocalBlock& block);
+    bool testHaloExchange();
+    void finishHaloExchange();
+    void exchangeHalos(LocalBlock& block);
+
+    // Copia el resultado a la entrada para la siguiente iteración
+    void commitResult(LocalBlock& block) const;
+
+    // Filtra la región propia (requiere halos actualizados)
+    bool filter(LocalBlock& block, Filter::FilterType filter_type) const;
+
+    // Publica el intercambio de halos y filtra el interior, que no depende del
+    // halo, mientras los mensajes viajan; tras MPI_Waitall filtra los bordes.
+    // Con un equipo OpenMP solo el hilo maestro llama a MPI (MPI_THREAD_FUNNELED)
+    // y entre filas hace progresar la comunicación con MPI_Testall.
+    // Sin -fopenmp se ejecuta en un solo hilo con el mismo resultado.
+    bool exchangeAndFilter(LocalBlock& block, Filter::FilterType filter_type, OverlapTiming& timing);
+
+    int getRank() const { return rank; }
+    int getSize() const { return size; }
+    int getGridRows() const { return dims[0]; }
+    int getGridColumns() const { return dims[1]; }
+    Layout getLayout() const { return layout; }
+    MPI_Comm getComm() const { return cart_comm; }
+
+    static Layout stringToLayout(const char* name);
+    static const char* layoutToString(Layout layout);
+
+private:
+    // Vecinos en la malla; opuesto(d) = 7 - d
+    enum Direction {
+        UP_LEFT, UP, UP_RIGHT, LEFT, RIGHT, DOWN_LEFT, DOWN, DOWN_RIGHT, NUM_DIRECTIONS
+    };
+
+    MPI_Comm cart_comm;
+    Layout layout;
+    int rank, size;
+    int dims[2];               // [filas de rangos, columnas de rangos]
+    int image_width, image_height, channels, max_color;
+    int neighbors[NUM_DIRECTIONS];
+    MPI_Datatype column_type;             // una columna de la región propia con halo
+    std::vector<MPI_Request> halo_requests;
+
+    void getHaloRegion(const LocalBlock& block, int direction, bool send, int*& buffer,
+                       int& count, MPI_Datatype& type) const;
+    void convolve(LocalBlock& block, const float kernel[3][3], int x0, int y0, int x1, int y1) const;
+    void getBlockBounds(int block_rank, int& x0, int& y0, int& width, int& height) const;
+    MPI_Datatype createGlobalBlockType(int block_rank) const;
+    static void chooseGrid(int num_ranks, int width, int height, Layout layout, int grid[2]);
+
+    // No copiable
+    MpiDecomposition(const MpiDecomposition&);
+    MpiDecomposition& operator=(const MpiDecomposition&);
+};
+
+#endif
@@ -0,0 +1,271 @@
+#include "mpi_image_io.h"
+#include "imagen.h"
+#include "synthetic_image.h"
+#include "profiler.h"
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <vector>
+
+// Salta espacios y líneas de comentario del header
+static void skipSpaceAndComments(FILE* file) {
+    int c;
+    while ((c = fgetc(file)) != EOF) {
+        if (c == '#') {
+            while ((c = fgetc(file)) != '\n' && c != EOF);
+        } else if (!isspace(c)) {
+            ungetc(c, file);
+            return;
+        }
+    }
+}
+
+bool MpiImageIO::parseHeader(const char* filename, PnmHeader& header) {
+    // Imagen sintética: la genera el proceso 0 en memoria (sin posiciones fijas para MPI-IO)
+    if (SyntheticImage::isSpec(filename)) {
+        SyntheticImage::Spec spec;
+        if (!SyntheticImage::parseSpec(filename, spec)) {
+            return false;
+        }
+        header.channels = spec.channels;
+        header.width = spec.width;
+        header.height = spec.height;
+        header.max_color = 255;
+        header.binary = false;
+        header.data_offset = 0;
+        return true;
+    }
+
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        std::cerr << "Error: Cannot open file " << filename << std::endl;
+        return false;
+    }
+
+    char magic[3];
+    if (fscanf(file, "%2s", magic) != 1) {
+        std::cerr << "Error: Cannot read magic number from " << filename << std::endl;
+        fclose(file);
+        return false;
+    }
+
+    if (strcmp(magic, "P2") == 0 || strcmp(magic, "P5") == 0) {
+        header.channels = 1;
+    } else if (strcmp(magic, "P3") == 0 || strcmp(magic, "P6") == 0) {
+        header.channels = 3;
+    } else {
+        std::cerr << "Error: Unsupported image format. Only P2/P5 (PGM) and P3/P6 (PPM) are supported." << std::endl;
+        fclose(file);
+        return false;
+    }
+    header.binary = (magic[1] == '5' || magic[1] == '6');
+
+    skipSpaceAndComments(file);
+    if (fscanf(file, "%d", &header.width) != 1) {
+        fclose(file);
+        return false;
+    }
+    skipSpaceAndComments(file);
+    if (fscanf(file, "%d", &header.height) != 1) {
+        fclose(file);
+        return false;
+    }
+    skipSpaceAndComments(file);
+    if (fscanf(file, "%d", &header.max_color) != 1 || header.width <= 0 || header.height <= 0) {
+        std::cerr << "Error: Invalid header in " << filename << std::endl;
+        fclose(file);
+        return false;
+    }
+
+    // Tras max_color hay un único carácter de espacio y empiezan los píxeles
+    fgetc(file);
+    header.data_offset = static_cast<MPI_Offset>(ftell(file));
+    fclose(file);
+    return true;
+}
+
+bool MpiImageIO::readHeader(MPI_Comm comm, const char* filename, PnmHeader& header) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    // ok, canales, ancho, alto, max_color, binario
+    int fields[6] = {0, 0, 0, 0, 0, 0};
+    long long offset = 0;
+
+    if (rank == 0 && parseHeader(filename, header)) {
+        fields[0] = 1;
+        fields[1] = header.channels;
+        fields[2] = header.width;
+        fields[3] = header.height;
+        fields[4] = header.max_color;
+        fields[5] = header.binary ? 1 : 0;
+        offset = header.data_offset;
+    }
+
+    MPI_Bcast(fields, 6, MPI_INT, 0, comm);
+    MPI_Bcast(&offset, 1, MPI_LONG_LONG, 0, comm);
+
+    header.channels = fields[1];
+    header.width = fields[2];
+    header.height = fields[3];
+    header.max_color = fields[4];
+    header.binary = fields[5] != 0;
+    header.data_offset = static_cast<MPI_Offset>(offset);
+    return fields[0] != 0;
+}
+
+int MpiImageIO::formatHeader(const PnmHeader& header, char* text, int capacity) {
+    // Igual que PGMImage::save / PPMImage::save en modo binario
+    return snprintf(text, capacity, "%s\n%d %d\n%d\n", header.channels == 3 ? "P6" : "P5",
+                    header.width, header.height, header.max_color);
+}
+
+MPI_Offset MpiImageIO::setupRegion(MPI_File file, const PnmHeader& header, const LocalBlock& block,
+                                   MPI_Offset data_offset, MPI_Datatype& filetype) {
+    const int sample_size = Imagen::getBinarySampleSize(header.max_color);
+    const MPI_Offset row_bytes = static_cast<MPI_Offset>(header.width) * header.channels * sample_size;
+
+    filetype = MPI_DATATYPE_NULL;
+    if (block.width == header.width) {
+        // Banda de filas completas: región contigua, basta el desplazamiento
+        return data_offset + static_cast<MPI_Offset>(block.y0) * row_bytes;
+    }
+
+    // Bloque 2D: vista de subarray sobre el raster (en bytes)
+    int sizes[2] = {header.height, static_cast<int>(row_bytes)};
+    int subsizes[2] = {block.height, block.width * header.channels * sample_size};
+    int starts[2] = {block.y0, block.x0 * header.channels * sample_size};
+    MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C, MPI_BYTE, &filetype);
+    MPI_Type_commit(&filetype);
+    MPI_File_set_view(file, data_offset, MPI_BYTE, filetype, "native", MPI_INFO_NULL);
+    return 0;
+}
+
+bool MpiImageIO::allSucceeded(MPI_Comm comm, bool local_success) {
+    int local = local_success ? 1 : 0;
+    int all = 0;
+    MPI_Allreduce(&local, &all, 1, MPI_INT, MPI_MIN, comm);
+    return all != 0;
+}
+
+bool MpiImageIO::readBlock(MPI_Comm comm, const char* filename, const PnmHeader& header, LocalBlock& block) {
+    PROFILE_ZONE("mpi-io read");
+
+    if (!header.binary) {
+        std::cerr << "Error: MPI-IO requires a binary (P5/P6) image" << std::endl;
+        return false;
+    }
+
+    MPI_File file;
+    int rc = MPI_File_open(comm, const_cast<char*>(filename), MPI_MODE_RDONLY, MPI_INFO_NULL, &file);
+    if (!allSucceeded(comm, rc == MPI_SUCCESS)) {
+        if (rc == MPI_SUCCESS) {
+            MPI_File_close(&file);
+        }
+        return false;
+    }
+
+    const int sample_size = Imagen::getBinarySampleSize(header.max_color);
+    const int row_samples = block.width * header.channels;
+    std::vector<unsigned char> buffer(static_cast<size_t>(row_samples) * block.height * sample_size);
+
+    MPI_Datatype filetype;
+    MPI_Offset offset = setupRegion(file, header, block, header.data_offset, filetype);
+
+    MPI_Status status;
+    rc = MPI_File_read_at_all(file, offset, buffer.data(), static_cast<int>(buffer.size()), MPI_BYTE, &status);
+    int bytes_read = 0;
+    MPI_Get_count(&status, MPI_BYTE, &bytes_read);
+
+    MPI_File_close(&file);
+    if (filetype != MPI_DATATYPE_NULL) {
+        MPI_Type_free(&filetype);
+    }
+
+    bool success = (rc == MPI_SUCCESS && bytes_read == static_cast<int>(buffer.size()));
+    if (!success) {
+        std::cerr << "Error: Truncated pixel data in " << filename << std::endl;
+    }
+    if (!allSucceeded(comm, success)) {
+        return false;
+    }
+
+    // Decodificar a enteros dentro de la región propia del buffer con halo
+    for (int y = 0; y < block.height; y++) {
+        const unsigned char* src = buffer.data() + static_cast<size_t>(y) * row_samples * sample_size;
+        int* dst = block.data.data() +
+                   (static_cast<size_t>(y + block.halo_up) * block.padded_width + block.halo_left) * header.channels;
+        for (int i = 0; i < row_samples; i++) {
+            dst[i] = (sample_size == 1) ? src[i] : ((src[2 * i] << 8) | src[2 * i + 1]);
+        }
+    }
+
+    return true;
+}
+
+bool MpiImageIO::writeBlock(MPI_Comm comm, const char* filename, const PnmHeader& header, const LocalBlock& block) {
+    PROFILE_ZONE("mpi-io write");
+
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    char text[64];
+    int header_length = formatHeader(header, text, sizeof(text));
+
+    MPI_File file;
+    int rc = MPI_File_open(comm, const_cast<char*>(filename), MPI_MODE_CREATE | MPI_MODE_WRONLY,
+                           MPI_INFO_NULL, &file);
+    if (!allSucceeded(comm, rc == MPI_SUCCESS)) {
+        if (rank == 0) {
+            std::cerr << "Error: Cannot create file " << filename << std::endl;
+        }
+        if (rc == MPI_SUCCESS) {
+            MPI_File_close(&file);
+        }
+        return false;
+    }
+
+    // Descartar el contenido anterior si el archivo ya existía
+    MPI_File_set_size(file, 0);
+
+    const int sample_size = Imagen::getBinarySampleSize(header.max_color);
+    const int row_samples = block.width * header.channels;
+    std::vector<unsigned char> buffer(static_cast<size_t>(row_samples) * block.height * sample_size);
+
+    for (int y = 0; y < block.height; y++) {
+        const int* src = block.result.data() + static_cast<size_t>(y) * row_samples;
+        unsigned char* dst = buffer.data() + static_cast<size_t>(y) * row_samples * sample_size;
+        for (int i = 0; i < row_samples; i++) {
+            if (sample_size == 1) {
+                dst[i] = static_cast<unsigned char>(src[i]);
+            } else {
+                dst[2 * i] = static_cast<unsigned char>(src[i] >> 8);
+                dst[2 * i + 1] = static_cast<unsigned char>(src[i] & 0xFF);
+            }
+        }
+    }
+
+    bool success = true;
+    if (rank == 0) {
+        MPI_Status status;
+        success = MPI_File_write_at(file, 0, text, header_length, MPI_CHAR, &status) == MPI_SUCCESS;
+    }
+
+    MPI_Datatype filetype;
+    MPI_Offset offset = setupRegion(file, header, block, header_length, filetype);
+
+    MPI_Status status;
+    rc = MPI_File_write_at_all(file, offset, buffer.data(), static_cast<int>(buffer.size()), MPI_BYTE, &status);
+    success = success && rc == MPI_SUCCESS;
+
+    MPI_File_close(&file);
+    if (filetype != MPI_DATATYPE_NULL) {
+        MPI_Type_free(&filetype);
+    }
+
+    if (!success) {
+        std::cerr << "Error: Cannot write pixel data to " << filename << std::endl;
+    }
+    return allSucceeded(comm, success);
+}
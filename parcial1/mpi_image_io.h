@@ -0,0 +1,43 @@
+#ifndef MPI_IMAGE_IO_H
+#define MPI_IMAGE_IO_H
+
+#include <mpi.h>
+#include "mpi_decomposition.h"
+
+// Datos del header de un archivo PNM
+struct PnmHeader {
+    int channels;            // 1 = PGM, 3 = PPM
+    int width, height, max_color;
+    bool binary;             // P5/P6
+    MPI_Offset data_offset;  // bytes hasta el primer píxel
+
+    PnmHeader() : channels(0), width(0), height(0), max_color(0), binary(false), data_offset(0) {}
+};
+
+// Lectura y escritura colectivas con MPI-IO de imágenes PNM binarias (P5/P6).
+// Cada rango lee y escribe directamente su región del archivo: con bandas de
+// filas basta un desplazamiento (MPI_File_read_at_all / write_at_all); con
+// bloques 2D se define una vista de subarray sobre el raster. Así el rango 0
+// deja de ser el cuello de botella de E/S. Los formatos ASCII (P2/P3) no
+// tienen posiciones fijas y siguen el camino del rango 0.
+class MpiImageIO {
+public:
+    // Colectiva: el rango 0 lee el header y lo difunde a todos
+    static bool readHeader(MPI_Comm comm, const char* filename, PnmHeader& header);
+
+    // Colectivas: la región propia de 'block' (sin halo) se lee o escribe en el archivo
+    static bool readBlock(MPI_Comm comm, const char* filename, const PnmHeader& header, LocalBlock& block);
+    static bool writeBlock(MPI_Comm comm, const char* filename, const PnmHeader& header, const LocalBlock& block);
+
+private:
+    static bool parseHeader(const char* filename, PnmHeader& header);
+    static int formatHeader(const PnmHeader& header, char* text, int capacity);
+
+    // Prepara la vista o el desplazamiento de la región; devuelve el offset para *_at_all
+    static MPI_Offset setupRegion(MPI_File file, const PnmHeader& header, const LocalBlock& block,
+                                  MPI_Offset data_offset, MPI_Datatype& filetype);
+
+    static bool allSucceeded(MPI_Comm comm, bool local_success);
+};
+
+#endif
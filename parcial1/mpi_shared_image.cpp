@@ -0,0 +1,211 @@
+#include "mpi_shared_image.h"
+#include <iostream>
+#include <cstring>
+#include <vector>
+
+static const int TAG_NODE_HALO = 300;
+
+MpiSharedImage::MpiSharedImage(MPI_Comm base_comm, int group_size)
+    : comm(base_comm), node_comm(MPI_COMM_NULL), leader_comm(MPI_COMM_NULL),
+      input_win(MPI_WIN_NULL), output_win(MPI_WIN_NULL), input(nullptr), output(nullptr),
+      rank(0), node_rank(0), node_size(1), node_index(0), num_nodes(1),
+      width(0), height(0), channels(1), max_color(0),
+      node_y0(0), node_height(0), halo_up(0), halo_down(0), row_y0(0), row_y1(0),
+      leader_up(MPI_PROC_NULL), leader_down(MPI_PROC_NULL) {
+    MPI_Comm_rank(comm, &rank);
+
+    // Rangos que pueden compartir memoria (la clave mantiene el orden global,
+    // así el rango 0 es líder de su nodo y el primero entre los líderes)
+    MPI_Comm shared_comm;
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &shared_comm);
+    if (group_size > 0) {
+        int shared_rank;
+        MPI_Comm_rank(shared_comm, &shared_rank);
+        MPI_Comm_split(shared_comm, shared_rank / group_size, shared_rank, &node_comm);
+        MPI_Comm_free(&shared_comm);
+    } else {
+        node_comm = shared_comm;
+    }
+    MPI_Comm_rank(node_comm, &node_rank);
+    MPI_Comm_size(node_comm, &node_size);
+
+    // Comunicador de líderes: un rango por nodo
+    MPI_Comm_split(comm, node_rank == 0 ? 0 : MPI_UNDEFINED, rank, &leader_comm);
+    if (leader_comm != MPI_COMM_NULL) {
+        MPI_Comm_rank(leader_comm, &node_index);
+        MPI_Comm_size(leader_comm, &num_nodes);
+    }
+    MPI_Bcast(&node_index, 1, MPI_INT, 0, node_comm);
+    MPI_Bcast(&num_nodes, 1, MPI_INT, 0, node_comm);
+}
+
+MpiSharedImage::~MpiSharedImage() {
+    // Si MPI ya se finalizó, las ventanas y comunicadores ya no existen
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+    if (finalized) {
+        return;
+    }
+    freeWindows();
+    if (leader_comm != MPI_COMM_NULL) {
+        MPI_Comm_free(&leader_comm);
+    }
+    if (node_comm != MPI_COMM_NULL) {
+        MPI_Comm_free(&node_comm);
+    }
+}
+
+void MpiSharedImage::getNodeBand(int index, int& y0, int& rows) const {
+    y0 = static_cast<int>(static_cast<long long>(index) * height / num_nodes);
+    rows = static_cast<int>(static_cast<long long>(index + 1) * height / num_nodes) - y0;
+}
+
+int* MpiSharedImage::allocateWindow(size_t count, MPI_Win& window) {
+    // El líder reserva toda la banda; el resto solo la mapea
+    MPI_Aint bytes = (node_rank == 0) ? static_cast<MPI_Aint>(count * sizeof(int)) : 0;
+    int* local_base = nullptr;
+    MPI_Win_allocate_shared(bytes, sizeof(int), MPI_INFO_NULL, node_comm, &local_base, &window);
+
+    MPI_Aint shared_bytes;
+    int disp_unit;
+    int* base = nullptr;
+    MPI_Win_shared_query(window, 0, &shared_bytes, &disp_unit, &base);
+
+    // Época de acceso pasiva abierta durante toda la vida de la ventana:
+    // los accesos son cargas y almacenamientos normales
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, window);
+    return base;
+}
+
+void MpiSharedImage::freeWindows() {
+    MPI_Win* windows[2] = {&input_win, &output_win};
+    for (int i = 0; i < 2; i++) {
+        if (*windows[i] != MPI_WIN_NULL) {
+            MPI_Win_unlock_all(*windows[i]);
+            MPI_Win_free(windows[i]);
+        }
+    }
+    input = nullptr;
+    output = nullptr;
+}
+
+void MpiSharedImage::synchronize() {
+    MPI_Win_sync(input_win);
+    MPI_Win_sync(output_win);
+    MPI_Barrier(node_comm);
+    MPI_Win_sync(input_win);
+    MPI_Win_sync(output_win);
+}
+
+bool MpiSharedImage::setup(int image_width, int image_height, int num_channels, int max_value) {
+    width = image_width;
+    height = image_height;
+    channels = num_channels;
+    max_color = max_value;
+
+    if (num_nodes > height) {
+        if (rank == 0) {
+            std::cerr << "Error: Cannot split a " << width << "x" << height << " image among "
+                      << num_nodes << " nodes" << std::endl;
+        }
+        return false;
+    }
+
+    getNodeBand(node_index, node_y0, node_height);
+    halo_up = (node_index > 0) ? 1 : 0;
+    halo_down = (node_index < num_nodes - 1) ? 1 : 0;
+    leader_up = halo_up ? node_index - 1 : MPI_PROC_NULL;
+    leader_down = halo_down ? node_index + 1 : MPI_PROC_NULL;
+
+    // Filas del nodo repartidas entre sus rangos (alguno puede quedar sin filas)
+    row_y0 = node_y0 + static_cast<int>(static_cast<long long>(node_rank) * node_height / node_size);
+    row_y1 = node_y0 + static_cast<int>(static_cast<long long>(node_rank + 1) * node_height / node_size);
+
+    freeWindows();
+    const size_t row_count = static_cast<size_t>(width) * channels;
+    input = allocateWindow((node_height + halo_up + halo_down) * row_count, input_win);
+    output = allocateWindow(node_height * row_count, output_win);
+    return true;
+}
+
+void MpiSharedImage::scatter(const int* global_pixels) {
+    // El rango 0 reparte una banda por nodo; cada líder la deja en la ventana
+    if (leader_comm != MPI_COMM_NULL) {
+        std::vector<int> counts(num_nodes), displs(num_nodes);
+        for (int n = 0; n < num_nodes; n++) {
+            int y0, rows;
+            getNodeBand(n, y0, rows);
+            counts[n] = rows * width * channels;
+            displs[n] = y0 * width * channels;
+        }
+        MPI_Scatterv(global_pixels, counts.data(), displs.data(), MPI_INT,
+                     input + static_cast<size_t>(halo_up) * width * channels, counts[node_index], MPI_INT,
+                     0, leader_comm);
+    }
+    synchronize();
+}
+
+void MpiSharedImage::exchangeHalos() {
+    // Dentro del nodo no hay nada que enviar: las filas vecinas ya están en la ventana
+    if (leader_comm != MPI_COMM_NULL && num_nodes > 1) {
+        const int row_count = width * channels;
+        int* own_top = input + static_cast<size_t>(halo_up) * row_count;
+        int* own_bottom = input + static_cast<size_t>(halo_up + node_height - 1) * row_count;
+        int* halo_top = input;
+        int* halo_bottom = input + static_cast<size_t>(halo_up + node_height) * row_count;
+
+        MPI_Sendrecv(own_top, row_count, MPI_INT, leader_up, TAG_NODE_HALO,
+                     halo_bottom, row_count, MPI_INT, leader_down, TAG_NODE_HALO,
+                     leader_comm, MPI_STATUS_IGNORE);
+        MPI_Sendrecv(own_bottom, row_count, MPI_INT, leader_down, TAG_NODE_HALO,
+                     halo_top, row_count, MPI_INT, leader_up, TAG_NODE_HALO,
+                     leader_comm, MPI_STATUS_IGNORE);
+    }
+    synchronize();
+}
+
+bool MpiSharedImage::filter(Filter::FilterType filter_type) {
+    const float (*kernel)[3] = Filter::getKernel(filter_type);
+    if (!kernel) {
+        std::cerr << "Process " << rank << ": Unknown filter type" << std::endl;
+        return false;
+    }
+
+    // Cada rango lee sus filas y las de sus vecinos de nodo directamente de la ventana
+    const int src_y = node_y0 - halo_up;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int y = row_y0; y < row_y1; y++) {
+        Filter::convolveWindow(kernel, channels, max_color, width, height,
+                               input, 0, src_y, width, output, 0, node_y0, width,
+                               0, y, width, y + 1);
+    }
+
+    synchronize();
+    return true;
+}
+
+void MpiSharedImage::commitResult() {
+    const size_t row_count = static_cast<size_t>(width) * channels;
+    if (row_y1 > row_y0) {
+        memcpy(input + (row_y0 - node_y0 + halo_up) * row_count,
+               output + (row_y0 - node_y0) * row_count,
+               (row_y1 - row_y0) * row_count * sizeof(int));
+    }
+    synchronize();
+}
+
+void MpiSharedImage::gather(int* global_pixels) {
+    if (leader_comm != MPI_COMM_NULL) {
+        std::vector<int> counts(num_nodes), displs(num_nodes);
+        for (int n = 0; n < num_nodes; n++) {
+            int y0, rows;
+            getNodeBand(n, y0, rows);
+            counts[n] = rows * width * channels;
+            displs[n] = y0 * width * channels;
+        }
+        MPI_Gatherv(output, counts[node_index], MPI_INT,
+                    global_pixels, counts.data(), displs.data(), MPI_INT, 0, leader_comm);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef MPI_SHARED_IMAGE_H
+#define MPI_SHARED_IMAGE_H
+
+#include <mpi.h>
+#include "filter.h"
+
+// Imagen repartida por nodos con ventanas de memoria compartida MPI-3.
+// Los rangos de un mismo nodo (MPI_Comm_split_type con MPI_COMM_TYPE_SHARED)
+// mapean una única banda de entrada (con una fila de halo por lado) y una
+// única banda de salida creadas con MPI_Win_allocate_shared, en lugar de una
+// copia por rango. Dentro del nodo cada rango filtra sus filas leyendo
+// directamente las de sus vecinos; solo los líderes de nodo intercambian
+// las filas de halo entre nodos y hablan con el rango 0.
+class MpiSharedImage {
+public:
+    // group_size > 0 limita cuántos rangos comparten ventana (p. ej. uno por
+    // dominio NUMA, o para simular varios nodos en una sola máquina)
+    MpiSharedImage(MPI_Comm comm, int group_size = 0);
+    ~MpiSharedImage();
+
+    // Colectiva: reparte las filas entre nodos y reserva las ventanas
+    bool setup(int width, int height, int channels, int max_color);
+
+    // Colectivas: 'global_pixels' solo se usa en el rango 0
+    void scatter(const int* global_pixels);
+    void gather(int* global_pixels);
+
+    // Colectivas: halo entre nodos, filtrado de las filas propias y copia
+    // del resultado a la entrada para la siguiente iteración
+    void exchangeHalos();
+    bool filter(Filter::FilterType filter_type);
+    void commitResult();
+
+    int getNumNodes() const { return num_nodes; }
+    int getNodeSize() const { return node_size; }
+    bool isLeader() const { return node_rank == 0; }
+    int getNodeFirstRow() const { return node_y0; }
+    int getNodeRows() const { return node_height; }
+    int getFirstRow() const { return row_y0; }
+    int getRows() const { return row_y1 - row_y0; }
+
+private:
+    MPI_Comm comm;
+    MPI_Comm node_comm;     // rangos que comparten memoria
+    MPI_Comm leader_comm;   // un rango por nodo (MPI_COMM_NULL en el resto)
+    MPI_Win input_win, output_win;
+    int* input;             // banda del nodo con halo (memoria compartida)
+    int* output;            // banda del nodo sin halo (memoria compartida)
+
+    int rank, node_rank, node_size, node_index, num_nodes;
+    int width, height, channels, max_color;
+    int node_y0, node_height, halo_up, halo_down;
+    int row_y0, row_y1;     // filas globales que filtra este rango
+    int leader_up, leader_down;
+
+    void getNodeBand(int index, int& y0, int& rows) const;
+    int* allocateWindow(size_t count, MPI_Win& window);
+    void freeWindows();
+
+    // Hace visibles las escrituras en las ventanas a todo el nodo
+    void synchronize();
+
+    // No copiable
+    MpiSharedImage(const MpiSharedImage&);
+    MpiSharedImage& operator=(const MpiSharedImage&);
+};
+
+#endif
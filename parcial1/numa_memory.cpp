@@ -0,0 +1,298 @@
+#include "numa_memory.h"
+#include "thread_pool.h"
+#include "memory_tracker.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+// Constantes de <numaif.h>; se usan las llamadas al sistema directamente
+// para no depender de libnuma
+#ifndef MPOL_INTERLEAVE
+#define MPOL_INTERLEAVE 3
+#endif
+
+// Páginas consultadas por llamada a move_pages en el informe
+static const size_t REPORT_BATCH = 4096;
+
+static NumaMemory::Policy current_policy = NumaMemory::POLICY_DEFAULT;
+static ThreadPool* first_touch_pool = nullptr;
+static bool use_huge_pages = false;
+
+// Bytes mapeados de cada buffer grande: release desmapea exactamente lo que
+// se mapeó aunque setHugePages haya cambiado entre medias
+static std::mutex mappings_mutex;
+static std::map<const int*, size_t> mapped_lengths;
+
+void NumaMemory::setPolicy(Policy policy) {
+    current_policy = policy;
+}
+
+NumaMemory::Policy NumaMemory::getPolicy() {
+    return current_policy;
+}
+
+void NumaMemory::setFirstTouchPool(ThreadPool* pool) {
+    first_touch_pool = pool;
+}
+
+void NumaMemory::setHugePages(bool enabled) {
+    use_huge_pages = enabled;
+}
+
+bool NumaMemory::getHugePages() {
+    return use_huge_pages;
+}
+
+void* NumaMemory::mapAligned(size_t length, size_t alignment) {
+    if (alignment == 0) {
+        return mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+
+    // mmap solo garantiza alineación de página: se pide 'alignment' de más y
+    // se devuelven los sobrantes del principio y del final
+    void* raw = mmap(nullptr, length + alignment, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        return MAP_FAILED;
+    }
+    uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t aligned = (start + alignment - 1) / alignment * alignment;
+    if (aligned > start) {
+        munmap(raw, aligned - start);
+    }
+    size_t tail = (start + length + alignment) - (aligned + length);
+    if (tail > 0) {
+        munmap(reinterpret_cast<void*>(aligned + length), tail);
+    }
+    return reinterpret_cast<void*>(aligned);
+}
+
+int* NumaMemory::allocate(size_t count, int rows) {
+    if (count == 0) {
+        return nullptr;
+    }
+
+    size_t bytes = count * sizeof(int);
+    if (!MemoryTracker::reserve(bytes)) {
+        return nullptr;
+    }
+
+    // Buffers pequeños: memoria alineada a línea de caché, sin política NUMA
+    if (bytes < MMAP_THRESHOLD) {
+        void* buffer = nullptr;
+        if (posix_memalign(&buffer, 64, bytes) != 0) {
+            std::cerr << "Error: Cannot allocate " << bytes << " bytes for pixels" << std::endl;
+            MemoryTracker::release(bytes);
+            return nullptr;
+        }
+        return static_cast<int*>(buffer);
+    }
+
+    // Con páginas enormes, longitud e inicio múltiplos de 2 MB para que
+    // MADV_HUGEPAGE pueda cubrir todo el buffer
+    const bool huge_pages = use_huge_pages;
+    const size_t granularity = huge_pages ? HUGE_PAGE_SIZE : static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t length = (bytes + granularity - 1) / granularity * granularity;
+    void* buffer = mapAligned(length, huge_pages ? HUGE_PAGE_SIZE : 0);
+    if (buffer == MAP_FAILED) {
+        std::cerr << "Error: Cannot map " << length << " bytes for pixels" << std::endl;
+        MemoryTracker::release(bytes);
+        return nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mappings_mutex);
+        mapped_lengths[static_cast<int*>(buffer)] = length;
+    }
+
+    // Páginas enormes transparentes para rasters grandes
+    if (huge_pages && madvise(buffer, length, MADV_HUGEPAGE) != 0) {
+        std::cerr << "Warning: madvise(MADV_HUGEPAGE) failed, using normal pages" << std::endl;
+    }
+
+    if (current_policy == POLICY_INTERLEAVE) {
+        int nodes = getNumNodes();
+        unsigned long mask = (nodes >= 64) ? ~0UL : ((1UL << nodes) - 1);
+        if (syscall(SYS_mbind, buffer, length, MPOL_INTERLEAVE, &mask, sizeof(mask) * 8, 0) != 0) {
+            std::cerr << "Warning: mbind(MPOL_INTERLEAVE) failed, using default placement" << std::endl;
+        }
+    } else if (current_policy == POLICY_FIRST_TOUCH && first_touch_pool && rows > 0) {
+        // Cada hilo toca sus filas con el mismo reparto que parallelFor estático
+        char* base = static_cast<char*>(buffer);
+        size_t row_bytes = bytes / rows;
+        first_touch_pool->parallelFor(0, rows, [&](int begin, int end, int) {
+            size_t offset = begin * row_bytes;
+            size_t stop = (end == rows) ? bytes : end * row_bytes;
+            memset(base + offset, 0, stop - offset);
+        });
+    }
+
+    return static_cast<int*>(buffer);
+}
+
+void NumaMemory::release(int* buffer, size_t count) {
+    if (!buffer) {
+        return;
+    }
+    MemoryTracker::release(count * sizeof(int));
+    if (count * sizeof(int) < MMAP_THRESHOLD) {
+        free(buffer);
+    } else {
+        size_t length = 0;
+        {
+            std::lock_guard<std::mutex> lock(mappings_mutex);
+            std::map<const int*, size_t>::iterator it = mapped_lengths.find(buffer);
+            if (it != mapped_lengths.end()) {
+                length = it->second;
+                mapped_lengths.erase(it);
+            }
+        }
+        if (length == 0) {
+            std::cerr << "Error: Releasing a pixel buffer that was not mapped here" << std::endl;
+            return;
+        }
+        munmap(buffer, length);
+    }
+}
+
+int NumaMemory::getNumNodes() {
+    // Formato "0" o "0-1" (o listas como "0,2-3"): se toma el último nodo
+    std::ifstream file("/sys/devices/system/node/online");
+    std::string line;
+    if (!file || !std::getline(file, line) || line.empty()) {
+        return 1;
+    }
+    size_t last = line.find_last_of(",-");
+    int highest = atoi(line.c_str() + (last == std::string::npos ? 0 : last + 1));
+    return highest + 1;
+}
+
+int NumaMemory::getCurrentNode() {
+    unsigned cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+        return 0;
+    }
+    return static_cast<int>(node);
+}
+
+bool NumaMemory::pinCurrentThread(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+std::vector<int> NumaMemory::getAllowedCpus() {
+    std::vector<int> cpus;
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return cpus;
+    }
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+bool NumaMemory::pinPoolThreads(ThreadPool& pool) {
+    std::vector<int> cpus = getAllowedCpus();
+    if (cpus.empty()) {
+        return false;
+    }
+
+    std::vector<char> pinned(std::max(1, pool.getNumThreads()), 0);
+    pool.runOnAll([&](int worker_id) {
+        pinned[worker_id] = pinCurrentThread(cpus[worker_id % cpus.size()]);
+    });
+
+    for (size_t i = 0; i < pinned.size(); i++) {
+        if (!pinned[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void NumaMemory::printPlacementReport(const char* label, const int* buffer, size_t count) {
+    if (!buffer || count == 0) {
+        return;
+    }
+
+    size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t start = reinterpret_cast<uintptr_t>(buffer) / page_size * page_size;
+    uintptr_t end = reinterpret_cast<uintptr_t>(buffer) + count * sizeof(int);
+    size_t num_pages = (end - start + page_size - 1) / page_size;
+
+    int num_nodes = getNumNodes();
+    std::vector<size_t> pages_per_node(num_nodes, 0);
+    size_t not_present = 0;
+
+    std::vector<void*> pages;
+    std::vector<int> status;
+    for (size_t first = 0; first < num_pages; first += REPORT_BATCH) {
+        size_t batch = std::min(REPORT_BATCH, num_pages - first);
+        pages.resize(batch);
+        status.assign(batch, -1);
+        for (size_t i = 0; i < batch; i++) {
+            pages[i] = reinterpret_cast<void*>(start + (first + i) * page_size);
+        }
+
+        // nodes = NULL: solo consulta el nodo de cada página
+        if (syscall(SYS_move_pages, 0, batch, pages.data(), nullptr, status.data(), 0) != 0) {
+            std::cout << "  " << label << ": placement unavailable (move_pages failed)" << std::endl;
+            return;
+        }
+
+        for (size_t i = 0; i < batch; i++) {
+            if (status[i] >= 0 && status[i] < num_nodes) {
+                pages_per_node[status[i]]++;
+            } else {
+                not_present++;
+            }
+        }
+    }
+
+    std::cout << "  " << label << ": " << num_pages << " pages ("
+              << (count * sizeof(int)) / (1024.0 * 1024.0) << " MB)" << std::endl;
+    for (int node = 0; node < num_nodes; node++) {
+        std::cout << "    node " << node << ": " << pages_per_node[node] << " pages ("
+                  << (100.0 * pages_per_node[node] / num_pages) << "%)" << std::endl;
+    }
+    if (not_present > 0) {
+        std::cout << "    not present: " << not_present << " pages" << std::endl;
+    }
+}
+
+NumaMemory::Policy NumaMemory::stringToPolicy(const char* name) {
+    if (strcmp(name, "first-touch") == 0) {
+        return POLICY_FIRST_TOUCH;
+    } else if (strcmp(name, "interleave") == 0) {
+        return POLICY_INTERLEAVE;
+    }
+    return POLICY_DEFAULT;
+}
+
+const char* NumaMemory::policyToString(Policy policy) {
+    switch (policy) {
+        case POLICY_FIRST_TOUCH:
+            return "first-touch";
+        case POLICY_INTERLEAVE:
+            return "interleave";
+        default:
+            return "default";
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef NUMA_MEMORY_H
+#define NUMA_MEMORY_H
+
+#include <cstddef>
+#include <vector>
+
+class ThreadPool;
+
+// Reserva de los buffers de píxeles con control de ubicación NUMA.
+// Los rasters grandes se piden con mmap para que ninguna página exista hasta
+// que se escribe; con la política FIRST_TOUCH los hilos del pool escriben
+// primero sus propias filas (el mismo reparto estático que parallelFor), y
+// cada página queda en el nodo del hilo que luego la procesa.
+class NumaMemory {
+public:
+    enum Policy {
+        POLICY_DEFAULT,      // lo que decida el kernel (primer toque del hilo que carga)
+        POLICY_FIRST_TOUCH,  // primer toque en paralelo con el pool configurado
+        POLICY_INTERLEAVE    // páginas repartidas en todos los nodos (mbind)
+    };
+
+    // Configuración global, normalmente al inicio de main
+    static void setPolicy(Policy policy);
+    static Policy getPolicy();
+    static void setFirstTouchPool(ThreadPool* pool);
+    static void setHugePages(bool enabled);
+    static bool getHugePages();
+
+    // Reserva/libera 'count' enteros para una imagen de 'rows' filas
+    static int* allocate(size_t count, int rows);
+    static void release(int* buffer, size_t count);
+
+    // Fija cada hilo del pool a una CPU distinta (en orden de CPUs permitidas)
+    static bool pinPoolThreads(ThreadPool& pool);
+    // Fija el hilo actual a la CPU indicada
+    static bool pinCurrentThread(int cpu);
+    // CPUs permitidas al proceso, en orden
+    static std::vector<int> getAllowedCpus();
+
+    // Topología
+    static int getNumNodes();
+    static int getCurrentNode();
+
+    // Imprime cuántas páginas del buffer hay en cada nodo
+    static void printPlacementReport(const char* label, const int* buffer, size_t count);
+
+    static Policy stringToPolicy(const char* name);
+    static const char* policyToString(Policy policy);
+
+private:
+    // Tamaño a partir del cual se usa mmap (y se aplica la política NUMA)
+    static const size_t MMAP_THRESHOLD = 1 << 20;
+    // Tamaño de página enorme transparente en x86-64
+    static const size_t HUGE_PAGE_SIZE = 2 << 20;
+
+    // mmap de 'length' bytes con el inicio alineado a 'alignment' (0 = página normal)
+    static void* mapAligned(size_t length, size_t alignment);
+};
+
+#endif
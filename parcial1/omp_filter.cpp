@@ -0,0 +1,84 @@
+#include "omp_filter.h"
+#include "profiler.h"
+#include "result_cache.h"
+#include <string>
+#include <cstdlib>
+
+bool OmpFilter::parseSchedule(const char* text, omp_sched_t& kind, int& chunk) {
+    std::string spec(text);
+    std::string name = spec;
+    chunk = 0;
+    
+    size_t comma = spec.find(',');
+    if (comma != std::string::npos) {
+        name = spec.substr(0, comma);
+        chunk = atoi(spec.c_str() + comma + 1);
+    }
+    
+    if (name == "static") {
+        kind = omp_sched_static;
+    } else if (name == "dynamic") {
+        kind = omp_sched_dynamic;
+    } else if (name == "guided") {
+        kind = omp_sched_guided;
+    } else if (name == "auto") {
+        kind = omp_sched_auto;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* OmpFilter::scheduleToString(omp_sched_t kind) {
+    switch (kind) {
+        case omp_sched_static:
+            return "static";
+        case omp_sched_dynamic:
+            return "dynamic";
+        case omp_sched_guided:
+            return "guided";
+        default:
+            return "auto";
+    }
+}
+
+bool OmpFilter::apply(Imagen* input, Imagen* output, Filter::FilterType filter_type, int num_threads,
+                      int iterations, int time_block) {
+    PROFILE_ZONE("filter");
+    
+    if (iterations > 1) {
+        IterativeFilter::TileRunner runner = [num_threads](int count, const IterativeFilter::TileTask& tile) {
+            #pragma omp parallel num_threads(num_threads)
+            {
+                PROFILE_ZONE("band");
+                #pragma omp for schedule(runtime)
+                for (int i = 0; i < count; i++) {
+                    tile(i);
+                }
+            }
+        };
+        return IterativeFilter::apply(input, output, filter_type, iterations, runner, 0, 0, time_block);
+    }
+    
+    return ResultCache::apply(input, output, filter_type, 1, [&]() {
+        if (!Filter::prepareOutput(input, output)) {
+            return false;
+        }
+        
+        int width = input->getWidth();
+        int height = input->getHeight();
+        bool success = true;
+        
+        // La región paralela envuelve el bucle para tener una zona "band" por hilo
+        #pragma omp parallel num_threads(num_threads)
+        {
+            PROFILE_ZONE("band");
+            #pragma omp for schedule(runtime) reduction(&&:success)
+            for (int y = 0; y < height; y++) {
+                success = Filter::applyFilterRegion(input, output, filter_type, 0, y, width, y + 1) && success;
+            }
+        }
+        
+        return success;
+    });
+}
@@ -0,0 +1,25 @@
+#ifndef OMP_FILTER_H
+#define OMP_FILTER_H
+
+#include <omp.h>
+#include "imagen.h"
+#include "filter.h"
+#include "iterative_filter.h"
+
+// Backend de OpenMP como biblioteca: lo usan image_processor y el arnés de
+// rendimiento. Requiere compilar con -fopenmp.
+class OmpFilter {
+public:
+    // Aplica un filtro repartiendo las filas entre num_threads hilos.
+    // El reparto lo decide schedule(runtime), fijado con omp_set_schedule.
+    // Con iterations > 1 se reparten los tiles de cada pasada del filtro iterativo.
+    // Si la caché de resultados (ResultCache) está activa se consulta antes.
+    static bool apply(Imagen* input, Imagen* output, Filter::FilterType filter_type, int num_threads,
+                      int iterations = 1, int time_block = IterativeFilter::DEFAULT_TIME_BLOCK);
+
+    // Interpreta "static", "dynamic,4", "guided,16"... para omp_set_schedule
+    static bool parseSchedule(const char* text, omp_sched_t& kind, int& chunk);
+    static const char* scheduleToString(omp_sched_t kind);
+};
+
+#endif
@@ -0,0 +1,258 @@
+#include "perf_counters.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <dirent.h>
+#endif
+
+PerfCounters::PerfCounters() : num_open(0) {
+    for (int c = 0; c < NUM_COUNTERS; c++) {
+        scales[c] = 1.0;
+        begin_values[c] = 0.0;
+        deltas[c] = 0.0;
+    }
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for (int c = 0; c < NUM_COUNTERS; c++) {
+        for (size_t i = 0; i < fds[c].size(); i++) {
+            close(fds[c][i]);
+        }
+    }
+#endif
+}
+
+const char* PerfCounters::counterToString(Counter counter) {
+    switch (counter) {
+        case CYCLES: return "cycles";
+        case INSTRUCTIONS: return "instructions";
+        case L1D_MISSES: return "L1d misses";
+        case LLC_MISSES: return "LLC misses";
+        case BRANCH_MISSES: return "branch misses";
+        case TASK_CLOCK: return "task clock";
+        case IMC_READS: return "DRAM read bytes";
+        case IMC_WRITES: return "DRAM write bytes";
+        default: return "unknown";
+    }
+}
+
+bool PerfCounters::openCounter(Counter counter, unsigned int type, unsigned long long config, int cpu) {
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // Por proceso (cpu = -1): solo espacio de usuario y heredado por los
+    // hilos que se creen después. Los contadores uncore son de todo el
+    // sistema y no admiten 'inherit' ni excluir el kernel.
+    pid_t pid = 0;
+    if (cpu < 0) {
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+    } else {
+        pid = -1;
+    }
+
+    int fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, pid, cpu, -1, 0));
+    if (fd < 0) {
+        return false;
+    }
+    fds[counter].push_back(fd);
+    return true;
+#else
+    (void)counter;
+    (void)type;
+    (void)config;
+    (void)cpu;
+    return false;
+#endif
+}
+
+void PerfCounters::openImcCounters(Counter counter, const char* event_name) {
+#ifdef __linux__
+    // Un dispositivo uncore_imc_N por canal; cada uno describe el evento en
+    // sysfs como "event=0x04,umask=0x03" con su escala a MiB
+    const std::string base = "/sys/bus/event_source/devices/";
+    DIR* dir = opendir(base.c_str());
+    if (!dir) {
+        return;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        std::string device(entry->d_name);
+        if (device.compare(0, 11, "uncore_imc_") != 0) {
+            continue;
+        }
+
+        std::ifstream type_file((base + device + "/type").c_str());
+        std::ifstream event_file((base + device + "/events/" + event_name).c_str());
+        std::ifstream scale_file((base + device + "/events/" + event_name + ".scale").c_str());
+        std::ifstream cpumask_file((base + device + "/cpumask").c_str());
+        unsigned int type;
+        std::string spec;
+        if (!(type_file >> type) || !(event_file >> spec)) {
+            continue;
+        }
+
+        unsigned long long config = 0;
+        std::stringstream fields(spec);
+        std::string field;
+        while (std::getline(fields, field, ',')) {
+            size_t equals = field.find('=');
+            if (equals == std::string::npos) {
+                continue;
+            }
+            std::string key = field.substr(0, equals);
+            unsigned long long value = strtoull(field.c_str() + equals + 1, nullptr, 0);
+            if (key == "event") {
+                config |= value;
+            } else if (key == "umask") {
+                config |= value << 8;
+            }
+        }
+
+        double scale_mib = 0.0;
+        int cpu = 0;
+        if (scale_file >> scale_mib) {
+            scales[counter] = scale_mib * 1024.0 * 1024.0;
+        } else {
+            scales[counter] = 64.0; // una línea de caché por acceso
+        }
+        cpumask_file >> cpu;
+
+        openCounter(counter, type, config, cpu);
+    }
+    closedir(dir);
+#else
+    (void)counter;
+    (void)event_name;
+#endif
+}
+
+bool PerfCounters::open() {
+#ifdef __linux__
+    const unsigned long long l1d_read_miss = PERF_COUNT_HW_CACHE_L1D |
+                                             (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                             (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+    openCounter(CYCLES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1);
+    openCounter(INSTRUCTIONS, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, -1);
+    openCounter(L1D_MISSES, PERF_TYPE_HW_CACHE, l1d_read_miss, -1);
+    openCounter(LLC_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, -1);
+    openCounter(BRANCH_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, -1);
+    openCounter(TASK_CLOCK, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, -1);
+    openImcCounters(IMC_READS, "cas_count_read");
+    openImcCounters(IMC_WRITES, "cas_count_write");
+#endif
+
+    num_open = 0;
+    for (int c = 0; c < NUM_COUNTERS; c++) {
+        if (!fds[c].empty()) {
+            num_open++;
+        }
+    }
+
+    if (num_open == 0) {
+        std::cerr << "Warning: No performance counters available (check /proc/sys/kernel/perf_event_paranoid)"
+                  << std::endl;
+        return false;
+    }
+    if (fds[CYCLES].empty() || fds[INSTRUCTIONS].empty()) {
+        std::cerr << "Warning: Hardware counters unavailable (virtual machine or perf_event_paranoid);"
+                  << " only software counters will be reported" << std::endl;
+    }
+    return true;
+}
+
+void PerfCounters::readAll(double values[NUM_COUNTERS]) const {
+    for (int c = 0; c < NUM_COUNTERS; c++) {
+        values[c] = 0.0;
+#ifdef __linux__
+        for (size_t i = 0; i < fds[c].size(); i++) {
+            // {valor, tiempo habilitado, tiempo contando}: si el kernel
+            // multiplexó el contador se extrapola al tiempo habilitado
+            unsigned long long data[3] = {0, 0, 0};
+            if (read(fds[c][i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) {
+                continue;
+            }
+            double value = static_cast<double>(data[0]);
+            if (data[2] > 0 && data[2] < data[1]) {
+                value *= static_cast<double>(data[1]) / data[2];
+            }
+            values[c] += value * scales[c];
+        }
+#endif
+    }
+}
+
+void PerfCounters::start() {
+    if (num_open > 0) {
+        readAll(begin_values);
+    }
+}
+
+void PerfCounters::stop() {
+    if (num_open == 0) {
+        return;
+    }
+    double end_values[NUM_COUNTERS];
+    readAll(end_values);
+    for (int c = 0; c < NUM_COUNTERS; c++) {
+        deltas[c] = end_values[c] - begin_values[c];
+    }
+}
+
+void PerfCounters::report(const char* label, long long pixels, double ms) const {
+    if (num_open == 0) {
+        return;
+    }
+
+    const double per_pixel = pixels > 0 ? 1.0 / pixels : 0.0;
+    std::ostringstream line;
+    const char* separator = " ";
+
+    if (isAvailable(CYCLES) && isAvailable(INSTRUCTIONS) && deltas[CYCLES] > 0) {
+        line << separator << "IPC " << deltas[INSTRUCTIONS] / deltas[CYCLES] << ", cycles/pixel "
+             << deltas[CYCLES] * per_pixel;
+        separator = ", ";
+    }
+    if (isAvailable(L1D_MISSES)) {
+        line << separator << "L1d misses/pixel " << deltas[L1D_MISSES] * per_pixel;
+        separator = ", ";
+    }
+    if (isAvailable(LLC_MISSES)) {
+        line << separator << "LLC misses/pixel " << deltas[LLC_MISSES] * per_pixel;
+        separator = ", ";
+    }
+    if (isAvailable(BRANCH_MISSES)) {
+        line << separator << "branch misses/pixel " << deltas[BRANCH_MISSES] * per_pixel;
+        separator = ", ";
+    }
+    if (isAvailable(TASK_CLOCK)) {
+        // CPU consumida frente al tiempo de pared: ~N con N hilos ocupados
+        line << separator << "CPU " << deltas[TASK_CLOCK] / 1e6 << " ms";
+        if (ms > 0) {
+            line << " (" << deltas[TASK_CLOCK] / 1e6 / ms << " cores busy)";
+        }
+        separator = ", ";
+    }
+    if ((isAvailable(IMC_READS) || isAvailable(IMC_WRITES)) && ms > 0) {
+        line << separator << "DRAM " << (deltas[IMC_READS] + deltas[IMC_WRITES]) / (ms * 1e6) << " GB/s";
+    }
+
+    std::cout << "  " << label << " counters:" << line.str() << std::endl;
+}
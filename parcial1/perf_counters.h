@@ -0,0 +1,64 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <vector>
+
+// Contadores de hardware con perf_event_open (Linux). Se abren una vez al
+// inicio del programa con 'inherit', así cuentan también los hilos que se
+// crean después (pool de pthreads, equipo de OpenMP). Cada fase se mide como
+// la diferencia entre dos lecturas (start/stop) y se informa junto al tiempo
+// en ms: IPC, fallos de L1/LLC y de predicción de saltos por píxel y, si el
+// sistema expone el controlador de memoria (uncore_imc), el ancho de banda.
+// Los contadores que el kernel o la máquina no ofrecen (p. ej. en una VM o
+// con perf_event_paranoid alto) se omiten; si no hay ninguno, todo es no-op.
+class PerfCounters {
+public:
+    enum Counter {
+        CYCLES,
+        INSTRUCTIONS,
+        L1D_MISSES,
+        LLC_MISSES,
+        BRANCH_MISSES,
+        TASK_CLOCK,     // ns de CPU sumados entre hilos (software, casi siempre disponible)
+        IMC_READS,      // bytes leídos de DRAM (uncore, todo el sistema)
+        IMC_WRITES,     // bytes escritos en DRAM
+        NUM_COUNTERS
+    };
+
+    PerfCounters();
+    ~PerfCounters();
+
+    // Abre los contadores disponibles; devuelve false si no se pudo ninguno
+    bool open();
+    bool isOpen() const { return num_open > 0; }
+    bool isAvailable(Counter counter) const { return !fds[counter].empty(); }
+
+    // Delimitan una fase
+    void start();
+    void stop();
+
+    // Valor de la última fase (escalado si hubo multiplexación)
+    double getValue(Counter counter) const { return deltas[counter]; }
+
+    // Imprime "  <label> counters: IPC ..., L1 misses/pixel ..., ..."
+    void report(const char* label, long long pixels, double ms) const;
+
+    static const char* counterToString(Counter counter);
+
+private:
+    std::vector<int> fds[NUM_COUNTERS];  // varios para IMC (uno por canal de memoria); se suman
+    double scales[NUM_COUNTERS];         // factor a bytes para los contadores IMC, 1 en el resto
+    double begin_values[NUM_COUNTERS];
+    double deltas[NUM_COUNTERS];
+    int num_open;
+
+    bool openCounter(Counter counter, unsigned int type, unsigned long long config, int cpu);
+    void openImcCounters(Counter counter, const char* event_name);
+    void readAll(double values[NUM_COUNTERS]) const;
+
+    // No copiable
+    PerfCounters(const PerfCounters&);
+    PerfCounters& operator=(const PerfCounters&);
+};
+
+#endif
@@ -1,119 +1,380 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <vector>
 #include <string>
-#include <chrono>
+#include <algorithm>
+#include <cstring>
 #include <cstdlib>
+#include "imagen.h"
+#include "PGMimage.h"
+#include "PPMimage.h"
+#include "image_factory.h"
+#include "filter.h"
+#include "thread_pool.h"
+#include "tile_scheduler.h"
+#include "tile_autotuner.h"
+#include "pthread_filter.h"
+#include "omp_filter.h"
+#include "json_writer.h"
 #include "timer.h"
 
+// Arnés de rendimiento en proceso: los backends se enlazan como bibliotecas
+// y se miden por fases (carga, filtro, guardado) sin contar el arranque del
+// proceso. Tras unas repeticiones de calentamiento se toman N muestras por
+// fase y se informan la mediana, el p90 y el p99 en MPix/s. El p90 y el p99
+// salen de los tiempos más lentos: el 90% / 99% de las repeticiones fueron
+// al menos así de rápidas. MPI se mide con mpi_processor --bench.
+
+enum Phase {
+    PHASE_LOAD,
+    PHASE_PROCESS,
+    PHASE_SAVE,
+    NUM_PHASES
+};
+
+const char* phase_names[NUM_PHASES] = {"load", "process", "save"};
+
+// Percentiles de una fase, ya convertidos a MPix/s
+struct PhaseStats {
+    double median, p90, p99;
+    PhaseStats() : median(0.0), p90(0.0), p99(0.0) {}
+};
+
 struct TestResult {
     std::string implementation;
     std::string image;
     std::string filter;
-    int threads_or_processes;
-    double load_time;
-    double process_time;
-    double save_time;
-    double total_time;
+    int threads;
+    int width, height, channels;
+    PhaseStats phases[NUM_PHASES];
 };
 
-void runTest(const std::string& implementation, const std::string& image, 
-             const std::string& filter, int num_threads, std::vector<TestResult>& results) {
-    Timer timer;
-    timer.start();
-    
-    std::string command;
-    if (implementation == "sequential") {
-        command = "./processor " + image + " output_" + implementation + ".ppm --f " + filter;
-    }
-    else if (implementation == "pthread" || implementation == "omp") {
-        command = "./processor_" + implementation + " " + image + " output_" + implementation + ".ppm --f " + 
-                 filter + " --t " + std::to_string(num_threads);
-    }
-    else if (implementation == "mpi") {
-        command = "mpirun -np " + std::to_string(num_threads) + " ./processor_mpi " + 
-                 image + " output_" + implementation + ".ppm --f " + filter;
-    }
-    
-    std::cout << "\nExecuting: " << command << std::endl;
-    system(command.c_str());
-    
-    timer.stop();
-    
-    // Los tiempos específicos son registrados por cada implementación en su salida
-    TestResult result;
-    result.implementation = implementation;
+struct HarnessConfig {
+    std::vector<std::string> images;
+    std::vector<std::string> filters;
+    std::vector<std::string> backends;
+    std::vector<int> thread_counts;
+    int repetitions;
+    int warmup;
+    std::string csv_file;
+    std::string json_file;
+    std::string output_prefix;
+    std::string tag;  // etiqueta libre, p. ej. el commit medido
+    std::string profile_path;  // perfil de tiles; vacío = tamaño por defecto
+
+    HarnessConfig() : repetitions(10), warmup(2), csv_file("performance_results.csv"),
+                      json_file("performance_results.json"), output_prefix("performance_output") {}
+};
+
+void printUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [options]" << std::endl;
+    std::cout << "  --images a,b:     Input images (default: imagenes/fruit.pgm,imagenes/lena.ppm)" << std::endl;
+    std::cout << "  --filters a,b:    Filters (default: blur,sharpen,laplace)" << std::endl;
+    std::cout << "  --backends a,b:   sequential, pthread, tiles, omp (default: all)" << std::endl;
+    std::cout << "  --threads 1,2,4:  Thread counts for the parallel backends (default: 1,2,4,8)" << std::endl;
+    std::cout << "  --reps N:         Measured repetitions per case (default: 10)" << std::endl;
+    std::cout << "  --warmup N:       Unmeasured repetitions before measuring (default: 2)" << std::endl;
+    std::cout << "  --csv file:       Append results as CSV rows (default: performance_results.csv)" << std::endl;
+    std::cout << "  --json file:      Append results as JSON lines (default: performance_results.json)" << std::endl;
+    std::cout << "  --tag label:      Label stored with every record (e.g. the commit hash)" << std::endl;
+    std::cout << "  --out prefix:     Prefix for the saved output images (default: performance_output)" << std::endl;
+    std::cout << "  --profile p:      Tile profile for the tiles backend (default: tile sizes from the caches)" << std::endl;
+}
+
+std::vector<std::string> splitList(const char* text) {
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// Percentil por rango más cercano sobre tiempos ordenados
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>(p / 100.0 * sorted.size() + 0.999999);
+    rank = std::max<size_t>(1, std::min(rank, sorted.size()));
+    return sorted[rank - 1];
+}
+
+double toMegapixelsPerSecond(double megapixels, double ms) {
+    return ms > 0.0 ? megapixels / (ms / 1000.0) : 0.0;
+}
+
+// Ejecuta un backend con la configuración pedida; los pools se crean fuera
+// para que la creación de hilos no cuente como tiempo de filtro
+bool runBackend(const std::string& backend, Imagen* input, Imagen* output, Filter::FilterType filter_type,
+                int threads, ThreadPool* pool, TileScheduler* scheduler) {
+    if (backend == "sequential") {
+        return Filter::applyFilter(input, output, filter_type);
+    } else if (backend == "pthread") {
+        return PthreadFilter::applyRows(input, output, filter_type, *pool);
+    } else if (backend == "tiles") {
+        return PthreadFilter::applyTiles(input, output, filter_type, *scheduler);
+    } else if (backend == "omp") {
+        return OmpFilter::apply(input, output, filter_type, threads);
+    }
+    return false;
+}
+
+bool runTest(const HarnessConfig& config, const std::string& backend, const std::string& image,
+             const std::string& filter, int threads, const TileProfile& profile, TestResult& result) {
+    Filter::FilterType filter_type = Filter::stringToFilterType(filter.c_str());
+
+    ThreadPool* pool = nullptr;
+    TileScheduler* scheduler = nullptr;
+    if (backend == "pthread" || backend == "tiles") {
+        pool = new ThreadPool(threads);
+        scheduler = new TileScheduler(*pool);
+    }
+
+    std::vector<double> samples[NUM_PHASES];
+    bool success = true;
+    std::string output_file;
+
+    for (int rep = 0; rep < config.warmup + config.repetitions && success; rep++) {
+        Timer timers[NUM_PHASES];
+
+        timers[PHASE_LOAD].start();
+        Imagen* input = ImageFactory::load(image.c_str());
+        timers[PHASE_LOAD].stop();
+        if (!input) {
+            std::cerr << "Error: Cannot load image " << image << std::endl;
+            success = false;
+            break;
+        }
+
+        Imagen* output = nullptr;
+        if (strcmp(input->getMagic(), "P3") == 0) {
+            output = new PPMImage();
+            output_file = config.output_prefix + ".ppm";
+        } else {
+            output = new PGMImage();
+            output_file = config.output_prefix + ".pgm";
+        }
+
+        if (scheduler && rep == 0) {
+            int tile_width, tile_height;
+            profile.getTileSize(input, tile_width, tile_height);
+            if (tile_width > 0 && tile_height > 0) {
+                scheduler->setTileSize(tile_width, tile_height);
+            }
+        }
+
+        timers[PHASE_PROCESS].start();
+        success = runBackend(backend, input, output, filter_type, threads, pool, scheduler);
+        timers[PHASE_PROCESS].stop();
+
+        timers[PHASE_SAVE].start();
+        success = success && output->save(output_file.c_str());
+        timers[PHASE_SAVE].stop();
+
+        if (rep == 0) {
+            result.width = input->getWidth();
+            result.height = input->getHeight();
+            result.channels = (strcmp(input->getMagic(), "P3") == 0) ? 3 : 1;
+        }
+
+        if (rep >= config.warmup) {
+            for (int p = 0; p < NUM_PHASES; p++) {
+                samples[p].push_back(timers[p].getElapsedMilliseconds());
+            }
+        }
+
+        delete input;
+        delete output;
+    }
+
+    delete scheduler;
+    delete pool;
+
+    if (!success) {
+        std::cerr << "Error: " << backend << " failed on " << image << " (" << filter << ")" << std::endl;
+        return false;
+    }
+
+    result.implementation = backend;
     result.image = image;
     result.filter = filter;
-    result.threads_or_processes = num_threads;
-    result.total_time = timer.getElapsedMilliseconds();
-    
-    results.push_back(result);
-}
+    result.threads = threads;
+
+    // Tiempos lentos = percentiles altos de tiempo = rendimiento bajo
+    const double megapixels = static_cast<double>(result.width) * result.height / 1e6;
+    for (int p = 0; p < NUM_PHASES; p++) {
+        std::sort(samples[p].begin(), samples[p].end());
+        result.phases[p].median = toMegapixelsPerSecond(megapixels, percentile(samples[p], 50.0));
+        result.phases[p].p90 = toMegapixelsPerSecond(megapixels, percentile(samples[p], 90.0));
+        result.phases[p].p99 = toMegapixelsPerSecond(megapixels, percentile(samples[p], 99.0));
+    }
 
-void saveResults(const std::vector<TestResult>& results, const std::string& filename) {
-    std::ofstream file(filename);
-    
-    // Escribir encabezado CSV
-    file << "Implementation,Image,Filter,Threads/Processes,Total Time (ms)\n";
-    
-    // Escribir resultados
-    for (const auto& result : results) {
-        file << result.implementation << ","
-             << result.image << ","
-             << result.filter << ","
-             << result.threads_or_processes << ","
-             << result.total_time << "\n";
-    }
-    
-    file.close();
+    std::cout << backend << " x" << threads << " " << image << " " << filter << ":";
+    for (int p = 0; p < NUM_PHASES; p++) {
+        std::cout << " " << phase_names[p] << " " << result.phases[p].median << " MPix/s";
+    }
+    std::cout << " (p90 process " << result.phases[PHASE_PROCESS].p90 << ")" << std::endl;
+    return true;
 }
 
-int main() {
-    std::vector<TestResult> results;
-    std::vector<std::string> images = {"imagenes/fruit.ppm", "imagenes/lena.ppm"};
-    std::vector<std::string> filters = {"blur", "sharpen", "laplace"};
-    std::vector<int> thread_counts = {1, 2, 4, 8};
-    
-    std::cout << "=== Performance Comparison ===" << std::endl;
-    
-    // Pruebas secuenciales
-    for (const auto& image : images) {
-        for (const auto& filter : filters) {
-            runTest("sequential", image, filter, 1, results);
+void saveResults(const std::vector<TestResult>& results, const HarnessConfig& config) {
+    // CSV: la cabecera solo se escribe en archivos nuevos, así los resultados
+    // de varios commits se acumulan en la misma tabla
+    bool write_header = true;
+    {
+        std::ifstream existing(config.csv_file.c_str());
+        write_header = !existing || existing.peek() == std::ifstream::traits_type::eof();
+    }
+
+    std::ofstream csv(config.csv_file.c_str(), std::ios::app);
+    if (write_header) {
+        csv << "tag,implementation,image,filter,threads,width,height,channels,repetitions";
+        for (int p = 0; p < NUM_PHASES; p++) {
+            csv << "," << phase_names[p] << "_median_mpix_s," << phase_names[p] << "_p90_mpix_s,"
+                << phase_names[p] << "_p99_mpix_s";
         }
+        csv << "\n";
     }
-    
-    // Pruebas con pthreads
-    for (const auto& image : images) {
-        for (const auto& filter : filters) {
-            for (int threads : thread_counts) {
-                runTest("pthread", image, filter, threads, results);
-            }
+    for (size_t i = 0; i < results.size(); i++) {
+        const TestResult& result = results[i];
+        csv << config.tag << "," << result.implementation << "," << result.image << "," << result.filter << ","
+            << result.threads << "," << result.width << "," << result.height << "," << result.channels << ","
+            << config.repetitions;
+        for (int p = 0; p < NUM_PHASES; p++) {
+            csv << "," << result.phases[p].median << "," << result.phases[p].p90 << "," << result.phases[p].p99;
         }
+        csv << "\n";
     }
-    
-    // Pruebas con OpenMP
-    for (const auto& image : images) {
-        for (const auto& filter : filters) {
-            for (int threads : thread_counts) {
-                runTest("omp", image, filter, threads, results);
+
+    // JSON: un objeto por línea (JSON Lines)
+    std::ofstream json(config.json_file.c_str(), std::ios::app);
+    for (size_t i = 0; i < results.size(); i++) {
+        const TestResult& result = results[i];
+        json << "{\"tag\": ";
+        JsonWriter::writeString(json, config.tag);
+        json << ", \"implementation\": ";
+        JsonWriter::writeString(json, result.implementation);
+        json << ", \"image\": ";
+        JsonWriter::writeString(json, result.image);
+        json << ", \"filter\": ";
+        JsonWriter::writeString(json, result.filter);
+        json << ", \"threads\": " << result.threads << ", \"width\": " << result.width
+             << ", \"height\": " << result.height << ", \"channels\": " << result.channels
+             << ", \"repetitions\": " << config.repetitions << ", \"mpix_s\": {";
+        for (int p = 0; p < NUM_PHASES; p++) {
+            json << "\"" << phase_names[p] << "\": {\"median\": " << result.phases[p].median
+                 << ", \"p90\": " << result.phases[p].p90 << ", \"p99\": " << result.phases[p].p99 << "}"
+                 << (p + 1 < NUM_PHASES ? ", " : "");
+        }
+        json << "}}\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    HarnessConfig config;
+    config.images = splitList("imagenes/fruit.pgm,imagenes/lena.ppm");
+    config.filters = splitList("blur,sharpen,laplace");
+    config.backends = splitList("sequential,pthread,tiles,omp");
+    config.thread_counts.push_back(1);
+    config.thread_counts.push_back(2);
+    config.thread_counts.push_back(4);
+    config.thread_counts.push_back(8);
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        if (strcmp(argv[i], "--images") == 0) {
+            config.images = splitList(argv[++i]);
+        } else if (strcmp(argv[i], "--filters") == 0) {
+            config.filters = splitList(argv[++i]);
+        } else if (strcmp(argv[i], "--backends") == 0) {
+            config.backends = splitList(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            std::vector<std::string> counts = splitList(argv[++i]);
+            config.thread_counts.clear();
+            for (size_t c = 0; c < counts.size(); c++) {
+                config.thread_counts.push_back(std::max(1, atoi(counts[c].c_str())));
             }
+        } else if (strcmp(argv[i], "--reps") == 0) {
+            config.repetitions = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--warmup") == 0) {
+            config.warmup = std::max(0, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--csv") == 0) {
+            config.csv_file = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0) {
+            config.json_file = argv[++i];
+        } else if (strcmp(argv[i], "--tag") == 0) {
+            config.tag = argv[++i];
+        } else if (strcmp(argv[i], "--out") == 0) {
+            config.output_prefix = argv[++i];
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            config.profile_path = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Un nombre mal escrito no debe dejar filas con tiempos de otro caso
+    for (size_t b = 0; b < config.backends.size(); b++) {
+        const std::string& backend = config.backends[b];
+        if (backend != "sequential" && backend != "pthread" && backend != "tiles" && backend != "omp") {
+            std::cerr << "Error: Unknown backend '" << backend << "'" << std::endl;
+            return 1;
+        }
+    }
+    for (size_t f = 0; f < config.filters.size(); f++) {
+        Filter::FilterType filter_type;
+        if (!Filter::stringToFilterType(config.filters[f].c_str(), filter_type)) {
+            std::cerr << "Error: Unknown filter '" << config.filters[f] << "'" << std::endl;
+            return 1;
         }
     }
-    
-    // Pruebas con MPI
-    for (const auto& image : images) {
-        for (const auto& filter : filters) {
-            for (int processes : thread_counts) {
-                runTest("mpi", image, filter, processes, results);
+
+    std::cout << "=== Performance Comparison ===" << std::endl;
+    std::cout << "Repetitions: " << config.repetitions << " (+" << config.warmup << " warm-up)" << std::endl;
+
+    // El perfil de tiles solo se usa si se pide y solo para el backend de tiles
+    TileProfile profile;
+    if (!config.profile_path.empty() &&
+        std::find(config.backends.begin(), config.backends.end(), "tiles") != config.backends.end()) {
+        profile = TileAutotuner::loadOrTune(config.profile_path.c_str(), false, false);
+    }
+
+    std::vector<TestResult> results;
+    bool all_success = true;
+    for (size_t b = 0; b < config.backends.size(); b++) {
+        const std::string& backend = config.backends[b];
+
+        // El secuencial solo tiene sentido con un hilo
+        std::vector<int> counts = config.thread_counts;
+        if (backend == "sequential") {
+            counts.assign(1, 1);
+        }
+
+        for (size_t i = 0; i < config.images.size(); i++) {
+            for (size_t f = 0; f < config.filters.size(); f++) {
+                for (size_t t = 0; t < counts.size(); t++) {
+                    TestResult result;
+                    if (runTest(config, backend, config.images[i], config.filters[f], counts[t], profile, result)) {
+                        results.push_back(result);
+                    } else {
+                        all_success = false;
+                    }
+                }
             }
         }
     }
-    
-    // Guardar resultados en CSV
-    saveResults(results, "performance_results.csv");
-    
-    std::cout << "\nResults have been saved to performance_results.csv" << std::endl;
-    return 0;
+
+    saveResults(results, config);
+
+    std::cout << "\nResults have been appended to " << config.csv_file << " and " << config.json_file << std::endl;
+    return all_success ? 0 : 1;
 }
@@ -1,10 +1,23 @@
 #include <iostream>
 #include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <climits>
+#include <string>
+#include <vector>
+#include <algorithm>
 #include "imagen.h"
-#include "PGMimage.h"
-#include "PPMimage.h"
+#include "image_factory.h"
 #include "filter.h"
+#include "integral_image.h"
+#include "iterative_filter.h"
+#include "incremental_filter.h"
+#include "tile_autotuner.h"
 #include "timer.h"
+#include "profiler.h"
+#include "perf_counters.h"
+#include "memory_tracker.h"
+#include "result_cache.h"
 
 void printUsage(const char* program_name) {
     std::cout << "Usage: " << program_name << " input_file output_file [--f filter_type]" << std::endl;
@@ -12,69 +25,75 @@ void printUsage(const char* program_name) {
     std::cout << "  output_file: Output image file" << std::endl;
     std::cout << "  --f filter:  Filter to apply (blur, laplace, sharpen)" << std::endl;
     std::cout << "               If no filter specified, image will be copied" << std::endl;
+    std::cout << "  --box R:     Box blur of radius R using an integral image" << std::endl;
+    std::cout << "  --iterations N: Apply the filter N times (ping-pong buffers, temporal blocking)" << std::endl;
+    std::cout << "  --time-block T: Iterations per pass over the image (default: "
+              << IterativeFilter::DEFAULT_TIME_BLOCK << ")" << std::endl;
+    std::cout << "  --edit X,Y,WxH: After filtering, invert that rectangle of the input and recompute only the" << std::endl;
+    std::cout << "               affected output (repeatable); with --edit, --f takes a chain such as blur,sharpen" << std::endl;
+    std::cout << "  --profile p: Use the tile sizes in profile p (searched and saved there if missing)" << std::endl;
+    std::cout << "  --autotune:  Search the tile size and save it to the profile (default: "
+              << TileAutotuner::DEFAULT_PROFILE_PATH << ")" << std::endl;
+    std::cout << "  --trace f:   Write a Chrome trace of the profiling zones to f and print a summary" << std::endl;
+    std::cout << "               (zones are only recorded when built with -DENABLE_PROFILING)" << std::endl;
+    std::cout << "  --counters:  Report hardware counters (IPC, cache/branch misses per pixel) per phase" << std::endl;
+    std::cout << "  --mem-budget S: Fail if the image buffers would exceed S bytes (K, M, G suffixes)" << std::endl;
+    std::cout << "  --cache dir: Reuse filter results stored in dir (content-addressed, LRU eviction)" << std::endl;
+    std::cout << "  --cache-size S: Size limit of the result cache (default: 1G)" << std::endl;
     std::cout << std::endl;
     std::cout << "Examples:" << std::endl;
     std::cout << "  " << program_name << " lena.ppm lena_copy.ppm" << std::endl;
     std::cout << "  " << program_name << " fruit.ppm fruit_blur.ppm --f blur" << std::endl;
     std::cout << "  " << program_name << " image.pgm image_sharp.pgm --f sharpen" << std::endl;
+    std::cout << "  " << program_name << " lena.pgm lena_box.pgm --box 7" << std::endl;
+    std::cout << "  " << program_name << " big.pgm big_sharp.pgm --f blur,sharpen --edit 100,200,64x64" << std::endl;
 }
 
-Imagen* createImageFromFile(const char* filename) {
-    // Detectar tipo de archivo leyendo el magic number
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        std::cerr << "Error: Cannot open file " << filename << std::endl;
-        return nullptr;
-    }
-    
-    char magic[3];
-    if (fscanf(file, "%2s", magic) != 1) {
-        std::cerr << "Error: Cannot read magic number from " << filename << std::endl;
-        fclose(file);
-        return nullptr;
-    }
-    fclose(file);
-    
-    Imagen* image = nullptr;
-    
-    if (strcmp(magic, "P2") == 0) {
-        // Es PGM
-        image = new PGMImage();
-    } else if (strcmp(magic, "P3") == 0) {
-        // Es PPM
-        image = new PPMImage();
-    } else {
-        std::cerr << "Error: Unsupported image format. Only P2 (PGM) and P3 (PPM) are supported." << std::endl;
-        return nullptr;
+// Retoque de prueba para --edit
+int invertValue(int value, int max_color) {
+    return max_color - value;
+}
+
+// "blur,sharpen" -> {BLUR, SHARPEN}, repetida 'repeat' veces; false (e
+// informa cuál) si algún nombre no es un filtro
+bool parseChain(const char* text, int repeat, std::vector<Filter::FilterType>& chain) {
+    std::vector<Filter::FilterType> names;
+    std::string list(text);
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        if (end > start) {
+            std::string name = list.substr(start, end - start);
+            Filter::FilterType filter_type;
+            if (!Filter::stringToFilterType(name.c_str(), filter_type)) {
+                std::cerr << "Error: Unknown filter '" << name << "'" << std::endl;
+                return false;
+            }
+            names.push_back(filter_type);
+        }
+        start = end + 1;
     }
     
-    // Cargar la imagen
-    if (!image->load(filename)) {
-        delete image;
-        return nullptr;
+    chain.clear();
+    for (int r = 0; r < std::max(1, repeat); r++) {
+        chain.insert(chain.end(), names.begin(), names.end());
     }
-    
-    return image;
+    return true;
 }
 
-Imagen* createOutputImage(Imagen* input_image) {
-    if (!input_image) {
-        return nullptr;
+// Entero positivo completo (sin basura detrás); si no, informa y devuelve false
+bool parsePositive(const char* option, const char* text, int& value) {
+    char* end = nullptr;
+    long parsed = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || parsed <= 0 || parsed > INT_MAX) {
+        std::cerr << "Error: " << option << " needs a positive integer, got '" << text << "'" << std::endl;
+        return false;
     }
-    
-    Imagen* output = nullptr;
-    
-    if (strcmp(input_image->getMagic(), "P2") == 0) {
-        // Crear PGM
-        PGMImage* pgm_input = dynamic_cast<PGMImage*>(input_image);
-        output = pgm_input->clone();
-    } else if (strcmp(input_image->getMagic(), "P3") == 0) {
-        // Crear PPM
-        PPMImage* ppm_input = dynamic_cast<PPMImage*>(input_image);
-        output = ppm_input->clone();
-    }
-    
-    return output;
+    value = static_cast<int>(parsed);
+    return true;
 }
 
 int main(int argc, char* argv[]) {
@@ -87,12 +106,70 @@ int main(int argc, char* argv[]) {
     const char* input_filename = argv[1];
     const char* output_filename = argv[2];
     const char* filter_name = nullptr;
+    int box_radius = -1;
+    const char* profile_path = nullptr;
+    bool force_autotune = false;
+    int block_width = 0, block_height = 0;
+    int iterations = 1;
+    int time_block = IterativeFilter::DEFAULT_TIME_BLOCK;
+    const char* trace_file = nullptr;
+    bool use_counters = false;
+    size_t memory_budget = 0;
+    const char* cache_dir = nullptr;
+    size_t cache_size = ResultCache::DEFAULT_MAX_BYTES;
+    std::vector<DirtyRect> edits;
     
     // Parsear argumentos para filtro
-    for (int i = 3; i < argc - 1; i++) {
-        if (strcmp(argv[i], "--f") == 0 && i + 1 < argc) {
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--autotune") == 0) {
+            force_autotune = true;
+        } else if (strcmp(argv[i], "--counters") == 0) {
+            use_counters = true;
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profile_path = argv[i + 1];
+            i++;
+        } else if (strcmp(argv[i], "--f") == 0 && i + 1 < argc) {
             filter_name = argv[i + 1];
-            break;
+            i++;
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            if (!parsePositive(argv[i], argv[i + 1], iterations)) {
+                return 1;
+            }
+            i++;
+        } else if (strcmp(argv[i], "--time-block") == 0 && i + 1 < argc) {
+            if (!parsePositive(argv[i], argv[i + 1], time_block)) {
+                return 1;
+            }
+            i++;
+        } else if (strcmp(argv[i], "--mem-budget") == 0 && i + 1 < argc) {
+            if (!MemoryTracker::parseSize(argv[i + 1], memory_budget)) {
+                std::cerr << "Error: Invalid memory budget '" << argv[i + 1] << "'" << std::endl;
+                return 1;
+            }
+            i++;
+        } else if (strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc) {
+            if (!MemoryTracker::parseSize(argv[i + 1], cache_size)) {
+                std::cerr << "Error: Invalid cache size '" << argv[i + 1] << "'" << std::endl;
+                return 1;
+            }
+            i++;
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cache_dir = argv[i + 1];
+            i++;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_file = argv[i + 1];
+            i++;
+        } else if (strcmp(argv[i], "--edit") == 0 && i + 1 < argc) {
+            int x, y, w, h;
+            if (sscanf(argv[i + 1], "%d,%d,%dx%d", &x, &y, &w, &h) != 4 || w <= 0 || h <= 0) {
+                std::cerr << "Error: Invalid edit '" << argv[i + 1] << "' (expected X,Y,WxH)" << std::endl;
+                return 1;
+            }
+            edits.push_back(DirtyRect(x, y, x + w, y + h));
+            i++;
+        } else if (strcmp(argv[i], "--box") == 0 && i + 1 < argc) {
+            box_radius = atoi(argv[i + 1]);
+            i++;
         }
     }
     
@@ -100,12 +177,23 @@ int main(int argc, char* argv[]) {
     Timer load_timer;
     Timer process_timer;
     Timer save_timer;
+    PerfCounters counters;
+    if (use_counters) {
+        counters.open();
+    }
+    MemoryTracker memory;
+    MemoryTracker::setBudget(memory_budget);
+    if (cache_dir && !ResultCache::enable(cache_dir, cache_size)) {
+        return 1;
+    }
     
     std::cout << "=== Image Processor ===" << std::endl;
     std::cout << "Input file: " << input_filename << std::endl;
     std::cout << "Output file: " << output_filename << std::endl;
     
-    if (filter_name) {
+    if (box_radius >= 0) {
+        std::cout << "Filter: box blur (radius " << box_radius << ")" << std::endl;
+    } else if (filter_name) {
         std::cout << "Filter: " << filter_name << std::endl;
     } else {
         std::cout << "Operation: Copy image (no filter)" << std::endl;
@@ -114,11 +202,32 @@ int main(int argc, char* argv[]) {
     
     total_timer.start();
     
+    // Con --edit la cadena se aplica entera una vez y luego solo en las zonas editadas
+    const bool incremental_mode = filter_name && !edits.empty() && box_radius < 0;
+    std::vector<Filter::FilterType> chain;
+    if (incremental_mode && !parseChain(filter_name, iterations, chain)) {
+        return 1;
+    }
+    
+    // Entrada y salida (y el buffer extra del ping-pong con --iterations, o
+    // las salidas intermedias de la cadena con --edit)
+    int buffers = iterations > 1 ? 3 : 2;
+    if (incremental_mode) {
+        buffers = 1 + static_cast<int>(chain.size());
+    }
+    if (!ImageFactory::checkMemoryBudget(input_filename, buffers)) {
+        return 1;
+    }
+    
     // Cargar imagen de entrada
     std::cout << "Loading input image..." << std::endl;
+    counters.start();
+    memory.start();
     load_timer.start();
-    Imagen* input_image = createImageFromFile(input_filename);
+    Imagen* input_image = ImageFactory::load(input_filename);
     load_timer.stop();
+    memory.stop();
+    counters.stop();
     
     if (!input_image) {
         std::cerr << "Failed to load input image." << std::endl;
@@ -130,10 +239,23 @@ int main(int argc, char* argv[]) {
     std::cout << "  Dimensions: " << input_image->getWidth() << "x" << input_image->getHeight() << std::endl;
     std::cout << "  Max color value: " << input_image->getMaxColor() << std::endl;
     std::cout << "  Load time: " << load_timer.getElapsedMilliseconds() << " ms" << std::endl;
+    const long long pixels = static_cast<long long>(input_image->getWidth()) * input_image->getHeight();
+    counters.report("Load", pixels, load_timer.getElapsedMilliseconds());
+    memory.report("Load");
     std::cout << std::endl;
     
+    // Bloqueo de caché solo si se pide: sin --autotune ni --profile no se mide ni se escribe nada
+    if (filter_name && iterations <= 1 && !incremental_mode && (force_autotune || profile_path)) {
+        TileProfile profile = TileAutotuner::loadOrTune(profile_path, force_autotune, true);
+        profile.getTileSize(input_image, block_width, block_height);
+        std::cout << std::endl;
+    }
+    
+    // La salida se cuenta en la fase de filtrado
+    memory.start();
+    
     // Crear imagen de salida
-    Imagen* output_image = createOutputImage(input_image);
+    Imagen* output_image = ImageFactory::createOutput(input_image);
     if (!output_image) {
         std::cerr << "Failed to create output image." << std::endl;
         delete input_image;
@@ -141,14 +263,102 @@ int main(int argc, char* argv[]) {
     }
     
     // Aplicar filtro si se especifica
-    if (filter_name) {
+    if (box_radius >= 0) {
+        std::cout << "Applying box blur with integral image (radius " << box_radius << ")..." << std::endl;
+        counters.start();
+        process_timer.start();
+        
+        bool success = IntegralImage::applyBoxBlur(input_image, output_image, box_radius);
+        
+        process_timer.stop();
+        memory.stop();
+        counters.stop();
+        
+        if (!success) {
+            std::cerr << "Failed to apply box blur." << std::endl;
+            delete input_image;
+            delete output_image;
+            return 1;
+        }
+        
+        std::cout << "Box blur applied successfully!" << std::endl;
+        std::cout << "  Processing time: " << process_timer.getElapsedMilliseconds() << " ms" << std::endl;
+        counters.report("Processing", pixels, process_timer.getElapsedMilliseconds());
+        memory.report("Processing");
+        std::cout << std::endl;
+    } else if (incremental_mode) {
+        std::cout << "Applying filter chain: " << filter_name;
+        if (iterations > 1) {
+            std::cout << " (x" << iterations << ")";
+        }
+        std::cout << "..." << std::endl;
+        counters.start();
+        process_timer.start();
+        
+        IncrementalFilter incremental(chain);
+        bool success = incremental.initialize(input_image, output_image);
+        
+        process_timer.stop();
+        memory.stop();
+        counters.stop();
+        
+        if (!success) {
+            std::cerr << "Failed to apply filter." << std::endl;
+            delete input_image;
+            delete output_image;
+            return 1;
+        }
+        
+        std::cout << "Filter applied successfully!" << std::endl;
+        std::cout << "  Processing time: " << process_timer.getElapsedMilliseconds() << " ms" << std::endl;
+        counters.report("Processing", pixels, process_timer.getElapsedMilliseconds());
+        memory.report("Processing");
+        std::cout << std::endl;
+        
+        // Cada retoque invierte un rectángulo de la entrada; la salida se actualiza en el lugar
+        std::cout << "Applying " << edits.size() << " edit(s) incrementally..." << std::endl;
+        double edits_ms = 0.0;
+        for (size_t i = 0; i < edits.size(); i++) {
+            const DirtyRect& edit = edits[i];
+            Filter::applyPointOpRegion(input_image, input_image, invertValue, edit.x0, edit.y0, edit.x1, edit.y1);
+            
+            Timer edit_timer;
+            edit_timer.start();
+            success = incremental.update(input_image, output_image, std::vector<DirtyRect>(1, edit));
+            edit_timer.stop();
+            
+            if (!success) {
+                std::cerr << "Failed to apply edit " << i + 1 << "." << std::endl;
+                delete input_image;
+                delete output_image;
+                return 1;
+            }
+            edits_ms += edit_timer.getElapsedMilliseconds();
+            std::cout << "  Edit " << edit.x1 - edit.x0 << "x" << edit.y1 - edit.y0 << " at (" << edit.x0 << ","
+                      << edit.y0 << "): " << incremental.getLastPixels() << " pixels recomputed in "
+                      << edit_timer.getElapsedMilliseconds() << " ms" << std::endl;
+        }
+        std::cout << "  Mean edit time: " << edits_ms / edits.size() << " ms (full chain: "
+                  << process_timer.getElapsedMilliseconds() << " ms)" << std::endl;
+        std::cout << std::endl;
+    } else if (filter_name) {
         std::cout << "Applying filter: " << filter_name << "..." << std::endl;
+        counters.start();
         process_timer.start();
         
         Filter::FilterType filter_type = Filter::stringToFilterType(filter_name);
-        bool success = Filter::applyFilter(input_image, output_image, filter_type);
+        bool success;
+        if (iterations > 1) {
+            std::cout << "  Iterations: " << iterations << " (" << time_block << " per pass)" << std::endl;
+            success = IterativeFilter::apply(input_image, output_image, filter_type, iterations,
+                                             IterativeFilter::runSequential, 0, 0, time_block);
+        } else {
+            success = Filter::applyFilter(input_image, output_image, filter_type, block_width, block_height);
+        }
         
         process_timer.stop();
+        memory.stop();
+        counters.stop();
         
         if (!success) {
             std::cerr << "Failed to apply filter." << std::endl;
@@ -159,20 +369,31 @@ int main(int argc, char* argv[]) {
         
         std::cout << "Filter applied successfully!" << std::endl;
         std::cout << "  Processing time: " << process_timer.getElapsedMilliseconds() << " ms" << std::endl;
+        counters.report("Processing", pixels, process_timer.getElapsedMilliseconds());
+        memory.report("Processing");
         std::cout << std::endl;
     } else {
         std::cout << "No filter specified, copying image..." << std::endl;
+        counters.start();
         process_timer.start();
         process_timer.stop();
+        memory.stop();
+        counters.stop();
         std::cout << "  Processing time: " << process_timer.getElapsedMilliseconds() << " ms" << std::endl;
+        counters.report("Processing", pixels, process_timer.getElapsedMilliseconds());
+        memory.report("Processing");
         std::cout << std::endl;
     }
     
     // Guardar imagen de salida
     std::cout << "Saving output image..." << std::endl;
+    counters.start();
+    memory.start();
     save_timer.start();
     bool save_success = output_image->save(output_filename);
     save_timer.stop();
+    memory.stop();
+    counters.stop();
     
     if (!save_success) {
         std::cerr << "Failed to save output image." << std::endl;
@@ -185,6 +406,8 @@ int main(int argc, char* argv[]) {
     
     std::cout << "Image saved successfully!" << std::endl;
     std::cout << "  Save time: " << save_timer.getElapsedMilliseconds() << " ms" << std::endl;
+    counters.report("Save", pixels, save_timer.getElapsedMilliseconds());
+    memory.report("Save");
     std::cout << std::endl;
     
     // Mostrar resumen de tiempos
@@ -194,6 +417,19 @@ int main(int argc, char* argv[]) {
     std::cout << "Save time:       " << save_timer.getElapsedMilliseconds() << " ms" << std::endl;
     std::cout << "Total time:      " << total_timer.getElapsedMilliseconds() << " ms" << std::endl;
     
+    if (ResultCache::isEnabled()) {
+        std::cout << std::endl;
+        ResultCache::printStats(std::cout);
+    }
+    
+    if (trace_file) {
+        std::cout << std::endl;
+        Profiler::printSummary();
+        if (Profiler::writeChromeTrace(trace_file)) {
+            std::cout << "Trace written to: " << trace_file << std::endl;
+        }
+    }
+    
     // Limpiar memoria
     delete input_image;
     delete output_image;
@@ -1,50 +1,475 @@
 #include <iostream>
 #include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <climits>
+#include <string>
+#include <vector>
+#include <sstream>
 #include <mpi.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "imagen.h"
 #include "PGMimage.h"
 #include "PPMimage.h"
+#include "synthetic_image.h"
+#include "image_factory.h"
 #include "filter.h"
+#include "mpi_decomposition.h"
+#include "mpi_image_io.h"
+#include "mpi_batch.h"
+#include "mpi_shared_image.h"
+#include "mpi_benchmark.h"
+#include "profiler.h"
+#include "memory_tracker.h"
+#include "result_cache.h"
 #include "timer.h"
 
-Imagen* createImageFromFile(const char* filename) {
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        return nullptr;
+// Una tarea del modo lote: cada trabajador lee, filtra y guarda su imagen
+bool processBatchTask(const BatchTask& task) {
+    Imagen* input_image = ImageFactory::load(task.input.c_str());
+    if (!input_image) {
+        std::cerr << "Error: Cannot load image " << task.input << std::endl;
+        return false;
     }
-    
-    char magic[3];
-    if (fscanf(file, "%2s", magic) != 1) {
-        fclose(file);
-        return nullptr;
+
+    Imagen* output_image = nullptr;
+    if (strcmp(input_image->getMagic(), "P3") == 0) {
+        output_image = new PPMImage();
+    } else {
+        output_image = new PGMImage();
     }
-    fclose(file);
-    
-    Imagen* image = nullptr;
-    if (strcmp(magic, "P2") == 0) {
-        image = new PGMImage();
-    } else if (strcmp(magic, "P3") == 0) {
-        image = new PPMImage();
+
+    Filter::FilterType filter_type = Filter::BLUR;
+    bool success = Filter::stringToFilterType(task.filter.c_str(), filter_type);
+    if (!success) {
+        std::cerr << "Error: Unknown filter '" << task.filter << "'" << std::endl;
     }
-    
-    if (image && image->load(filename)) {
-        return image;
+    success = success && Filter::applyFilter(input_image, output_image, filter_type) &&
+              output_image->save(task.output.c_str());
+
+    delete input_image;
+    delete output_image;
+    return success;
+}
+
+// Modo de memoria compartida: bandas por nodo en ventanas compartidas; solo
+// los líderes de nodo se comunican. Devuelve el código de salida.
+int runSharedMemory(const PnmHeader& header, Filter::FilterType filter_type, int iterations, int group_size,
+                    Imagen* input_image, Imagen* output_image, const char* output_file, double load_ms) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    MpiSharedImage shared(MPI_COMM_WORLD, group_size);
+    if (!shared.setup(header.width, header.height, header.channels, header.max_color)) {
+        return 1;
     }
-    
-    delete image;
-    return nullptr;
+
+    if (rank == 0) {
+        std::cout << "Shared memory: " << shared.getNumNodes() << " node(s), " << shared.getNodeSize()
+                  << " process(es) on node 0" << std::endl;
+    }
+
+    Timer scatter_timer, halo_timer, timer, gather_timer;
+
+    scatter_timer.start();
+    shared.scatter(rank == 0 ? input_image->getPixels() : nullptr);
+    scatter_timer.stop();
+
+    bool success = true;
+    double halo_ms = 0.0;
+    timer.start();
+    for (int it = 0; it < iterations && success; it++) {
+        if (it > 0) {
+            shared.commitResult();
+        }
+        halo_timer.start();
+        shared.exchangeHalos();
+        halo_timer.stop();
+        halo_ms += halo_timer.getElapsedMilliseconds();
+        success = shared.filter(filter_type);
+    }
+    timer.stop();
+
+    if (!success) {
+        return 1;
+    }
+
+    std::cout << "Process " << rank << ": Filter applied in " << timer.getElapsedMilliseconds() << " ms ("
+              << shared.getRows() << " rows at " << shared.getFirstRow()
+              << (shared.isLeader() ? ", node leader" : "") << "; halo " << halo_ms << " ms)" << std::endl;
+
+    gather_timer.start();
+    shared.gather(rank == 0 ? output_image->getPixels() : nullptr);
+    gather_timer.stop();
+
+    if (rank == 0) {
+        Timer save_timer;
+        save_timer.start();
+        bool saved = output_image->save(output_file);
+        save_timer.stop();
+
+        if (!saved) {
+            std::cerr << "Failed to save output" << std::endl;
+            return 1;
+        }
+        std::cout << "Output saved to: " << output_file << std::endl;
+        std::cout << "Phases on process 0: load " << load_ms
+                  << " ms, scatter " << scatter_timer.getElapsedMilliseconds()
+                  << " ms, halo+filter " << timer.getElapsedMilliseconds()
+                  << " ms, gather " << gather_timer.getElapsedMilliseconds()
+                  << " ms, save " << save_timer.getElapsedMilliseconds() << " ms" << std::endl;
+    }
+    return 0;
+}
+
+// Parámetros del modo benchmark
+struct BenchmarkConfig {
+    int repetitions;
+    int weak_width, weak_height;  // tamaño por rango en escalado débil (0 = imagen de entrada)
+    SyntheticImage::Pattern weak_pattern;
+    const char* csv_file;
+    const char* json_file;
+
+    BenchmarkConfig() : repetitions(0), weak_width(0), weak_height(0), weak_pattern(SyntheticImage::NATURAL),
+                        csv_file(nullptr), json_file(nullptr) {}
+};
+
+// Modo benchmark: repite todo el flujo (carga, reparto, halo, filtro,
+// recogida y guardado) con una barrera antes de cada fase y reduce los
+// tiempos de todos los rangos al rango 0. Devuelve el código de salida.
+int runBenchmark(const char* input_file, const char* output_file, const char* filter_name,
+                 MpiDecomposition::Layout layout, bool parallel_io, int iterations, int num_threads,
+                 const BenchmarkConfig& config) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    const bool weak = config.weak_width > 0;
+    Filter::FilterType filter_type = Filter::stringToFilterType(filter_name);
+
+    // Escalado débil: cada rango aporta weak_width x weak_height píxeles y la
+    // imagen crece en filas; la extensión de 'input' elige PGM o PPM
+    PnmHeader header;
+    if (weak) {
+        std::string name(input_file);
+        bool color = name.size() >= 4 && name.compare(name.size() - 4, 4, ".ppm") == 0;
+        header.channels = color ? 3 : 1;
+        header.width = config.weak_width;
+        header.height = config.weak_height * size;
+        header.max_color = 255;
+        header.binary = true;
+    } else if (!MpiImageIO::readHeader(MPI_COMM_WORLD, input_file, header)) {
+        if (rank == 0) {
+            std::cerr << "Error: Cannot load image " << input_file << std::endl;
+        }
+        return 1;
+    }
+
+    const bool use_mpi_io = parallel_io && header.binary && !weak;
+
+    MpiDecomposition decomposition(MPI_COMM_WORLD, layout);
+    LocalBlock block;
+    if (!decomposition.setup(header.width, header.height, header.channels, header.max_color, block)) {
+        return 1;
+    }
+
+    if (rank == 0) {
+        std::cout << "Benchmark: " << config.repetitions << " repetition(s), "
+                  << (weak ? "weak" : "strong") << " scaling, image " << header.width << "x" << header.height
+                  << ", grid " << decomposition.getGridRows() << "x" << decomposition.getGridColumns() << std::endl;
+    }
+
+    MpiBenchmark benchmark(MPI_COMM_WORLD);
+    bool success = true;
+
+    for (int rep = 0; rep < config.repetitions && success; rep++) {
+        Imagen* input_image = nullptr;
+        Imagen* output_image = nullptr;
+
+        benchmark.begin(MpiBenchmark::LOAD);
+        int loaded = 1;
+        if (use_mpi_io) {
+            loaded = MpiImageIO::readBlock(decomposition.getComm(), input_file, header, block) ? 1 : 0;
+        } else if (rank == 0) {
+            if (weak) {
+                SyntheticImage::Spec spec;
+                spec.pattern = config.weak_pattern;
+                spec.width = header.width;
+                spec.height = header.height;
+                spec.channels = header.channels;
+                input_image = SyntheticImage::create(spec);
+            } else {
+                input_image = ImageFactory::load(input_file);
+            }
+            if (input_image) {
+                if (header.channels == 3) {
+                    output_image = new PPMImage();
+                } else {
+                    output_image = new PGMImage();
+                }
+                loaded = Filter::prepareOutput(input_image, output_image) ? 1 : 0;
+            } else {
+                loaded = 0;
+            }
+        }
+        benchmark.end(MpiBenchmark::LOAD);
+
+        MPI_Bcast(&loaded, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        if (!loaded) {
+            if (rank == 0) {
+                std::cerr << "Error: Cannot load image " << input_file << std::endl;
+            }
+            delete input_image;
+            delete output_image;
+            return 1;
+        }
+
+        benchmark.begin(MpiBenchmark::SCATTER);
+        if (!use_mpi_io) {
+            decomposition.scatter(rank == 0 ? input_image->getPixels() : nullptr, block);
+        }
+        benchmark.end(MpiBenchmark::SCATTER);
+
+        // Halo y filtro se miden por separado (sin solapamiento), una muestra por iteración
+        for (int it = 0; it < iterations && success; it++) {
+            if (it > 0) {
+                decomposition.commitResult(block);
+            }
+            benchmark.begin(MpiBenchmark::HALO);
+            decomposition.exchangeHalos(block);
+            benchmark.end(MpiBenchmark::HALO);
+
+            benchmark.begin(MpiBenchmark::COMPUTE);
+            success = decomposition.filter(block, filter_type);
+            benchmark.end(MpiBenchmark::COMPUTE);
+        }
+
+        benchmark.begin(MpiBenchmark::GATHER);
+        if (!use_mpi_io) {
+            decomposition.gather(block, rank == 0 ? output_image->getPixels() : nullptr);
+        }
+        benchmark.end(MpiBenchmark::GATHER);
+
+        benchmark.begin(MpiBenchmark::SAVE);
+        bool saved = true;
+        if (use_mpi_io) {
+            saved = MpiImageIO::writeBlock(decomposition.getComm(), output_file, header, block);
+        } else if (rank == 0) {
+            saved = output_image->save(output_file);
+        }
+        benchmark.end(MpiBenchmark::SAVE);
+
+        delete input_image;
+        delete output_image;
+
+        int local_success = (success && saved) ? 1 : 0;
+        int all_success = 0;
+        MPI_Allreduce(&local_success, &all_success, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+        success = all_success != 0;
+    }
+
+    if (!success) {
+        if (rank == 0) {
+            std::cerr << "Benchmark failed" << std::endl;
+        }
+        return 1;
+    }
+
+    benchmark.reduce();
+
+    if (rank == 0) {
+        std::ostringstream image_size;
+        image_size << header.width << "x" << header.height;
+
+        MpiBenchmark::Labels labels;
+        labels.push_back(std::make_pair("scaling", std::string(weak ? "weak" : "strong")));
+        labels.push_back(std::make_pair("ranks", std::to_string(size)));
+        labels.push_back(std::make_pair("threads", std::to_string(num_threads)));
+        labels.push_back(std::make_pair("layout", std::string(MpiDecomposition::layoutToString(layout))));
+        labels.push_back(std::make_pair("grid", std::to_string(decomposition.getGridRows()) + "x" +
+                                                    std::to_string(decomposition.getGridColumns())));
+        labels.push_back(std::make_pair("io", std::string(use_mpi_io ? "mpi" : "serial")));
+        labels.push_back(std::make_pair("filter", std::string(filter_name)));
+        labels.push_back(std::make_pair("image", image_size.str()));
+        labels.push_back(std::make_pair("channels", std::to_string(header.channels)));
+        labels.push_back(std::make_pair("repetitions", std::to_string(config.repetitions)));
+        labels.push_back(std::make_pair("iterations", std::to_string(iterations)));
+
+        benchmark.print(labels);
+        if (config.csv_file && !benchmark.appendCsv(config.csv_file, labels)) {
+            return 1;
+        }
+        if (config.json_file && !benchmark.appendJson(config.json_file, labels)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Colectiva: reúne las zonas de todos los rangos en una sola traza (un pid
+// por rango, marcas relativas a la primera zona de cualquier rango)
+void writeMpiTrace(const char* trace_file) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    // Un rango sin zonas no debe fijar el origen
+    long long first = Profiler::getFirstTimestamp();
+    if (first == 0) {
+        first = LLONG_MAX;
+    }
+    long long origin = 0;
+    MPI_Allreduce(&first, &origin, 1, MPI_LONG_LONG, MPI_MIN, MPI_COMM_WORLD);
+    std::string events = Profiler::formatTraceEvents(origin);
+
+    int length = static_cast<int>(events.size());
+    std::vector<int> lengths(size), displs(size);
+    MPI_Gather(&length, 1, MPI_INT, lengths.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    int total = 0;
+    if (rank == 0) {
+        for (int r = 0; r < size; r++) {
+            displs[r] = total;
+            total += lengths[r];
+        }
+    }
+    std::vector<char> all(rank == 0 ? total + 1 : 1);
+    MPI_Gatherv(&events[0], length, MPI_CHAR, all.data(), lengths.data(), displs.data(), MPI_CHAR,
+                0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        std::string merged;
+        for (int r = 0; r < size; r++) {
+            if (lengths[r] > 0) {
+                merged += (merged.empty() ? "" : ",\n") + std::string(all.data() + displs[r], lengths[r]);
+            }
+        }
+        std::cout << std::endl;
+        Profiler::printSummary();
+        if (Profiler::writeChromeTrace(trace_file, merged)) {
+            std::cout << "Trace of " << size << " process(es) written to: " << trace_file << std::endl;
+        }
+    }
+}
+
+// Colectiva: el rango 0 imprime el mayor pico de la fase entre todos los
+// procesos (los buffers de imagen son los del proceso 0; el RSS incluye los
+// bloques locales con halo de cada rango)
+void reportMpiMemory(const char* label, const MemoryTracker& memory) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    double local[2] = {MemoryTracker::toMegabytes(memory.getPhasePeakBytes()),
+                       MemoryTracker::toMegabytes(memory.getPhasePeakResidentBytes())};
+    double global[2] = {0.0, 0.0};
+    MPI_Reduce(local, global, 2, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        std::cout << "  " << label << " memory (max over processes): image buffers peak " << global[0]
+                  << " MB, peak RSS " << global[1] << " MB" << std::endl;
+    }
+}
+
+// Colectiva: el rango 0 imprime los aciertos y fallos de la caché de
+// resultados sumados entre los procesos del lote
+void reportBatchCache() {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    ResultCache::Stats stats = ResultCache::getStats();
+    long long local[4] = {stats.hits, stats.misses, stats.stores, stats.evictions};
+    long long global[4] = {0, 0, 0, 0};
+    MPI_Reduce(local, global, 4, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        std::cout << "Result cache (" << size << " process(es)): " << global[0] << " hits, " << global[1]
+                  << " misses, " << global[2] << " stored, " << global[3] << " evicted, "
+                  << MemoryTracker::toMegabytes(ResultCache::getUsedBytes()) << " MB in use" << std::endl;
+    }
+}
+
+void printUsage(const char* program_name) {
+    std::cout << "Usage: mpirun -np N " << program_name << " input output --f filter [--layout rows|blocks] [--io mpi|serial] [--t threads] [--iterations N] [--shm [--shm-group N]]" << std::endl;
+    std::cout << "       mpirun -np N " << program_name << " input output --bench K [--weak WxH[:pattern]] [--csv file] [--json file] [options]" << std::endl;
+    std::cout << "       mpirun -np N " << program_name << " --batch tasks.txt [--cache dir [--cache-size S]]" << std::endl;
+    std::cout << "  --f filter:      Filter to apply (blur, laplace, sharpen)" << std::endl;
+    std::cout << "  --layout rows:   Each process filters a band of rows (default)" << std::endl;
+    std::cout << "  --layout blocks: Processes form a 2D grid of blocks (wide images)" << std::endl;
+    std::cout << "  --io mpi:        Binary P5/P6 files are read and written in parallel with MPI-IO (default)" << std::endl;
+    std::cout << "  --io serial:     Process 0 reads, scatters, gathers and writes the whole image" << std::endl;
+    std::cout << "  --t N:           OpenMP threads per process (hybrid mode, default: 1)" << std::endl;
+    std::cout << "  --iterations N:  Apply the filter N times, exchanging halos between iterations" << std::endl;
+    std::cout << "  --shm:           Processes on a node share one input and one output raster (MPI-3 shared windows)" << std::endl;
+    std::cout << "  --shm-group N:   At most N processes per shared window (e.g. one group per NUMA domain)" << std::endl;
+    std::cout << "  --bench K:       Repeat the whole pipeline K times with barriers between phases and report" << std::endl;
+    std::cout << "                   min/max/mean per phase across processes" << std::endl;
+    std::cout << "  --weak WxH[:pattern]: Weak scaling: synthetic image of W x (H * processes); 'input' only selects .pgm/.ppm" << std::endl;
+    std::cout << "                   pattern: noise, gradient, checkerboard, natural (default)" << std::endl;
+    std::cout << "  --csv file:      Append the benchmark record as a CSV row (header written for new files)" << std::endl;
+    std::cout << "  --json file:     Append the benchmark record as one JSON object per line" << std::endl;
+    std::cout << "  --trace file:    Chrome trace with the profiling zones of every process (one pid per rank);" << std::endl;
+    std::cout << "                   zones are only recorded when built with -DENABLE_PROFILING" << std::endl;
+    std::cout << "  --mem-budget S:  Fail if the image buffers of a process would exceed S bytes (K, M, G suffixes)" << std::endl;
+    std::cout << "  --batch file:    One 'input output filter' task per line, handed out largest-first to idle processes" << std::endl;
+    std::cout << "  --cache dir:     (batch) Reuse filter results stored in dir, shared by all processes" << std::endl;
+    std::cout << "  --cache-size S:  (batch) Size limit of the result cache (default: 1G, LRU eviction)" << std::endl;
 }
 
 int main(int argc, char* argv[]) {
-    MPI_Init(&argc, &argv);
+    // Modo híbrido: solo el hilo principal de cada proceso llama a MPI
+    int thread_support = MPI_THREAD_SINGLE;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &thread_support);
     
     int rank, size;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
+    Profiler::setProcessId(rank);
+
+    // Modo lote: una línea "entrada salida filtro" por tarea. Con --cache los
+    // procesos comparten el directorio de la caché de resultados
+    if (argc >= 3 && strcmp(argv[1], "--batch") == 0) {
+        const char* cache_dir = nullptr;
+        size_t cache_size = ResultCache::DEFAULT_MAX_BYTES;
+        bool options_ok = true;
+        for (int i = 3; i < argc; i++) {
+            if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+                cache_dir = argv[++i];
+            } else if (strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc) {
+                if (!MemoryTracker::parseSize(argv[++i], cache_size)) {
+                    if (rank == 0) {
+                        std::cerr << "Error: Invalid cache size '" << argv[i] << "'" << std::endl;
+                    }
+                    options_ok = false;
+                }
+            }
+        }
+        if (options_ok && cache_dir) {
+            options_ok = ResultCache::enable(cache_dir, cache_size);
+        }
+
+        // Todos los rangos deben poder empezar: run es colectiva
+        int local_ok = options_ok ? 1 : 0;
+        int all_ok = 0;
+        MPI_Allreduce(&local_ok, &all_ok, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+        if (!all_ok) {
+            MPI_Finalize();
+            return 1;
+        }
+
+        bool success = MpiBatch::run(MPI_COMM_WORLD, argv[2], processBatchTask);
+        if (cache_dir) {
+            reportBatchCache();
+        }
+        MPI_Finalize();
+        return success ? 0 : 1;
+    }
     
-    if (argc < 5) {
+    if (argc < 3) {
         if (rank == 0) {
-            std::cout << "Usage: mpirun -np N " << argv[0] << " input output --f filter" << std::endl;
+            printUsage(argv[0]);
         }
         MPI_Finalize();
         return 1;
@@ -52,82 +477,351 @@ int main(int argc, char* argv[]) {
     
     const char* input_file = argv[1];
     const char* output_file = argv[2];
-    const char* filter_name = argv[4]; // Asumiendo --f filter
+    const char* filter_name = "blur";
+    MpiDecomposition::Layout layout = MpiDecomposition::LAYOUT_ROWS;
+    bool parallel_io = true;
+    int num_threads = 1;
+    int iterations = 1;
+    bool shared_memory = false;
+    int shm_group = 0;
+    BenchmarkConfig bench;
+    const char* trace_file = nullptr;
+    size_t memory_budget = 0;
+
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--f") == 0 && i + 1 < argc) {
+            filter_name = argv[++i];
+        } else if (strcmp(argv[i], "--layout") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "rows") != 0 && strcmp(argv[i], "blocks") != 0) {
+                if (rank == 0) {
+                    std::cerr << "Error: Unknown layout " << argv[i] << std::endl;
+                }
+                MPI_Finalize();
+                return 1;
+            }
+            layout = MpiDecomposition::stringToLayout(argv[i]);
+        } else if (strcmp(argv[i], "--io") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "mpi") != 0 && strcmp(argv[i], "serial") != 0) {
+                if (rank == 0) {
+                    std::cerr << "Error: Unknown I/O mode " << argv[i] << std::endl;
+                }
+                MPI_Finalize();
+                return 1;
+            }
+            parallel_io = strcmp(argv[i], "mpi") == 0;
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+            if (iterations < 1) {
+                if (rank == 0) {
+                    std::cerr << "Error: Number of iterations must be at least 1" << std::endl;
+                }
+                MPI_Finalize();
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--shm") == 0) {
+            shared_memory = true;
+        } else if (strcmp(argv[i], "--shm-group") == 0 && i + 1 < argc) {
+            shm_group = atoi(argv[++i]);
+            shared_memory = true;
+        } else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            bench.repetitions = atoi(argv[++i]);
+            if (bench.repetitions < 1) {
+                if (rank == 0) {
+                    std::cerr << "Error: Number of repetitions must be at least 1" << std::endl;
+                }
+                MPI_Finalize();
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--weak") == 0 && i + 1 < argc) {
+            // WxH[:patrón]
+            i++;
+            int consumed = 0;
+            bool valid = sscanf(argv[i], "%dx%d%n", &bench.weak_width, &bench.weak_height, &consumed) == 2 &&
+                         bench.weak_width >= 1 && bench.weak_height >= 1;
+            if (valid && argv[i][consumed] != '\0') {
+                valid = argv[i][consumed] == ':' &&
+                        SyntheticImage::stringToPattern(argv[i] + consumed + 1, bench.weak_pattern);
+            }
+            if (!valid) {
+                if (rank == 0) {
+                    std::cerr << "Error: Invalid weak scaling size " << argv[i] << " (expected WxH[:pattern])" << std::endl;
+                }
+                MPI_Finalize();
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_file = argv[++i];
+        } else if (strcmp(argv[i], "--mem-budget") == 0 && i + 1 < argc) {
+            if (!MemoryTracker::parseSize(argv[++i], memory_budget)) {
+                if (rank == 0) {
+                    std::cerr << "Error: Invalid memory budget '" << argv[i] << "'" << std::endl;
+                }
+                MPI_Finalize();
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            bench.csv_file = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            bench.json_file = argv[++i];
+        } else if (strcmp(argv[i], "--t") == 0 && i + 1 < argc) {
+            num_threads = atoi(argv[++i]);
+            if (num_threads < 1) {
+                if (rank == 0) {
+                    std::cerr << "Error: Number of threads must be at least 1" << std::endl;
+                }
+                MPI_Finalize();
+                return 1;
+            }
+        } else {
+            if (rank == 0) {
+                std::cerr << "Error: Unknown option " << argv[i] << std::endl;
+                printUsage(argv[0]);
+            }
+            MPI_Finalize();
+            return 1;
+        }
+    }
+
+    Filter::FilterType filter_type = Filter::BLUR;
+    if (!Filter::stringToFilterType(filter_name, filter_type)) {
+        if (rank == 0) {
+            std::cerr << "Error: Unknown filter " << filter_name << " (use blur, laplace or sharpen)" << std::endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    MemoryTracker::setBudget(memory_budget);
+
+    if (num_threads > 1 && thread_support < MPI_THREAD_FUNNELED) {
+        if (rank == 0) {
+            std::cerr << "Warning: MPI library lacks MPI_THREAD_FUNNELED, using 1 thread per process" << std::endl;
+        }
+        num_threads = 1;
+    }
+#ifdef _OPENMP
+    omp_set_num_threads(num_threads);
+#else
+    if (num_threads > 1 && rank == 0) {
+        std::cerr << "Warning: Built without OpenMP, using 1 thread per process" << std::endl;
+    }
+    num_threads = 1;
+#endif
+
+    if (bench.repetitions == 0 && (bench.weak_width > 0 || bench.csv_file || bench.json_file)) {
+        // --weak/--csv/--json solo tienen sentido en modo benchmark
+        bench.repetitions = 1;
+    }
+    if (bench.repetitions > 0 && shared_memory) {
+        if (rank == 0) {
+            std::cerr << "Error: --bench does not support --shm" << std::endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
     
     if (rank == 0) {
-        std::cout << "=== Simple MPI Image Processor ===" << std::endl;
+        std::cout << "=== MPI Image Processor ===" << std::endl;
         std::cout << "Processes: " << size << std::endl;
         std::cout << "Input: " << input_file << std::endl;
         std::cout << "Output: " << output_file << std::endl;
         std::cout << "Filter: " << filter_name << std::endl;
+        std::cout << "Layout: " << (shared_memory ? "shared windows per node" : MpiDecomposition::layoutToString(layout))
+                  << std::endl;
+        std::cout << "Ranks x threads: " << size << " x " << num_threads << std::endl;
+        if (iterations > 1) {
+            std::cout << "Iterations: " << iterations << std::endl;
+        }
     }
     
-    // Cada proceso carga la imagen completa (approach simple)
-    Imagen* input_image = createImageFromFile(input_file);
-    if (!input_image) {
+    if (bench.repetitions > 0) {
+        int rc = runBenchmark(input_file, output_file, filter_name, layout, parallel_io, iterations,
+                              num_threads, bench);
+        if (trace_file) {
+            writeMpiTrace(trace_file);
+        }
+        MPI_Finalize();
+        return rc;
+    }
+
+    // El header lo lee el proceso 0 y se difunde
+    PnmHeader header;
+    if (!MpiImageIO::readHeader(MPI_COMM_WORLD, input_file, header)) {
         if (rank == 0) {
             std::cerr << "Error: Cannot load image " << input_file << std::endl;
         }
         MPI_Finalize();
         return 1;
     }
-    
-    // Crear imagen de salida
+
+    // Solo los formatos binarios tienen posiciones fijas para MPI-IO; el modo
+    // de memoria compartida carga en el proceso 0 y reparte por nodos
+    const bool use_mpi_io = parallel_io && header.binary && !shared_memory;
+
+    Timer load_timer;
+    MemoryTracker load_memory, process_memory, save_memory;
+    load_memory.start();
+    load_timer.start();
+
+    // Sin MPI-IO solo el proceso 0 lee la imagen; el resto recibe su trozo
+    Imagen* input_image = nullptr;
     Imagen* output_image = nullptr;
-    if (strcmp(input_image->getMagic(), "P2") == 0) {
-        PGMImage* pgm_input = dynamic_cast<PGMImage*>(input_image);
-        output_image = pgm_input->clone();
-    } else if (strcmp(input_image->getMagic(), "P3") == 0) {
-        PPMImage* ppm_input = dynamic_cast<PPMImage*>(input_image);
-        output_image = ppm_input->clone();
+    int loaded = 1;
+
+    if (!use_mpi_io && rank == 0) {
+        input_image = ImageFactory::load(input_file);
+        if (input_image) {
+            if (header.channels == 3) {
+                output_image = new PPMImage();
+            } else {
+                output_image = new PGMImage();
+            }
+            loaded = Filter::prepareOutput(input_image, output_image) ? 1 : 0;
+        } else {
+            std::cerr << "Error: Cannot load image " << input_file << std::endl;
+            loaded = 0;
+        }
     }
     
-    if (!output_image) {
-        std::cerr << "Process " << rank << ": Failed to create output image" << std::endl;
+    MPI_Bcast(&loaded, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (!loaded) {
         delete input_image;
+        delete output_image;
         MPI_Finalize();
         return 1;
     }
     
     if (rank == 0) {
-        std::cout << "Image loaded: " << input_image->getWidth() << "x" 
-                  << input_image->getHeight() << std::endl;
+        std::cout << "Image: " << header.width << "x" << header.height
+                  << (SyntheticImage::isSpec(input_file) ? " (synthetic)" : header.binary ? " (binary)" : " (ASCII)")
+                  << std::endl;
+        std::cout << "I/O: " << (use_mpi_io ? "MPI-IO (collective)" : "serial (process 0)") << std::endl;
+    }
+
+    if (shared_memory) {
+        load_timer.stop();
+        int rc = runSharedMemory(header, filter_type, iterations, shm_group, input_image, output_image,
+                                 output_file, load_timer.getElapsedMilliseconds());
+        delete input_image;
+        delete output_image;
+        if (trace_file) {
+            writeMpiTrace(trace_file);
+        }
+        MPI_Finalize();
+        return rc;
     }
     
-    // Aplicar filtro usando las funciones existentes
-    Filter::FilterType filter_type = Filter::stringToFilterType(filter_name);
-    
-    Timer timer;
-    timer.start();
-    
-    bool success = Filter::applyFilter(input_image, output_image, filter_type);
+    MpiDecomposition decomposition(MPI_COMM_WORLD, layout);
+    LocalBlock block;
+    if (!decomposition.setup(header.width, header.height, header.channels, header.max_color, block)) {
+        delete input_image;
+        delete output_image;
+        MPI_Finalize();
+        return 1;
+    }
     
-    timer.stop();
+    if (rank == 0) {
+        std::cout << "Process grid: " << decomposition.getGridRows() << "x"
+                  << decomposition.getGridColumns() << std::endl;
+    }
+
+    if (use_mpi_io) {
+        bool read = MpiImageIO::readBlock(decomposition.getComm(), input_file, header, block);
+        if (!read) {
+            MPI_Finalize();
+            return 1;
+        }
+    }
+    load_timer.stop();
+    load_memory.stop();
+
+    // Repartir, intercambiar halos mientras se filtra el interior y recoger
+    Timer scatter_timer, gather_timer;
+    OverlapTiming timing;
+
+    process_memory.start();
+    scatter_timer.start();
+    if (!use_mpi_io) {
+        decomposition.scatter(rank == 0 ? input_image->getPixels() : nullptr, block);
+    }
+    scatter_timer.stop();
+
+    // Cada iteración intercambia los halos del resultado anterior
+    bool success = true;
+    for (int it = 0; it < iterations && success; it++) {
+        if (it > 0) {
+            decomposition.commitResult(block);
+        }
+        OverlapTiming step;
+        success = decomposition.exchangeAndFilter(block, filter_type, step);
+        timing += step;
+    }
     
-    if (!success) {
-        std::cerr << "Process " << rank << ": Filter failed" << std::endl;
+    int all_success = 0;
+    int local_success = success ? 1 : 0;
+    MPI_Allreduce(&local_success, &all_success, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    if (!all_success) {
+        if (!success) {
+            std::cerr << "Process " << rank << ": Filter failed" << std::endl;
+        }
         delete input_image;
         delete output_image;
         MPI_Finalize();
         return 1;
     }
     
-    std::cout << "Process " << rank << ": Filter applied in " 
-              << timer.getElapsedMilliseconds() << " ms" << std::endl;
+    std::cout << "Process " << rank << ": Filter applied in " << timing.total << " ms ("
+              << block.width << "x" << block.height << " at " << block.x0 << "," << block.y0
+              << "; interior " << timing.interior << " ms, boundary " << timing.boundary << " ms)" << std::endl;
+    std::cout << "Process " << rank << ": Halo communication " << timing.comm << " ms, hidden "
+              << timing.hidden << " ms (" << (timing.comm > 0 ? 100.0 * timing.hidden / timing.comm : 100.0)
+              << "%), exposed " << timing.exposed << " ms" << std::endl;
+
+    gather_timer.start();
+    if (!use_mpi_io) {
+        decomposition.gather(block, rank == 0 ? output_image->getPixels() : nullptr);
+    }
+    gather_timer.stop();
+    process_memory.stop();
     
-    // Solo el proceso 0 guarda el resultado
+    // Con MPI-IO cada proceso escribe su región; si no, solo el proceso 0 guarda
+    Timer save_timer;
+    save_memory.start();
+    save_timer.start();
+    bool saved = true;
+    if (use_mpi_io) {
+        saved = MpiImageIO::writeBlock(decomposition.getComm(), output_file, header, block);
+    } else if (rank == 0) {
+        saved = output_image->save(output_file);
+    }
+    save_timer.stop();
+    save_memory.stop();
+
     if (rank == 0) {
-        bool saved = output_image->save(output_file);
         if (saved) {
             std::cout << "Output saved to: " << output_file << std::endl;
         } else {
             std::cerr << "Failed to save output" << std::endl;
         }
+
+        std::cout << "Phases on process 0: load " << load_timer.getElapsedMilliseconds()
+                  << " ms, scatter " << scatter_timer.getElapsedMilliseconds()
+                  << " ms, halo+filter " << timing.total
+                  << " ms, gather " << gather_timer.getElapsedMilliseconds()
+                  << " ms, save " << save_timer.getElapsedMilliseconds() << " ms" << std::endl;
     }
+    reportMpiMemory("Load", load_memory);
+    reportMpiMemory("Scatter+filter+gather", process_memory);
+    reportMpiMemory("Save", save_memory);
     
     delete input_image;
     delete output_image;
+
+    if (trace_file) {
+        writeMpiTrace(trace_file);
+    }
     
     MPI_Finalize();
     return 0;
-}
\ No newline at end of file
+}
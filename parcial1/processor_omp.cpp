@@ -1,77 +1,67 @@
 #include <iostream>
 #include <cstring>
+#include <cstdlib>
+#include <climits>
 #include <omp.h>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include "imagen.h"
-#include "PGMimage.h"
-#include "PPMimage.h"
+#include "image_factory.h"
 #include "filter.h"
+#include "iterative_filter.h"
+#include "omp_filter.h"
 #include "timer.h"
+#include "profiler.h"
+#include "perf_counters.h"
+#include "memory_tracker.h"
+#include "result_cache.h"
+
+// Forma de repartir el trabajo entre los hilos de OpenMP
+enum ParallelMode {
+    MODE_SECTIONS,  // un hilo por filtro (omp parallel sections)
+    MODE_DATA,      // los filtros uno tras otro, cada uno con omp parallel for sobre las filas
+    MODE_NESTED     // un equipo por filtro y, dentro, parallel for anidado
+};
+
+// Trabajo de un filtro: tipo, imagen de salida y archivo destino
+struct FilterJob {
+    Filter::FilterType type;
+    Imagen* output;
+    std::string filename;
+    bool success;
+    bool saved;
+};
 
 void printUsage(const char* program_name) {
-    std::cout << "Usage: " << program_name << " input_file output_prefix" << std::endl;
+    std::cout << "Usage: " << program_name << " input_file output [--f filter] [--t threads]" << std::endl;
+    std::cout << "       [--mode sections|data|nested] [--schedule static|dynamic|guided[,chunk]]" << std::endl;
     std::cout << "  input_file:   Input image file (PPM or PGM)" << std::endl;
-    std::cout << "  output_prefix: Prefix for output files" << std::endl;
-    std::cout << "  The program will generate 3 output files:" << std::endl;
+    std::cout << "  output:       Output file with --f, otherwise prefix for output files" << std::endl;
+    std::cout << "  --f filter:   Apply only this filter (blur, laplace, sharpen)" << std::endl;
+    std::cout << "  --t threads:  Number of OpenMP threads (default: OMP_NUM_THREADS)" << std::endl;
+    std::cout << "  --mode m:     sections = one thread per filter" << std::endl;
+    std::cout << "                data     = parallel for over pixel rows (default)" << std::endl;
+    std::cout << "                nested   = one team per filter with nested parallel for" << std::endl;
+    std::cout << "  --schedule s: Loop schedule for data/nested modes (default: static)" << std::endl;
+    std::cout << "  --iterations N: Apply each filter N times (ping-pong buffers, temporal blocking)" << std::endl;
+    std::cout << "  --time-block T: Iterations per pass over the image (default: "
+              << IterativeFilter::DEFAULT_TIME_BLOCK << ")" << std::endl;
+    std::cout << "  --trace f:    Write a Chrome trace of the profiling zones to f and print a summary" << std::endl;
+    std::cout << "                (zones are only recorded when built with -DENABLE_PROFILING)" << std::endl;
+    std::cout << "  --counters:   Report hardware counters (IPC, cache/branch misses per pixel) per phase" << std::endl;
+    std::cout << "  --mem-budget S: Fail if the image buffers would exceed S bytes (K, M, G suffixes)" << std::endl;
+    std::cout << "  --cache dir: Reuse filter results stored in dir (content-addressed, LRU eviction)" << std::endl;
+    std::cout << "  --cache-size S: Size limit of the result cache (default: 1G)" << std::endl;
+    std::cout << "  Without --f the program will generate 3 output files:" << std::endl;
     std::cout << "    - output_prefix_blur.ext" << std::endl;
     std::cout << "    - output_prefix_laplace.ext" << std::endl;
     std::cout << "    - output_prefix_sharpen.ext" << std::endl;
     std::cout << std::endl;
     std::cout << "Examples:" << std::endl;
     std::cout << "  " << program_name << " lena.ppm lena_result" << std::endl;
-    std::cout << "  " << program_name << " fruit.pgm fruit_result" << std::endl;
-}
-
-Imagen* createImageFromFile(const char* filename) {
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        std::cerr << "Error: Cannot open file " << filename << std::endl;
-        return nullptr;
-    }
-    
-    char magic[3];
-    if (fscanf(file, "%2s", magic) != 1) {
-        std::cerr << "Error: Cannot read magic number from " << filename << std::endl;
-        fclose(file);
-        return nullptr;
-    }
-    fclose(file);
-    
-    Imagen* image = nullptr;
-    
-    if (strcmp(magic, "P2") == 0) {
-        image = new PGMImage();
-    } else if (strcmp(magic, "P3") == 0) {
-        image = new PPMImage();
-    } else {
-        std::cerr << "Error: Unsupported image format. Only P2 (PGM) and P3 (PPM) are supported." << std::endl;
-        return nullptr;
-    }
-    
-    if (!image->load(filename)) {
-        delete image;
-        return nullptr;
-    }
-    
-    return image;
-}
-
-Imagen* createOutputImage(Imagen* input_image) {
-    if (!input_image) {
-        return nullptr;
-    }
-    
-    Imagen* output = nullptr;
-    
-    if (strcmp(input_image->getMagic(), "P2") == 0) {
-        PGMImage* pgm_input = dynamic_cast<PGMImage*>(input_image);
-        output = pgm_input->clone();
-    } else if (strcmp(input_image->getMagic(), "P3") == 0) {
-        PPMImage* ppm_input = dynamic_cast<PPMImage*>(input_image);
-        output = ppm_input->clone();
-    }
-    
-    return output;
+    std::cout << "  " << program_name << " fruit.pgm fruit_result --mode nested --t 8" << std::endl;
+    std::cout << "  " << program_name << " fruit.pgm fruit_blur.pgm --f blur --t 16 --schedule dynamic,4" << std::endl;
 }
 
 std::string getFileExtension(const char* filename) {
@@ -83,6 +73,18 @@ std::string getFileExtension(const char* filename) {
     return "";
 }
 
+// Entero positivo completo (sin basura detrás); si no, informa y devuelve false
+bool parsePositive(const char* option, const char* text, int& value) {
+    char* end = nullptr;
+    long parsed = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || parsed <= 0 || parsed > INT_MAX) {
+        std::cerr << "Error: " << option << " needs a positive integer, got '" << text << "'" << std::endl;
+        return false;
+    }
+    value = static_cast<int>(parsed);
+    return true;
+}
+
 int main(int argc, char* argv[]) {
     if (argc < 3) {
         printUsage(argv[0]);
@@ -90,25 +92,137 @@ int main(int argc, char* argv[]) {
     }
     
     const char* input_filename = argv[1];
-    const char* output_prefix = argv[2];
+    const char* output_name = argv[2];
+    const char* filter_name = nullptr;
+    int num_threads = 0;
+    ParallelMode mode = MODE_DATA;
+    omp_sched_t schedule_kind = omp_sched_static;
+    int schedule_chunk = 0;
+    int iterations = 1;
+    int time_block = IterativeFilter::DEFAULT_TIME_BLOCK;
+    const char* trace_file = nullptr;
+    bool use_counters = false;
+    size_t memory_budget = 0;
+    const char* cache_dir = nullptr;
+    size_t cache_size = ResultCache::DEFAULT_MAX_BYTES;
+    
+    // Parsear argumentos opcionales
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--counters") == 0) {
+            use_counters = true;
+        } else if (i + 1 >= argc) {
+            break;
+        } else if (strcmp(argv[i], "--f") == 0) {
+            filter_name = argv[++i];
+        } else if (strcmp(argv[i], "--t") == 0) {
+            if (!parsePositive(argv[i], argv[i + 1], num_threads)) {
+                return 1;
+            }
+            i++;
+        } else if (strcmp(argv[i], "--iterations") == 0) {
+            if (!parsePositive(argv[i], argv[i + 1], iterations)) {
+                return 1;
+            }
+            i++;
+        } else if (strcmp(argv[i], "--mem-budget") == 0) {
+            if (!MemoryTracker::parseSize(argv[++i], memory_budget)) {
+                std::cerr << "Error: Invalid memory budget '" << argv[i] << "'" << std::endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--cache-size") == 0) {
+            if (!MemoryTracker::parseSize(argv[++i], cache_size)) {
+                std::cerr << "Error: Invalid cache size '" << argv[i] << "'" << std::endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--cache") == 0) {
+            cache_dir = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0) {
+            trace_file = argv[++i];
+        } else if (strcmp(argv[i], "--time-block") == 0) {
+            if (!parsePositive(argv[i], argv[i + 1], time_block)) {
+                return 1;
+            }
+            i++;
+        } else if (strcmp(argv[i], "--mode") == 0) {
+            const char* mode_name = argv[++i];
+            if (strcmp(mode_name, "sections") == 0) {
+                mode = MODE_SECTIONS;
+            } else if (strcmp(mode_name, "nested") == 0) {
+                mode = MODE_NESTED;
+            } else {
+                mode = MODE_DATA;
+            }
+        } else if (strcmp(argv[i], "--schedule") == 0) {
+            if (!OmpFilter::parseSchedule(argv[++i], schedule_kind, schedule_chunk)) {
+                std::cerr << "Warning: Unknown schedule '" << argv[i] << "', using static" << std::endl;
+                schedule_kind = omp_sched_static;
+                schedule_chunk = 0;
+            }
+        }
+    }
+    
+    // Los contadores se abren antes de la primera región paralela para que
+    // los hilos del equipo de OpenMP los hereden
+    PerfCounters counters;
+    if (use_counters) {
+        counters.open();
+    }
+    MemoryTracker memory;
+    MemoryTracker::setBudget(memory_budget);
+    if (cache_dir && !ResultCache::enable(cache_dir, cache_size)) {
+        return 1;
+    }
+    
+    // Configurar OpenMP según los argumentos
+    if (num_threads > 0) {
+        omp_set_num_threads(num_threads);
+    }
+    num_threads = omp_get_max_threads();
+    omp_set_schedule(schedule_kind, schedule_chunk);
+    if (mode == MODE_NESTED) {
+        omp_set_max_active_levels(2);
+    }
     
     Timer total_timer;
     Timer load_timer;
     Timer process_timer;
     
+    const char* mode_names[] = {"sections", "data", "nested"};
+    
     std::cout << "=== OpenMP Image Processor ===" << std::endl;
     std::cout << "Input file: " << input_filename << std::endl;
-    std::cout << "Output prefix: " << output_prefix << std::endl;
-    std::cout << "Number of OpenMP threads available: " << omp_get_max_threads() << std::endl;
+    std::cout << (filter_name ? "Output file: " : "Output prefix: ") << output_name << std::endl;
+    std::cout << "Number of OpenMP threads: " << num_threads << std::endl;
+    std::cout << "Mode: " << mode_names[mode];
+    if (mode != MODE_SECTIONS) {
+        std::cout << ", schedule(" << OmpFilter::scheduleToString(schedule_kind);
+        if (schedule_chunk > 0) {
+            std::cout << "," << schedule_chunk;
+        }
+        std::cout << ")";
+    }
+    std::cout << std::endl;
+    if (iterations > 1) {
+        std::cout << "Iterations: " << iterations << " (" << time_block << " per pass)" << std::endl;
+    }
     std::cout << std::endl;
     
     total_timer.start();
     
+    // Entrada y salida (y el buffer extra del ping-pong con --iterations)
+    if (!ImageFactory::checkMemoryBudget(input_filename, 1 + (filter_name ? 1 : 3) * (iterations > 1 ? 2 : 1))) {
+        return 1;
+    }
+    
     // Cargar imagen de entrada
     std::cout << "Loading input image..." << std::endl;
+    counters.start();
+    memory.start();
     load_timer.start();
-    Imagen* input_image = createImageFromFile(input_filename);
+    Imagen* input_image = ImageFactory::load(input_filename);
     load_timer.stop();
+    memory.stop();
+    counters.stop();
     
     if (!input_image) {
         std::cerr << "Failed to load input image." << std::endl;
@@ -120,162 +234,193 @@ int main(int argc, char* argv[]) {
     std::cout << "  Dimensions: " << input_image->getWidth() << "x" << input_image->getHeight() << std::endl;
     std::cout << "  Max color value: " << input_image->getMaxColor() << std::endl;
     std::cout << "  Load time: " << load_timer.getElapsedMilliseconds() << " ms" << std::endl;
+    const long long pixels = static_cast<long long>(input_image->getWidth()) * input_image->getHeight();
+    counters.report("Load", pixels, load_timer.getElapsedMilliseconds());
+    memory.report("Load");
     std::cout << std::endl;
     
-    // Obtener extensión del archivo
-    std::string extension = getFileExtension(input_filename);
+    // La salida se cuenta en la fase de filtrado
+    memory.start();
     
-    // Crear nombres de archivos de salida
-    std::string blur_filename = std::string(output_prefix) + "_blur" + extension;
-    std::string laplace_filename = std::string(output_prefix) + "_laplace" + extension;
-    std::string sharpen_filename = std::string(output_prefix) + "_sharpen" + extension;
+    // Crear la lista de filtros: uno con --f, los tres si no
+    std::vector<FilterJob> jobs;
+    if (filter_name) {
+        FilterJob job = {Filter::stringToFilterType(filter_name), nullptr, output_name, false, false};
+        jobs.push_back(job);
+    } else {
+        std::string extension = getFileExtension(input_filename);
+        Filter::FilterType all_types[] = {Filter::BLUR, Filter::LAPLACE, Filter::SHARPEN};
+        for (int i = 0; i < 3; i++) {
+            FilterJob job = {all_types[i], nullptr,
+                             std::string(output_name) + "_" + Filter::filterTypeToString(all_types[i]) + extension,
+                             false, false};
+            jobs.push_back(job);
+        }
+    }
     
-    // Crear imágenes de salida (una por cada filtro)
-    Imagen* blur_output = createOutputImage(input_image);
-    Imagen* laplace_output = createOutputImage(input_image);
-    Imagen* sharpen_output = createOutputImage(input_image);
+    const int num_jobs = static_cast<int>(jobs.size());
+    bool outputs_ok = true;
+    for (int i = 0; i < num_jobs; i++) {
+        jobs[i].output = ImageFactory::createOutput(input_image);
+        outputs_ok = outputs_ok && jobs[i].output;
+    }
     
-    if (!blur_output || !laplace_output || !sharpen_output) {
+    if (!outputs_ok) {
         std::cerr << "Failed to create output images." << std::endl;
         delete input_image;
-        delete blur_output;
-        delete laplace_output;
-        delete sharpen_output;
+        for (int i = 0; i < num_jobs; i++) {
+            delete jobs[i].output;
+        }
         return 1;
     }
     
     // Aplicar filtros en paralelo usando OpenMP
     std::cout << "Applying filters in parallel..." << std::endl;
+    counters.start();
     process_timer.start();
     
-    bool success[3] = {false, false, false};
-    
-    // Usar parallel sections para aplicar cada filtro en un hilo diferente
-    #pragma omp parallel sections num_threads(3)
-    {
-        #pragma omp section
-        {
-            int thread_id = omp_get_thread_num();
-            std::cout << "Thread " << thread_id << " applying BLUR filter..." << std::endl;
-            success[0] = Filter::applyFilter(input_image, blur_output, Filter::BLUR);
-            if (success[0]) {
-                std::cout << "Thread " << thread_id << " completed BLUR filter" << std::endl;
-            }
+    if (mode == MODE_DATA) {
+        // Cada filtro usa todos los hilos sobre sus filas
+        for (int i = 0; i < num_jobs; i++) {
+            jobs[i].success = OmpFilter::apply(input_image, jobs[i].output, jobs[i].type, num_threads,
+                                               iterations, time_block);
         }
+    } else {
+        // Un hilo (sections) o un equipo (nested) por filtro
+        int outer_threads = std::min(num_jobs, num_threads);
+        int inner_threads = (mode == MODE_NESTED) ? std::max(1, num_threads / num_jobs) : 1;
         
-        #pragma omp section
-        {
+        #pragma omp parallel for schedule(static, 1) num_threads(outer_threads)
+        for (int i = 0; i < num_jobs; i++) {
             int thread_id = omp_get_thread_num();
-            std::cout << "Thread " << thread_id << " applying LAPLACE filter..." << std::endl;
-            success[1] = Filter::applyFilter(input_image, laplace_output, Filter::LAPLACE);
-            if (success[1]) {
-                std::cout << "Thread " << thread_id << " completed LAPLACE filter" << std::endl;
+            const char* name = Filter::filterTypeToString(jobs[i].type);
+            
+            #pragma omp critical(log)
+            std::cout << "Thread " << thread_id << " applying " << name << " filter with "
+                      << inner_threads << " inner thread(s)..." << std::endl;
+            
+            if (inner_threads > 1 || iterations > 1) {
+                jobs[i].success = OmpFilter::apply(input_image, jobs[i].output, jobs[i].type, inner_threads,
+                                                   iterations, time_block);
+            } else {
+                jobs[i].success = Filter::applyFilter(input_image, jobs[i].output, jobs[i].type);
             }
-        }
-        
-        #pragma omp section
-        {
-            int thread_id = omp_get_thread_num();
-            std::cout << "Thread " << thread_id << " applying SHARPEN filter..." << std::endl;
-            success[2] = Filter::applyFilter(input_image, sharpen_output, Filter::SHARPEN);
-            if (success[2]) {
-                std::cout << "Thread " << thread_id << " completed SHARPEN filter" << std::endl;
+            
+            if (jobs[i].success) {
+                #pragma omp critical(log)
+                std::cout << "Thread " << thread_id << " completed " << name << " filter" << std::endl;
             }
         }
     }
     
     process_timer.stop();
+    memory.stop();
+    counters.stop();
     
     // Verificar que todos los filtros se aplicaron correctamente
-    if (!success[0] || !success[1] || !success[2]) {
+    bool all_success = true;
+    for (int i = 0; i < num_jobs; i++) {
+        all_success = all_success && jobs[i].success;
+    }
+    
+    if (!all_success) {
         std::cerr << "Error: One or more filters failed to apply." << std::endl;
-        if (!success[0]) std::cerr << "  - BLUR filter failed" << std::endl;
-        if (!success[1]) std::cerr << "  - LAPLACE filter failed" << std::endl;
-        if (!success[2]) std::cerr << "  - SHARPEN filter failed" << std::endl;
+        for (int i = 0; i < num_jobs; i++) {
+            if (!jobs[i].success) {
+                std::cerr << "  - " << Filter::filterTypeToString(jobs[i].type) << " filter failed" << std::endl;
+            }
+        }
         
         delete input_image;
-        delete blur_output;
-        delete laplace_output;
-        delete sharpen_output;
+        for (int i = 0; i < num_jobs; i++) {
+            delete jobs[i].output;
+        }
         return 1;
     }
     
     std::cout << "All filters applied successfully!" << std::endl;
     std::cout << "  Processing time: " << process_timer.getElapsedMilliseconds() << " ms" << std::endl;
+    counters.report("Processing", pixels * num_jobs, process_timer.getElapsedMilliseconds());
+    memory.report("Processing");
     std::cout << std::endl;
     
-    // Guardar imágenes de salida en paralelo
+    // Guardar imágenes de salida en paralelo (un archivo por hilo)
     std::cout << "Saving output images..." << std::endl;
     Timer save_timer;
+    counters.start();
+    memory.start();
     save_timer.start();
     
-    bool save_success[3] = {false, false, false};
-    
-    #pragma omp parallel sections num_threads(3)
-    {
-        #pragma omp section
-        {
-            int thread_id = omp_get_thread_num();
-            save_success[0] = blur_output->save(blur_filename.c_str());
-            if (save_success[0]) {
-                std::cout << "Thread " << thread_id << " saved: " << blur_filename << std::endl;
-            }
-        }
-        
-        #pragma omp section
-        {
-            int thread_id = omp_get_thread_num();
-            save_success[1] = laplace_output->save(laplace_filename.c_str());
-            if (save_success[1]) {
-                std::cout << "Thread " << thread_id << " saved: " << laplace_filename << std::endl;
-            }
-        }
-        
-        #pragma omp section
-        {
-            int thread_id = omp_get_thread_num();
-            save_success[2] = sharpen_output->save(sharpen_filename.c_str());
-            if (save_success[2]) {
-                std::cout << "Thread " << thread_id << " saved: " << sharpen_filename << std::endl;
-            }
+    #pragma omp parallel for schedule(static, 1) num_threads(std::min(num_jobs, num_threads))
+    for (int i = 0; i < num_jobs; i++) {
+        int thread_id = omp_get_thread_num();
+        jobs[i].saved = jobs[i].output->save(jobs[i].filename.c_str());
+        if (jobs[i].saved) {
+            #pragma omp critical(log)
+            std::cout << "Thread " << thread_id << " saved: " << jobs[i].filename << std::endl;
         }
     }
     
     save_timer.stop();
+    memory.stop();
+    counters.stop();
+    
+    bool all_saved = true;
+    for (int i = 0; i < num_jobs; i++) {
+        all_saved = all_saved && jobs[i].saved;
+    }
     
-    if (!save_success[0] || !save_success[1] || !save_success[2]) {
+    if (!all_saved) {
         std::cerr << "Error: Failed to save one or more output images." << std::endl;
-        if (!save_success[0]) std::cerr << "  - Failed to save: " << blur_filename << std::endl;
-        if (!save_success[1]) std::cerr << "  - Failed to save: " << laplace_filename << std::endl;
-        if (!save_success[2]) std::cerr << "  - Failed to save: " << sharpen_filename << std::endl;
+        for (int i = 0; i < num_jobs; i++) {
+            if (!jobs[i].saved) {
+                std::cerr << "  - Failed to save: " << jobs[i].filename << std::endl;
+            }
+        }
         
         delete input_image;
-        delete blur_output;
-        delete laplace_output;
-        delete sharpen_output;
+        for (int i = 0; i < num_jobs; i++) {
+            delete jobs[i].output;
+        }
         return 1;
     }
     
     total_timer.stop();
+    counters.report("Save", pixels * num_jobs, save_timer.getElapsedMilliseconds());
+    memory.report("Save");
     
     std::cout << std::endl;
     std::cout << "=== Performance Summary ===" << std::endl;
+    std::cout << "Threads:         " << num_threads << std::endl;
     std::cout << "Load time:       " << load_timer.getElapsedMilliseconds() << " ms" << std::endl;
     std::cout << "Processing time: " << process_timer.getElapsedMilliseconds() << " ms" << std::endl;
     std::cout << "Save time:       " << save_timer.getElapsedMilliseconds() << " ms" << std::endl;
     std::cout << "Total time:      " << total_timer.getElapsedMilliseconds() << " ms" << std::endl;
     std::cout << std::endl;
     
+    if (ResultCache::isEnabled()) {
+        ResultCache::printStats(std::cout);
+        std::cout << std::endl;
+    }
+    
     std::cout << "Output files generated:" << std::endl;
-    std::cout << "  - " << blur_filename << std::endl;
-    std::cout << "  - " << laplace_filename << std::endl;
-    std::cout << "  - " << sharpen_filename << std::endl;
+    for (int i = 0; i < num_jobs; i++) {
+        std::cout << "  - " << jobs[i].filename << std::endl;
+    }
+    
+    if (trace_file) {
+        std::cout << std::endl;
+        Profiler::printSummary();
+        if (Profiler::writeChromeTrace(trace_file)) {
+            std::cout << "Trace written to: " << trace_file << std::endl;
+        }
+    }
     
     // Limpiar memoria
     delete input_image;
-    delete blur_output;
-    delete laplace_output;
-    delete sharpen_output;
+    for (int i = 0; i < num_jobs; i++) {
+        delete jobs[i].output;
+    }
     
     return 0;
 }
\ No newline at end of file
@@ -1,278 +1,66 @@
 #include <iostream>
 #include <cstring>
+#include <cstdlib>
+#include <climits>
 #include <pthread.h>
-#include <vector>
 #include "imagen.h"
-#include "PGMimage.h"
-#include "PPMimage.h"
+#include "image_factory.h"
 #include "filter.h"
+#include "numa_memory.h"
+#include "thread_pool.h"
+#include "tile_scheduler.h"
+#include "pthread_filter.h"
+#include "tile_autotuner.h"
+#include "iterative_filter.h"
 #include "timer.h"
+#include "profiler.h"
+#include "perf_counters.h"
+#include "memory_tracker.h"
+#include "result_cache.h"
 
-#define NUM_THREADS 4
-
-struct ThreadData {
-    Imagen* input;
-    Imagen* output;
-    Filter::FilterType filter_type;
-    int thread_id;
-    int start_row;
-    int end_row;
-    int width;
-    int height;
-    const float (*kernel)[3];
-    bool success;
+// Estrategia de reparto del trabajo entre los hilos del pool
+enum Schedule {
+    SCHEDULE_ROWS,   // un bloque estático de filas por hilo
+    SCHEDULE_TILES   // tiles 2D con robo de trabajo
 };
 
 void printUsage(const char* program_name) {
-    std::cout << "Usage: " << program_name << " input_file output_file [--f filter_type]" << std::endl;
+    std::cout << "Usage: " << program_name << " input_file output_file [--f filter_type] [--t threads]" << std::endl;
     std::cout << "  input_file:  Input image file (PPM or PGM)" << std::endl;
     std::cout << "  output_file: Output image file" << std::endl;
     std::cout << "  --f filter:  Filter to apply (blur, laplace, sharpen)" << std::endl;
     std::cout << "               If no filter specified, image will be copied" << std::endl;
-    std::cout << std::endl;
-    std::cout << "This version uses " << NUM_THREADS << " threads (pthreads)" << std::endl;
-}
-
-const float* getKernel(Filter::FilterType filter_type) {
-    static const float blur_kernel[3][3] = {
-        {1.0f/9.0f, 1.0f/9.0f, 1.0f/9.0f},
-        {1.0f/9.0f, 1.0f/9.0f, 1.0f/9.0f},
-        {1.0f/9.0f, 1.0f/9.0f, 1.0f/9.0f}
-    };
-    
-    static const float laplace_kernel[3][3] = {
-        {0.0f, -1.0f, 0.0f},
-        {-1.0f, 4.0f, -1.0f},
-        {0.0f, -1.0f, 0.0f}
-    };
-    
-    static const float sharpen_kernel[3][3] = {
-        {0.0f, -1.0f, 0.0f},
-        {-1.0f, 5.0f, -1.0f},
-        {0.0f, -1.0f, 0.0f}
-    };
-    
-    switch (filter_type) {
-        case Filter::BLUR:
-            return (const float*)blur_kernel;
-        case Filter::LAPLACE:
-            return (const float*)laplace_kernel;
-        case Filter::SHARPEN:
-            return (const float*)sharpen_kernel;
-        default:
-            return (const float*)blur_kernel;
-    }
+    std::cout << "  --t threads: Number of pool threads (default: " << ThreadPool::getHardwareConcurrency() << ")" << std::endl;
+    std::cout << "  --sched s:   Work distribution: rows or tiles (default: tiles)" << std::endl;
+    std::cout << "  --tile WxH:  Tile size for --sched tiles (default: sized to the caches, or the tile profile)" << std::endl;
+    std::cout << "  --profile p: Use the tile sizes in profile p (searched and saved there if missing)" << std::endl;
+    std::cout << "  --autotune:  Search the tile size and save it to the profile (default: "
+              << TileAutotuner::DEFAULT_PROFILE_PATH << ")" << std::endl;
+    std::cout << "  --iterations N: Apply the filter N times (ping-pong buffers, temporal blocking)" << std::endl;
+    std::cout << "  --time-block T: Iterations per pass over the image (default: "
+              << IterativeFilter::DEFAULT_TIME_BLOCK << ")" << std::endl;
+    std::cout << "  --numa p:    Buffer placement: first-touch, interleave or default (default: first-touch)" << std::endl;
+    std::cout << "  --hugepages: Use transparent huge pages for large rasters" << std::endl;
+    std::cout << "  --pin:       Pin each pool thread to its own CPU" << std::endl;
+    std::cout << "  --numa-report: Print on which NUMA node the image pages ended up" << std::endl;
+    std::cout << "  --trace f:   Write a Chrome trace of the profiling zones to f and print a summary" << std::endl;
+    std::cout << "               (zones are only recorded when built with -DENABLE_PROFILING)" << std::endl;
+    std::cout << "  --counters:  Report hardware counters (IPC, cache/branch misses per pixel) per phase" << std::endl;
+    std::cout << "  --mem-budget S: Fail if the image buffers would exceed S bytes (K, M, G suffixes)" << std::endl;
+    std::cout << "  --cache dir: Reuse filter results stored in dir (content-addressed, LRU eviction)" << std::endl;
+    std::cout << "  --cache-size S: Size limit of the result cache (default: 1G)" << std::endl;
 }
 
-void* processRegionPGM(void* arg) {
-    ThreadData* data = (ThreadData*)arg;
-    PGMImage* input = dynamic_cast<PGMImage*>(data->input);
-    PGMImage* output = dynamic_cast<PGMImage*>(data->output);
-    
-    if (!input || !output) {
-        data->success = false;
-        return nullptr;
-    }
-    
-    const float (*kernel)[3] = data->kernel;
-    
-    for (int y = data->start_row; y < data->end_row; y++) {
-        for (int x = 0; x < data->width; x++) {
-            float sum = 0.0f;
-            
-            // Aplicar kernel 3x3
-            for (int ky = -1; ky <= 1; ky++) {
-                for (int kx = -1; kx <= 1; kx++) {
-                    int nx = x + kx;
-                    int ny = y + ky;
-                    
-                    if (input->isValidCoordinate(nx, ny)) {
-                        int pixel_value = input->getGrayValue(nx, ny);
-                        sum += pixel_value * kernel[ky + 1][kx + 1];
-                    }
-                }
-            }
-            
-            // Clamping del resultado
-            int result = std::max(0, std::min(input->getMaxColor(), static_cast<int>(sum)));
-            output->setGrayValue(x, y, result);
-        }
-    }
-    
-    data->success = true;
-    return nullptr;
-}
-
-void* processRegionPPM(void* arg) {
-    ThreadData* data = (ThreadData*)arg;
-    PPMImage* input = dynamic_cast<PPMImage*>(data->input);
-    PPMImage* output = dynamic_cast<PPMImage*>(data->output);
-    
-    if (!input || !output) {
-        data->success = false;
-        return nullptr;
-    }
-    
-    const float (*kernel)[3] = data->kernel;
-    
-    for (int y = data->start_row; y < data->end_row; y++) {
-        for (int x = 0; x < data->width; x++) {
-            float sum_r = 0.0f, sum_g = 0.0f, sum_b = 0.0f;
-            
-            // Aplicar kernel 3x3
-            for (int ky = -1; ky <= 1; ky++) {
-                for (int kx = -1; kx <= 1; kx++) {
-                    int nx = x + kx;
-                    int ny = y + ky;
-                    
-                    if (input->isValidCoordinate(nx, ny)) {
-                        RGB pixel_value = input->getRGBValue(nx, ny);
-                        float kernel_val = kernel[ky + 1][kx + 1];
-                        sum_r += pixel_value.r * kernel_val;
-                        sum_g += pixel_value.g * kernel_val;
-                        sum_b += pixel_value.b * kernel_val;
-                    }
-                }
-            }
-            
-            // Clamping del resultado
-            int result_r = std::max(0, std::min(input->getMaxColor(), static_cast<int>(sum_r)));
-            int result_g = std::max(0, std::min(input->getMaxColor(), static_cast<int>(sum_g)));
-            int result_b = std::max(0, std::min(input->getMaxColor(), static_cast<int>(sum_b)));
-            
-            output->setRGBValue(x, y, result_r, result_g, result_b);
-        }
-    }
-    
-    data->success = true;
-    return nullptr;
-}
-
-bool applyFilterPthread(Imagen* input, Imagen* output, Filter::FilterType filter_type) {
-    if (!input || !output) {
+// Entero positivo completo (sin basura detrás); si no, informa y devuelve false
+bool parsePositive(const char* option, const char* text, int& value) {
+    char* end = nullptr;
+    long parsed = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || parsed <= 0 || parsed > INT_MAX) {
+        std::cerr << "Error: " << option << " needs a positive integer, got '" << text << "'" << std::endl;
         return false;
     }
-    
-    int width = input->getWidth();
-    int height = input->getHeight();
-    
-    // Configurar imagen de salida
-    output->setWidth(width);
-    output->setHeight(height);
-    output->setMaxColor(input->getMaxColor());
-    output->allocatePixels();
-    
-    // Obtener kernel
-    const float* kernel_ptr = getKernel(filter_type);
-    const float (*kernel)[3] = reinterpret_cast<const float (*)[3]>(kernel_ptr);
-    
-    // Crear threads y datos
-    pthread_t threads[NUM_THREADS];
-    ThreadData thread_data[NUM_THREADS];
-    
-    int rows_per_thread = height / NUM_THREADS;
-    int remaining_rows = height % NUM_THREADS;
-    
-    // Función de procesamiento según el tipo de imagen
-    void* (*process_function)(void*) = nullptr;
-    
-    if (strcmp(input->getMagic(), "P2") == 0) {
-        process_function = processRegionPGM;
-    } else if (strcmp(input->getMagic(), "P3") == 0) {
-        process_function = processRegionPPM;
-    } else {
-        return false;
-    }
-    
-    // Crear y lanzar threads
-    for (int i = 0; i < NUM_THREADS; i++) {
-        thread_data[i].input = input;
-        thread_data[i].output = output;
-        thread_data[i].filter_type = filter_type;
-        thread_data[i].thread_id = i;
-        thread_data[i].width = width;
-        thread_data[i].height = height;
-        thread_data[i].kernel = kernel;
-        thread_data[i].success = false;
-        
-        // Calcular filas para este hilo
-        thread_data[i].start_row = i * rows_per_thread;
-        thread_data[i].end_row = (i + 1) * rows_per_thread;
-        
-        // Asignar filas restantes al último hilo
-        if (i == NUM_THREADS - 1) {
-            thread_data[i].end_row += remaining_rows;
-        }
-        
-        int result = pthread_create(&threads[i], nullptr, process_function, &thread_data[i]);
-        if (result != 0) {
-            std::cerr << "Error creating thread " << i << std::endl;
-            return false;
-        }
-    }
-    
-    // Esperar a que todos los hilos terminen
-    bool overall_success = true;
-    for (int i = 0; i < NUM_THREADS; i++) {
-        pthread_join(threads[i], nullptr);
-        if (!thread_data[i].success) {
-            overall_success = false;
-        }
-    }
-    
-    return overall_success;
-}
-
-Imagen* createImageFromFile(const char* filename) {
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        std::cerr << "Error: Cannot open file " << filename << std::endl;
-        return nullptr;
-    }
-    
-    char magic[3];
-    if (fscanf(file, "%2s", magic) != 1) {
-        std::cerr << "Error: Cannot read magic number from " << filename << std::endl;
-        fclose(file);
-        return nullptr;
-    }
-    fclose(file);
-    
-    Imagen* image = nullptr;
-    
-    if (strcmp(magic, "P2") == 0) {
-        image = new PGMImage();
-    } else if (strcmp(magic, "P3") == 0) {
-        image = new PPMImage();
-    } else {
-        std::cerr << "Error: Unsupported image format. Only P2 (PGM) and P3 (PPM) are supported." << std::endl;
-        return nullptr;
-    }
-    
-    if (!image->load(filename)) {
-        delete image;
-        return nullptr;
-    }
-    
-    return image;
-}
-
-Imagen* createOutputImage(Imagen* input_image) {
-    if (!input_image) {
-        return nullptr;
-    }
-    
-    Imagen* output = nullptr;
-    
-    if (strcmp(input_image->getMagic(), "P2") == 0) {
-        PGMImage* pgm_input = dynamic_cast<PGMImage*>(input_image);
-        output = pgm_input->clone();
-    } else if (strcmp(input_image->getMagic(), "P3") == 0) {
-        PPMImage* ppm_input = dynamic_cast<PPMImage*>(input_image);
-        output = ppm_input->clone();
-    }
-    
-    return output;
+    value = static_cast<int>(parsed);
+    return true;
 }
 
 int main(int argc, char* argv[]) {
@@ -284,20 +72,122 @@ int main(int argc, char* argv[]) {
     const char* input_filename = argv[1];
     const char* output_filename = argv[2];
     const char* filter_name = nullptr;
-    
-    // Parsear argumentos para filtro
-    for (int i = 3; i < argc - 1; i++) {
-        if (strcmp(argv[i], "--f") == 0 && i + 1 < argc) {
-            filter_name = argv[i + 1];
+    int num_threads = 0;
+    Schedule schedule = SCHEDULE_TILES;
+    int tile_width = 0, tile_height = 0;
+    NumaMemory::Policy numa_policy = NumaMemory::POLICY_FIRST_TOUCH;
+    bool huge_pages = false;
+    bool pin_threads = false;
+    bool numa_report = false;
+    const char* profile_path = nullptr;
+    bool force_autotune = false;
+    int iterations = 1;
+    int time_block = IterativeFilter::DEFAULT_TIME_BLOCK;
+    const char* trace_file = nullptr;
+    bool use_counters = false;
+    size_t memory_budget = 0;
+    const char* cache_dir = nullptr;
+    size_t cache_size = ResultCache::DEFAULT_MAX_BYTES;
+    
+    // Parsear argumentos para filtro, número de hilos, reparto y memoria
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--hugepages") == 0) {
+            huge_pages = true;
+        } else if (strcmp(argv[i], "--pin") == 0) {
+            pin_threads = true;
+        } else if (strcmp(argv[i], "--numa-report") == 0) {
+            numa_report = true;
+        } else if (strcmp(argv[i], "--autotune") == 0) {
+            force_autotune = true;
+        } else if (strcmp(argv[i], "--counters") == 0) {
+            use_counters = true;
+        } else if (i + 1 >= argc) {
             break;
+        } else if (strcmp(argv[i], "--iterations") == 0) {
+            if (!parsePositive(argv[i], argv[i + 1], iterations)) {
+                return 1;
+            }
+            i++;
+        } else if (strcmp(argv[i], "--time-block") == 0) {
+            if (!parsePositive(argv[i], argv[i + 1], time_block)) {
+                return 1;
+            }
+            i++;
+        } else if (strcmp(argv[i], "--mem-budget") == 0) {
+            if (!MemoryTracker::parseSize(argv[i + 1], memory_budget)) {
+                std::cerr << "Error: Invalid memory budget '" << argv[i + 1] << "'" << std::endl;
+                return 1;
+            }
+            i++;
+        } else if (strcmp(argv[i], "--cache-size") == 0) {
+            if (!MemoryTracker::parseSize(argv[i + 1], cache_size)) {
+                std::cerr << "Error: Invalid cache size '" << argv[i + 1] << "'" << std::endl;
+                return 1;
+            }
+            i++;
+        } else if (strcmp(argv[i], "--cache") == 0) {
+            cache_dir = argv[i + 1];
+            i++;
+        } else if (strcmp(argv[i], "--trace") == 0) {
+            trace_file = argv[i + 1];
+            i++;
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            profile_path = argv[i + 1];
+            i++;
+        } else if (strcmp(argv[i], "--numa") == 0) {
+            numa_policy = NumaMemory::stringToPolicy(argv[i + 1]);
+            i++;
+        } else if (strcmp(argv[i], "--f") == 0 && i + 1 < argc) {
+            filter_name = argv[i + 1];
+            i++;
+        } else if (strcmp(argv[i], "--t") == 0 && i + 1 < argc) {
+            if (!parsePositive(argv[i], argv[i + 1], num_threads)) {
+                return 1;
+            }
+            i++;
+        } else if (strcmp(argv[i], "--sched") == 0 && i + 1 < argc) {
+            schedule = (strcmp(argv[i + 1], "rows") == 0) ? SCHEDULE_ROWS : SCHEDULE_TILES;
+            i++;
+        } else if (strcmp(argv[i], "--tile") == 0 && i + 1 < argc) {
+            if (sscanf(argv[i + 1], "%dx%d", &tile_width, &tile_height) != 2) {
+                std::cerr << "Warning: Invalid tile size '" << argv[i + 1] << "', using defaults" << std::endl;
+                tile_width = tile_height = 0;
+            }
+            i++;
         }
     }
     
+    // Los contadores se abren antes de crear el pool para que los hilos los hereden
+    PerfCounters counters;
+    if (use_counters) {
+        counters.open();
+    }
+    MemoryTracker memory;
+    MemoryTracker::setBudget(memory_budget);
+    if (cache_dir && !ResultCache::enable(cache_dir, cache_size)) {
+        return 1;
+    }
+    
+    // Pool persistente: los hilos se crean una vez y se reutilizan en cada etapa
+    ThreadPool pool(num_threads);
+    TileScheduler scheduler(pool, tile_width, tile_height);
+    
+    // Fijar los hilos antes de cargar: el primer toque debe ocurrir en su nodo definitivo
+    if (pin_threads && !NumaMemory::pinPoolThreads(pool)) {
+        std::cerr << "Warning: Could not pin all pool threads" << std::endl;
+    }
+    NumaMemory::setPolicy(numa_policy);
+    NumaMemory::setHugePages(huge_pages);
+    NumaMemory::setFirstTouchPool(&pool);
+    
     Timer total_timer, load_timer, process_timer, save_timer;
     
-    std::cout << "=== Pthread Image Processor (" << NUM_THREADS << " threads) ===" << std::endl;
+    std::cout << "=== Pthread Image Processor (" << pool.getNumThreads() << " threads) ===" << std::endl;
     std::cout << "Input file: " << input_filename << std::endl;
     std::cout << "Output file: " << output_filename << std::endl;
+    std::cout << "Memory: " << NumaMemory::policyToString(numa_policy) << " placement on "
+              << NumaMemory::getNumNodes() << " NUMA node(s)" << (huge_pages ? ", huge pages" : "")
+              << (pin_threads ? ", pinned threads" : "") << std::endl;
     
     if (filter_name) {
         std::cout << "Filter: " << filter_name << std::endl;
@@ -308,11 +198,20 @@ int main(int argc, char* argv[]) {
     
     total_timer.start();
     
+    // Entrada y salida (y el buffer extra del ping-pong con --iterations)
+    if (!ImageFactory::checkMemoryBudget(input_filename, iterations > 1 ? 3 : 2)) {
+        return 1;
+    }
+    
     // Cargar imagen
     std::cout << "Loading input image..." << std::endl;
+    counters.start();
+    memory.start();
     load_timer.start();
-    Imagen* input_image = createImageFromFile(input_filename);
+    Imagen* input_image = ImageFactory::load(input_filename);
     load_timer.stop();
+    memory.stop();
+    counters.stop();
     
     if (!input_image) {
         std::cerr << "Failed to load input image." << std::endl;
@@ -324,10 +223,29 @@ int main(int argc, char* argv[]) {
     std::cout << "  Dimensions: " << input_image->getWidth() << "x" << input_image->getHeight() << std::endl;
     std::cout << "  Max color value: " << input_image->getMaxColor() << std::endl;
     std::cout << "  Load time: " << load_timer.getElapsedMilliseconds() << " ms" << std::endl;
+    const long long pixels = static_cast<long long>(input_image->getWidth()) * input_image->getHeight();
+    counters.report("Load", pixels, load_timer.getElapsedMilliseconds());
+    memory.report("Load");
     std::cout << std::endl;
     
+    // Tamaño de tile: --tile, el perfil si se pide con --autotune o --profile,
+    // o el que el planificador deriva de la caché
+    if (filter_name && iterations <= 1 && schedule == SCHEDULE_TILES && (tile_width <= 0 || tile_height <= 0) &&
+        (force_autotune || profile_path)) {
+        TileProfile profile = TileAutotuner::loadOrTune(profile_path, force_autotune, true);
+        profile.getTileSize(input_image, tile_width, tile_height);
+        // 0x0: ningún bloque ganó en la búsqueda, se queda el de la caché
+        if (tile_width > 0 && tile_height > 0) {
+            scheduler.setTileSize(tile_width, tile_height);
+        }
+        std::cout << std::endl;
+    }
+    
+    // La salida se cuenta en la fase de filtrado
+    memory.start();
+    
     // Crear imagen de salida
-    Imagen* output_image = createOutputImage(input_image);
+    Imagen* output_image = ImageFactory::createOutput(input_image);
     if (!output_image) {
         std::cerr << "Failed to create output image." << std::endl;
         delete input_image;
@@ -336,13 +254,28 @@ int main(int argc, char* argv[]) {
     
     // Aplicar filtro con pthreads
     if (filter_name) {
-        std::cout << "Applying filter with " << NUM_THREADS << " threads: " << filter_name << "..." << std::endl;
+        std::cout << "Applying filter with " << pool.getNumThreads() << " threads: " << filter_name << "..." << std::endl;
+        counters.start();
         process_timer.start();
         
         Filter::FilterType filter_type = Filter::stringToFilterType(filter_name);
-        bool success = applyFilterPthread(input_image, output_image, filter_type);
+        bool success;
+        if (iterations > 1) {
+            std::cout << "  Iterations: " << iterations << " (" << time_block << " per pass)" << std::endl;
+            success = PthreadFilter::applyIterative(input_image, output_image, filter_type, iterations, time_block,
+                                                    tile_width, tile_height, pool);
+        } else if (schedule == SCHEDULE_TILES) {
+            std::cout << "  Schedule: tiles " << scheduler.getTileWidth() << "x" << scheduler.getTileHeight()
+                      << " with work stealing" << std::endl;
+            success = PthreadFilter::applyTiles(input_image, output_image, filter_type, scheduler);
+        } else {
+            std::cout << "  Schedule: static row blocks" << std::endl;
+            success = PthreadFilter::applyRows(input_image, output_image, filter_type, pool);
+        }
         
         process_timer.stop();
+        memory.stop();
+        counters.stop();
         
         if (!success) {
             std::cerr << "Failed to apply filter." << std::endl;
@@ -353,14 +286,34 @@ int main(int argc, char* argv[]) {
         
         std::cout << "Filter applied successfully!" << std::endl;
         std::cout << "  Processing time: " << process_timer.getElapsedMilliseconds() << " ms" << std::endl;
+        counters.report("Processing", pixels, process_timer.getElapsedMilliseconds());
+        memory.report("Processing");
+        if (iterations <= 1 && schedule == SCHEDULE_TILES) {
+            std::cout << "  Tiles: " << scheduler.getTotalTiles() << " (" << scheduler.getTotalStolen() << " stolen)" << std::endl;
+            for (int i = 0; i < scheduler.getNumWorkers(); i++) {
+                std::cout << "    Thread " << i << ": " << scheduler.getTilesExecuted(i) << " tiles, "
+                          << scheduler.getTilesStolen(i) << " stolen" << std::endl;
+            }
+        }
+        std::cout << std::endl;
+    }
+    
+    if (numa_report) {
+        std::cout << "NUMA placement:" << std::endl;
+        NumaMemory::printPlacementReport("input", input_image->getPixels(), input_image->getPixelCount());
+        NumaMemory::printPlacementReport("output", output_image->getPixels(), output_image->getPixelCount());
         std::cout << std::endl;
     }
     
     // Guardar imagen
     std::cout << "Saving output image..." << std::endl;
+    counters.start();
+    memory.start();
     save_timer.start();
     bool save_success = output_image->save(output_filename);
     save_timer.stop();
+    memory.stop();
+    counters.stop();
     
     if (!save_success) {
         std::cerr << "Failed to save output image." << std::endl;
@@ -373,16 +326,32 @@ int main(int argc, char* argv[]) {
     
     std::cout << "Image saved successfully!" << std::endl;
     std::cout << "  Save time: " << save_timer.getElapsedMilliseconds() << " ms" << std::endl;
+    counters.report("Save", pixels, save_timer.getElapsedMilliseconds());
+    memory.report("Save");
     std::cout << std::endl;
     
     // Mostrar resumen de tiempos
     std::cout << "=== Performance Summary (Pthreads) ===" << std::endl;
-    std::cout << "Threads used:    " << NUM_THREADS << std::endl;
+    std::cout << "Threads used:    " << pool.getNumThreads() << std::endl;
     std::cout << "Load time:       " << load_timer.getElapsedMilliseconds() << " ms" << std::endl;
     std::cout << "Processing time: " << process_timer.getElapsedMilliseconds() << " ms" << std::endl;
     std::cout << "Save time:       " << save_timer.getElapsedMilliseconds() << " ms" << std::endl;
     std::cout << "Total time:      " << total_timer.getElapsedMilliseconds() << " ms" << std::endl;
     
+    if (ResultCache::isEnabled()) {
+        std::cout << std::endl;
+        ResultCache::printStats(std::cout);
+    }
+    
+    // La traza muestra un carril por hilo del pool: el desequilibrio entre bandas salta a la vista
+    if (trace_file) {
+        std::cout << std::endl;
+        Profiler::printSummary();
+        if (Profiler::writeChromeTrace(trace_file)) {
+            std::cout << "Trace written to: " << trace_file << std::endl;
+        }
+    }
+    
     delete input_image;
     delete output_image;
     
@@ -0,0 +1,545 @@
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include <algorithm>
+#ifdef ENABLE_MPI
+#include <mpi.h>
+#endif
+#include "imagen.h"
+#include "image_factory.h"
+#include "filter.h"
+#include "backend.h"
+#include "backend_selector.h"
+#include "iterative_filter.h"
+#include "tile_autotuner.h"
+#include "thread_pool.h"
+#include "timer.h"
+#include "profiler.h"
+#include "perf_counters.h"
+#include "memory_tracker.h"
+#include "result_cache.h"
+#include "frame_stream.h"
+
+// Procesador único: el mismo flujo (carga, filtro, guardado) con cualquier
+// backend. Con --backend auto se elige backend y número de hilos según el
+// tamaño de la imagen y la calibración de la máquina; lanzado con mpirun y
+// más de un proceso, auto usa MPI. Con --stream procesa una secuencia de
+// frames concatenados (FrameStream) en lugar de una imagen.
+
+void printUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " input_file output_file [--f filter_type] [--backend b] [--t threads]" << std::endl;
+    std::cout << "  input_file:  Input image file (PPM or PGM) or synth:pattern[:WxH][:pgm|ppm][:seed]" << std::endl;
+    std::cout << "  output_file: Output image file" << std::endl;
+    std::cout << "  --stream:    Process concatenated PGM/PPM frames; input and output may be - (stdin/stdout)" << std::endl;
+    std::cout << "  --depth N:   Frames in flight in stream mode (default: " << FrameStream::DEFAULT_DEPTH << ")" << std::endl;
+    std::cout << "  --f filter:  Filter to apply (blur, laplace, sharpen)" << std::endl;
+    std::cout << "               If no filter specified, image will be copied" << std::endl;
+    std::cout << "  --backend b: sequential, pthread, omp, mpi or auto (default: auto)" << std::endl;
+    std::cout << "  --t threads: Threads per process (default: " << ThreadPool::getHardwareConcurrency()
+              << "; with auto, the most threads to consider)" << std::endl;
+    std::cout << "  --iterations N: Apply the filter N times (ping-pong buffers, temporal blocking)" << std::endl;
+    std::cout << "  --time-block T: Iterations per pass over the image (default: "
+              << IterativeFilter::DEFAULT_TIME_BLOCK << ")" << std::endl;
+    std::cout << "  --calibration p: Backend profile for auto (calibrated and saved there if missing)" << std::endl;
+    std::cout << "  --recalibrate: Measure this machine and save the backend profile (default: "
+              << BackendSelector::DEFAULT_PROFILE_PATH << ")" << std::endl;
+    std::cout << "  --profile p: Use the tile sizes in profile p (searched and saved there if missing)" << std::endl;
+    std::cout << "  --autotune:  Search the tile size and save it to the profile (default: "
+              << TileAutotuner::DEFAULT_PROFILE_PATH << ")" << std::endl;
+    std::cout << "  --trace f:   Write a Chrome trace of the profiling zones to f and print a summary" << std::endl;
+    std::cout << "               (zones are only recorded when built with -DENABLE_PROFILING)" << std::endl;
+    std::cout << "  --counters:  Report hardware counters (IPC, cache/branch misses per pixel) per phase" << std::endl;
+    std::cout << "  --mem-budget S: Fail if the image buffers would exceed S bytes (K, M, G suffixes)" << std::endl;
+    std::cout << "  --cache dir: Reuse filter results stored in dir (content-addressed, LRU eviction; not with mpi)" << std::endl;
+    std::cout << "  --cache-size S: Size limit of the result cache (default: 1G)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Examples:" << std::endl;
+    std::cout << "  " << program_name << " lena.pgm lena_blur.pgm --f blur" << std::endl;
+    std::cout << "  " << program_name << " synth:natural:8192x8192:ppm big_blur.ppm --f blur --backend pthread --t 8" << std::endl;
+    std::cout << "  mpirun -np 4 " << program_name << " lena.pgm lena_blur.pgm --f blur --backend mpi" << std::endl;
+    std::cout << "  cat frames.pgm | " << program_name << " - - --stream --f blur > blurred.pgm" << std::endl;
+}
+
+// Bloqueo de caché o tiles según el perfil de esta máquina, solo con
+// --autotune o --profile; si no, cada backend usa su tamaño por defecto
+void configureTiles(Backend* backend, const Imagen* image, const char* profile_path, bool force_autotune,
+                    bool verbose) {
+    if (backend->getKind() != Backend::SEQUENTIAL && backend->getKind() != Backend::PTHREAD) {
+        return;
+    }
+    if (!force_autotune && !profile_path) {
+        return;
+    }
+    TileProfile profile = TileAutotuner::loadOrTune(profile_path, force_autotune, verbose);
+    int tile_width, tile_height;
+    profile.getTileSize(image, tile_width, tile_height);
+    backend->setTileSize(tile_width, tile_height);
+}
+
+void printBackend(std::ostream& out, const Backend* backend) {
+    out << "Backend: " << Backend::kindToString(backend->getKind());
+    if (backend->getNumProcesses() > 1) {
+        out << " (" << backend->getNumProcesses() << " processes x ";
+    } else {
+        out << " (";
+    }
+    out << backend->getNumThreads() << " thread" << (backend->getNumThreads() > 1 ? "s" : "") << ")" << std::endl;
+}
+
+// Termina el programa (y MPI si está compilado)
+int finish(int exit_code) {
+#ifdef ENABLE_MPI
+    MPI_Finalize();
+#endif
+    return exit_code;
+}
+
+// Entero > 0 que ocupa todo el texto; si no, informa (solo el rango 0) y devuelve false
+bool parsePositive(const char* option, const char* text, int rank, int& value) {
+    char* end = nullptr;
+    long parsed = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || parsed <= 0 || parsed > INT_MAX) {
+        if (rank == 0) {
+            std::cerr << "Error: " << option << " needs a positive integer, got '" << text << "'" << std::endl;
+        }
+        return false;
+    }
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    int rank = 0, num_processes = 1;
+#ifdef ENABLE_MPI
+    // El backend MPI filtra con un equipo OpenMP por proceso: solo el hilo principal llama a MPI
+    int thread_support = 0;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &thread_support);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_processes);
+    Profiler::setProcessId(rank);
+#endif
+
+    if (argc < 3) {
+        if (rank == 0) {
+            printUsage(argv[0]);
+        }
+        return finish(1);
+    }
+    
+    const char* input_filename = argv[1];
+    const char* output_filename = argv[2];
+    const char* filter_name = nullptr;
+    Backend::Kind kind = Backend::AUTO;
+    int num_threads = 0;
+    int iterations = 1;
+    int time_block = IterativeFilter::DEFAULT_TIME_BLOCK;
+    const char* calibration_path = nullptr;
+    bool force_calibration = false;
+    const char* profile_path = nullptr;
+    bool force_autotune = false;
+    const char* trace_file = nullptr;
+    bool use_counters = false;
+    size_t memory_budget = 0;
+    const char* cache_dir = nullptr;
+    size_t cache_size = ResultCache::DEFAULT_MAX_BYTES;
+    bool stream_mode = false;
+    int stream_depth = FrameStream::DEFAULT_DEPTH;
+    
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--autotune") == 0) {
+            force_autotune = true;
+        } else if (strcmp(argv[i], "--recalibrate") == 0) {
+            force_calibration = true;
+        } else if (strcmp(argv[i], "--counters") == 0) {
+            use_counters = true;
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            stream_mode = true;
+        } else if (i + 1 >= argc) {
+            if (rank == 0) {
+                std::cerr << "Error: Unknown option or missing value: " << argv[i] << std::endl;
+            }
+            return finish(1);
+        } else if (strcmp(argv[i], "--f") == 0) {
+            filter_name = argv[++i];
+            Filter::FilterType filter_type;
+            if (!Filter::stringToFilterType(filter_name, filter_type)) {
+                if (rank == 0) {
+                    std::cerr << "Error: Unknown filter '" << filter_name << "' (use blur, laplace or sharpen)" << std::endl;
+                }
+                return finish(1);
+            }
+        } else if (strcmp(argv[i], "--backend") == 0) {
+            if (!Backend::stringToKind(argv[++i], kind)) {
+                if (rank == 0) {
+                    std::cerr << "Error: Unknown backend '" << argv[i] << "'" << std::endl;
+                }
+                return finish(1);
+            }
+        } else if (strcmp(argv[i], "--t") == 0) {
+            if (!parsePositive(argv[i], argv[i + 1], rank, num_threads)) {
+                return finish(1);
+            }
+            i++;
+        } else if (strcmp(argv[i], "--depth") == 0) {
+            if (!parsePositive(argv[i], argv[i + 1], rank, stream_depth)) {
+                return finish(1);
+            }
+            i++;
+        } else if (strcmp(argv[i], "--iterations") == 0) {
+            if (!parsePositive(argv[i], argv[i + 1], rank, iterations)) {
+                return finish(1);
+            }
+            i++;
+        } else if (strcmp(argv[i], "--time-block") == 0) {
+            if (!parsePositive(argv[i], argv[i + 1], rank, time_block)) {
+                return finish(1);
+            }
+            i++;
+        } else if (strcmp(argv[i], "--calibration") == 0) {
+            calibration_path = argv[++i];
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            profile_path = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0) {
+            trace_file = argv[++i];
+        } else if (strcmp(argv[i], "--cache") == 0) {
+            cache_dir = argv[++i];
+        } else if (strcmp(argv[i], "--cache-size") == 0) {
+            if (!MemoryTracker::parseSize(argv[++i], cache_size)) {
+                if (rank == 0) {
+                    std::cerr << "Error: Invalid cache size '" << argv[i] << "'" << std::endl;
+                }
+                return finish(1);
+            }
+        } else if (strcmp(argv[i], "--mem-budget") == 0) {
+            if (!MemoryTracker::parseSize(argv[++i], memory_budget)) {
+                if (rank == 0) {
+                    std::cerr << "Error: Invalid memory budget '" << argv[i] << "'" << std::endl;
+                }
+                return finish(1);
+            }
+        } else {
+            if (rank == 0) {
+                std::cerr << "Error: Unknown option " << argv[i] << std::endl;
+                printUsage(argv[0]);
+            }
+            return finish(1);
+        }
+    }
+    
+    // Con varios procesos MPI ya lanzados, auto los usa
+    if (kind == Backend::AUTO && num_processes > 1) {
+        kind = Backend::MPI;
+    }
+    if (kind != Backend::AUTO && !Backend::isAvailable(kind)) {
+        if (rank == 0) {
+            Backend::create(kind, num_threads); // informa qué falta en la compilación
+        }
+        return finish(1);
+    }
+    if (num_processes > 1 && kind != Backend::MPI) {
+        if (rank == 0) {
+            std::cerr << "Error: Backend '" << Backend::kindToString(kind)
+                      << "' runs in one process; launch it without mpirun" << std::endl;
+        }
+        return finish(1);
+    }
+    
+    Filter::FilterType filter_type = filter_name ? Filter::stringToFilterType(filter_name) : Filter::BLUR;
+    
+    // Con los frames en stdout, los mensajes van a stderr y se omiten los detalles de la calibración
+    const bool frames_to_stdout = stream_mode && strcmp(output_filename, "-") == 0;
+    const bool verbose = !frames_to_stdout;
+    std::ostream& log = frames_to_stdout ? std::cerr : std::cout;
+    
+    // Los contadores se abren antes de crear hilos para que los hereden
+    PerfCounters counters;
+    if (use_counters) {
+        counters.open();
+    }
+    MemoryTracker memory;
+    MemoryTracker::setBudget(memory_budget);
+    
+    // La calibración va antes de cargar: la primera región OpenMP debe ser la suya
+    BackendCalibration calibration;
+    if (kind == Backend::AUTO && filter_name) {
+        calibration = BackendSelector::loadOrCalibrate(calibration_path, force_calibration, verbose);
+        if (verbose) {
+            std::cout << std::endl;
+        }
+    }
+    
+    // Después de calibrar: las mediciones no deben salir de la caché. El
+    // backend MPI no la usa (un acierto en la raíz rompería la colectiva)
+    if (cache_dir && kind == Backend::MPI) {
+        if (rank == 0) {
+            std::cerr << "Warning: The result cache is not used with the mpi backend" << std::endl;
+        }
+    } else if (cache_dir && !ResultCache::enable(cache_dir, cache_size)) {
+        return finish(1);
+    }
+    
+    // Un backend fijo se crea ya; auto espera a conocer la imagen
+    Backend* backend = nullptr;
+    if (kind != Backend::AUTO) {
+        backend = Backend::create(kind, num_threads);
+        if (!backend) {
+            return finish(1);
+        }
+    }
+    
+    // En MPI los demás procesos solo participan en el filtro colectivo
+    if (backend && !backend->isRoot()) {
+        bool success = !filter_name || backend->apply(nullptr, nullptr, filter_type, iterations, time_block);
+        // En flujo, un frame tras otro hasta que la raíz avisa del final
+        while (stream_mode && success) {
+            success = backend->apply(nullptr, nullptr, filter_type, iterations, time_block);
+        }
+        delete backend;
+        return finish(stream_mode || success ? 0 : 1);
+    }
+    
+    if (stream_mode) {
+        FILE* input = strcmp(input_filename, "-") == 0 ? stdin : fopen(input_filename, "rb");
+        FILE* output = frames_to_stdout ? stdout : fopen(output_filename, "wb");
+        if (!input || !output) {
+            std::cerr << "Error: Cannot open " << (input ? output_filename : input_filename) << std::endl;
+            if (backend && filter_name) {
+                backend->cancel();
+            }
+            delete backend;
+            return finish(1);
+        }
+        
+        log << "=== Unified Image Processor (stream) ===" << std::endl;
+        log << "Input: " << (input == stdin ? "stdin" : input_filename) << std::endl;
+        log << "Output: " << (frames_to_stdout ? "stdout" : output_filename) << std::endl;
+        log << (filter_name ? "Filter: " : "Operation: Copy frames (no filter)") << (filter_name ? filter_name : "")
+            << std::endl;
+        log << "Frames in flight: " << stream_depth << std::endl;
+        
+        // El backend se decide con el primer frame (auto según su tamaño)
+        FrameStream::BackendFactory create_backend = [&](const Imagen* frame) -> Backend* {
+            Backend* chosen = backend;
+            if (!chosen) {
+                const int channels = (strcmp(frame->getMagic(), "P3") == 0) ? 3 : 1;
+                BackendChoice choice = BackendSelector::choose(calibration, frame->getWidth(), frame->getHeight(),
+                                                               channels, iterations, num_threads, verbose);
+                chosen = Backend::create(choice.kind, choice.threads);
+            }
+            if (chosen) {
+                if (iterations <= 1) {
+                    configureTiles(chosen, frame, profile_path, force_autotune, verbose);
+                }
+                printBackend(log, chosen);
+            }
+            return chosen;
+        };
+        
+        StreamStats stats;
+        bool success = FrameStream::run(input, output, create_backend, backend, filter_name != nullptr, filter_type,
+                                        iterations, time_block, stream_depth, stats);
+        if (input != stdin) {
+            fclose(input);
+        }
+        if (output != stdout && fclose(output) != 0) {
+            success = false;
+        }
+        
+        const double frames = std::max(1, stats.frames);
+        log << std::endl;
+        log << "=== Stream Summary ===" << std::endl;
+        log << "Frames:          " << stats.frames << std::endl;
+        log << "Throughput:      " << stats.getFramesPerSecond() << " frames/s (" << stats.total_ms << " ms)" << std::endl;
+        log << "Latency:         p50 " << stats.getLatencyPercentile(50.0) << " ms, p90 "
+            << stats.getLatencyPercentile(90.0) << " ms, p99 " << stats.getLatencyPercentile(99.0) << " ms, max "
+            << stats.getLatencyPercentile(100.0) << " ms" << std::endl;
+        log << "Per frame:       decode " << stats.decode_ms / frames << " ms, filter " << stats.filter_ms / frames
+            << " ms, encode " << stats.encode_ms / frames << " ms" << std::endl;
+        if (ResultCache::isEnabled()) {
+            ResultCache::printStats(log);
+        }
+        
+        if (trace_file) {
+            log << std::endl;
+            Profiler::printSummary();
+            if (Profiler::writeChromeTrace(trace_file)) {
+                log << "Trace written to: " << trace_file << std::endl;
+            }
+        }
+        
+        delete backend;
+        return finish(success ? 0 : 1);
+    }
+    
+    Timer total_timer, load_timer, process_timer, save_timer;
+    
+    std::cout << "=== Unified Image Processor ===" << std::endl;
+    std::cout << "Input file: " << input_filename << std::endl;
+    std::cout << "Output file: " << output_filename << std::endl;
+    if (filter_name) {
+        std::cout << "Filter: " << filter_name << std::endl;
+    } else {
+        std::cout << "Operation: Copy image (no filter)" << std::endl;
+    }
+    std::cout << std::endl;
+    
+    total_timer.start();
+    
+    // Entrada y salida (y el buffer extra del ping-pong con --iterations)
+    if (!ImageFactory::checkMemoryBudget(input_filename, iterations > 1 ? 3 : 2)) {
+        if (backend && filter_name) {
+            backend->cancel();
+        }
+        delete backend;
+        return finish(1);
+    }
+    
+    std::cout << "Loading input image..." << std::endl;
+    counters.start();
+    memory.start();
+    load_timer.start();
+    Imagen* input_image = ImageFactory::load(input_filename);
+    load_timer.stop();
+    memory.stop();
+    counters.stop();
+    
+    if (!input_image) {
+        std::cerr << "Failed to load input image." << std::endl;
+        if (backend && filter_name) {
+            backend->cancel();
+        }
+        delete backend;
+        return finish(1);
+    }
+    
+    std::cout << "Image loaded successfully!" << std::endl;
+    std::cout << "  Format: " << input_image->getMagic() << std::endl;
+    std::cout << "  Dimensions: " << input_image->getWidth() << "x" << input_image->getHeight() << std::endl;
+    std::cout << "  Max color value: " << input_image->getMaxColor() << std::endl;
+    std::cout << "  Load time: " << load_timer.getElapsedMilliseconds() << " ms" << std::endl;
+    const long long pixels = static_cast<long long>(input_image->getWidth()) * input_image->getHeight();
+    counters.report("Load", pixels, load_timer.getElapsedMilliseconds());
+    memory.report("Load");
+    std::cout << std::endl;
+    
+    // Auto: backend e hilos según el tamaño (sin filtro no hay nada que repartir)
+    if (!backend) {
+        BackendChoice choice;
+        if (filter_name) {
+            const int channels = (strcmp(input_image->getMagic(), "P3") == 0) ? 3 : 1;
+            choice = BackendSelector::choose(calibration, input_image->getWidth(), input_image->getHeight(),
+                                             channels, iterations, num_threads, true);
+            std::cout << std::endl;
+        }
+        backend = Backend::create(choice.kind, choice.threads);
+        if (!backend) {
+            delete input_image;
+            return finish(1);
+        }
+    }
+    
+    printBackend(std::cout, backend);
+    if (filter_name && iterations <= 1) {
+        configureTiles(backend, input_image, profile_path, force_autotune, true);
+    }
+    std::cout << std::endl;
+    
+    // La salida se cuenta en la fase de filtrado
+    memory.start();
+    
+    Imagen* output_image = ImageFactory::createOutput(input_image);
+    if (!output_image) {
+        std::cerr << "Failed to create output image." << std::endl;
+        if (filter_name) {
+            backend->cancel();
+        }
+        delete backend;
+        delete input_image;
+        return finish(1);
+    }
+    
+    if (filter_name) {
+        std::cout << "Applying filter: " << filter_name << "..." << std::endl;
+        if (iterations > 1) {
+            std::cout << "  Iterations: " << iterations << " (" << time_block << " per pass)" << std::endl;
+        }
+    } else {
+        std::cout << "No filter specified, copying image..." << std::endl;
+    }
+    counters.start();
+    process_timer.start();
+    
+    bool success = !filter_name || backend->apply(input_image, output_image, filter_type, iterations, time_block);
+    
+    process_timer.stop();
+    memory.stop();
+    counters.stop();
+    
+    if (!success) {
+        std::cerr << "Failed to apply filter." << std::endl;
+        delete backend;
+        delete input_image;
+        delete output_image;
+        return finish(1);
+    }
+    
+    if (filter_name) {
+        std::cout << "Filter applied successfully!" << std::endl;
+    }
+    std::cout << "  Processing time: " << process_timer.getElapsedMilliseconds() << " ms" << std::endl;
+    counters.report("Processing", pixels, process_timer.getElapsedMilliseconds());
+    memory.report("Processing");
+    std::cout << std::endl;
+    
+    std::cout << "Saving output image..." << std::endl;
+    counters.start();
+    memory.start();
+    save_timer.start();
+    bool save_success = output_image->save(output_filename);
+    save_timer.stop();
+    memory.stop();
+    counters.stop();
+    
+    if (!save_success) {
+        std::cerr << "Failed to save output image." << std::endl;
+        delete backend;
+        delete input_image;
+        delete output_image;
+        return finish(1);
+    }
+    
+    total_timer.stop();
+    
+    std::cout << "Image saved successfully!" << std::endl;
+    std::cout << "  Save time: " << save_timer.getElapsedMilliseconds() << " ms" << std::endl;
+    counters.report("Save", pixels, save_timer.getElapsedMilliseconds());
+    memory.report("Save");
+    std::cout << std::endl;
+    
+    std::cout << "=== Performance Summary (" << Backend::kindToString(backend->getKind()) << ") ===" << std::endl;
+    std::cout << "Load time:       " << load_timer.getElapsedMilliseconds() << " ms" << std::endl;
+    std::cout << "Processing time: " << process_timer.getElapsedMilliseconds() << " ms" << std::endl;
+    std::cout << "Save time:       " << save_timer.getElapsedMilliseconds() << " ms" << std::endl;
+    std::cout << "Total time:      " << total_timer.getElapsedMilliseconds() << " ms" << std::endl;
+    
+    if (ResultCache::isEnabled()) {
+        std::cout << std::endl;
+        ResultCache::printStats(std::cout);
+    }
+    
+    // En MPI la traza solo cubre el proceso 0
+    if (trace_file) {
+        std::cout << std::endl;
+        Profiler::printSummary();
+        if (Profiler::writeChromeTrace(trace_file)) {
+            std::cout << "Trace written to: " << trace_file << std::endl;
+        }
+    }
+    
+    delete backend;
+    delete input_image;
+    delete output_image;
+    
+    return finish(0);
+}
@@ -0,0 +1,187 @@
+#include "profiler.h"
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <algorithm>
+#include <mutex>
+
+// Buffer de un hilo. Se registra una vez y no se libera al terminar el hilo,
+// así los eventos de los hilos de un pool siguen disponibles al exportar.
+struct Profiler::ThreadBuffer {
+    int thread_index;
+    int depth;
+    std::vector<Event> events;
+
+    ThreadBuffer() : thread_index(0), depth(0) {}
+};
+
+static std::mutex registry_mutex;
+static int process_id = 0;
+
+std::vector<Profiler::ThreadBuffer*>& Profiler::registry() {
+    static std::vector<ThreadBuffer*> buffers;
+    return buffers;
+}
+
+Profiler::ThreadBuffer* Profiler::getThreadBuffer() {
+    static thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        buffer = new ThreadBuffer();
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        buffer->thread_index = static_cast<int>(registry().size());
+        buffer->events.reserve(1024);
+        registry().push_back(buffer);
+    }
+    return buffer;
+}
+
+void Profiler::setProcessId(int pid) {
+    process_id = pid;
+}
+
+bool Profiler::isEnabled() {
+#ifdef ENABLE_PROFILING
+    return true;
+#else
+    return false;
+#endif
+}
+
+int Profiler::enterZone() {
+    return getThreadBuffer()->depth++;
+}
+
+void Profiler::leaveZone(const char* name, long long start_us, int depth) {
+    long long end_us = Timer::getTimestampMicroseconds();
+    ThreadBuffer* buffer = getThreadBuffer();
+    buffer->depth = depth;
+
+    Event event;
+    event.name = name;
+    event.start_us = start_us;
+    event.duration_us = end_us - start_us;
+    event.depth = depth;
+    buffer->events.push_back(event);
+}
+
+void Profiler::collect(std::vector<std::pair<int, Event> >& events) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (size_t t = 0; t < registry().size(); t++) {
+        const ThreadBuffer* buffer = registry()[t];
+        for (size_t i = 0; i < buffer->events.size(); i++) {
+            events.push_back(std::make_pair(buffer->thread_index, buffer->events[i]));
+        }
+    }
+}
+
+long long Profiler::getFirstTimestamp() {
+    std::vector<std::pair<int, Event> > events;
+    collect(events);
+
+    long long first = 0;
+    for (size_t i = 0; i < events.size(); i++) {
+        if (i == 0 || events[i].second.start_us < first) {
+            first = events[i].second.start_us;
+        }
+    }
+    return first;
+}
+
+std::string Profiler::formatTraceEvents(long long origin_us) {
+    std::vector<std::pair<int, Event> > events;
+    collect(events);
+
+    std::ostringstream text;
+    for (size_t i = 0; i < events.size(); i++) {
+        const Event& event = events[i].second;
+        text << "  {\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": " << process_id
+             << ", \"tid\": " << events[i].first << ", \"ts\": " << (event.start_us - origin_us)
+             << ", \"dur\": " << event.duration_us << ", \"args\": {\"depth\": " << event.depth << "}}"
+             << (i + 1 < events.size() ? ",\n" : "");
+    }
+    return text.str();
+}
+
+bool Profiler::writeChromeTrace(const char* path, const std::string& events) {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Error: Cannot create trace file " << path << std::endl;
+        return false;
+    }
+
+    file << "{\"traceEvents\": [" << std::endl;
+    if (!events.empty()) {
+        file << events << std::endl;
+    }
+    file << "], \"displayTimeUnit\": \"ms\"}" << std::endl;
+    return static_cast<bool>(file);
+}
+
+bool Profiler::writeChromeTrace(const char* path) {
+    // Marcas relativas al primer evento para que la traza empiece en 0
+    return writeChromeTrace(path, formatTraceEvents(getFirstTimestamp()));
+}
+
+void Profiler::printSummary() {
+    std::vector<std::pair<int, Event> > events;
+    collect(events);
+
+    if (events.empty()) {
+        std::cout << "Profile: no zones recorded"
+                  << (isEnabled() ? "" : " (build with -DENABLE_PROFILING)") << std::endl;
+        return;
+    }
+
+    struct ZoneStats {
+        int calls;
+        long long total_us, max_us;
+        std::map<int, long long> per_thread_us;
+        ZoneStats() : calls(0), total_us(0), max_us(0) {}
+    };
+
+    // Orden de primera aparición en el tiempo: una zona padre antes que sus hijas
+    std::stable_sort(events.begin(), events.end(),
+                     [](const std::pair<int, Event>& a, const std::pair<int, Event>& b) {
+                         return a.second.start_us < b.second.start_us;
+                     });
+
+    std::vector<std::string> order;
+    std::map<std::string, ZoneStats> zones;
+    for (size_t i = 0; i < events.size(); i++) {
+        const Event& event = events[i].second;
+        std::string name(event.name);
+        if (zones.find(name) == zones.end()) {
+            order.push_back(name);
+        }
+        ZoneStats& stats = zones[name];
+        stats.calls++;
+        stats.total_us += event.duration_us;
+        stats.max_us = std::max(stats.max_us, event.duration_us);
+        stats.per_thread_us[events[i].first] += event.duration_us;
+    }
+
+    std::cout << "=== Profile (process " << process_id << ") ===" << std::endl;
+    std::cout << "zone\tcalls\ttotal ms\tmean ms\tmax ms\tthreads (min/max ms)" << std::endl;
+    for (size_t z = 0; z < order.size(); z++) {
+        const ZoneStats& stats = zones[order[z]];
+        long long thread_min = -1, thread_max = 0;
+        for (std::map<int, long long>::const_iterator it = stats.per_thread_us.begin();
+             it != stats.per_thread_us.end(); ++it) {
+            thread_min = (thread_min < 0) ? it->second : std::min(thread_min, it->second);
+            thread_max = std::max(thread_max, it->second);
+        }
+
+        std::cout << order[z] << "\t" << stats.calls << "\t" << stats.total_us / 1000.0 << "\t"
+                  << stats.total_us / 1000.0 / stats.calls << "\t" << stats.max_us / 1000.0 << "\t"
+                  << stats.per_thread_us.size() << " (" << thread_min / 1000.0 << "/" << thread_max / 1000.0
+                  << ")" << std::endl;
+    }
+}
+
+void Profiler::reset() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (size_t t = 0; t < registry().size(); t++) {
+        registry()[t]->events.clear();
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <vector>
+#include <string>
+#include "timer.h"
+
+// Zonas de perfilado jerárquicas. PROFILE_ZONE("nombre") mide el bloque
+// actual con un objeto RAII; las zonas se anidan y cada hilo las guarda en
+// un buffer propio (thread_local), sin bloqueos en el camino caliente. Al
+// final se exporta una traza trace_event de Chrome (chrome://tracing o
+// Perfetto) con un carril por hilo y un resumen plano por zona.
+//
+// Las zonas solo se compilan con -DENABLE_PROFILING; sin esa bandera
+// PROFILE_ZONE no genera código y la traza queda vacía.
+class Profiler {
+public:
+    // Una zona terminada
+    struct Event {
+        const char* name;       // literal: no se copia
+        long long start_us;
+        long long duration_us;
+        int depth;              // nivel de anidamiento dentro del hilo
+    };
+
+    // Identificador de proceso en la traza (el rango MPI, por ejemplo)
+    static void setProcessId(int pid);
+
+    // Indica si las zonas están compiladas
+    static bool isEnabled();
+
+    // Usadas por ProfileZone
+    static int enterZone();
+    static void leaveZone(const char* name, long long start_us, int depth);
+
+    // Escribe {"traceEvents": [...]} con eventos completos ("ph": "X")
+    static bool writeChromeTrace(const char* path);
+
+    // Piezas para combinar varias trazas (p. ej. una por rango MPI): los
+    // eventos de este proceso con marcas relativas a origin_us, y el
+    // archivo con eventos ya formateados
+    static long long getFirstTimestamp();  // 0 si no hay zonas
+    static std::string formatTraceEvents(long long origin_us);
+    static bool writeChromeTrace(const char* path, const std::string& events);
+
+    // Por zona: llamadas, tiempo total, medio y máximo; y tiempo por hilo
+    static void printSummary();
+
+    // Descarta los eventos registrados
+    static void reset();
+
+private:
+    struct ThreadBuffer;
+    static std::vector<ThreadBuffer*>& registry();
+    static ThreadBuffer* getThreadBuffer();
+    static void collect(std::vector<std::pair<int, Event> >& events);
+};
+
+// Mide desde su construcción hasta su destrucción
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* zone_name)
+        : name(zone_name), depth(Profiler::enterZone()), start_us(Timer::getTimestampMicroseconds()) {}
+    ~ProfileZone() { Profiler::leaveZone(name, start_us, depth); }
+
+private:
+    const char* name;
+    int depth;
+    long long start_us;
+
+    // No copiable
+    ProfileZone(const ProfileZone&);
+    ProfileZone& operator=(const ProfileZone&);
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef ENABLE_PROFILING
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name) do { } while (0)
+#endif
+
+#endif
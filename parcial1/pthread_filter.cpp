@@ -0,0 +1,70 @@
+#include "pthread_filter.h"
+#include "iterative_filter.h"
+#include "result_cache.h"
+#include "profiler.h"
+#include <vector>
+#include <algorithm>
+
+bool PthreadFilter::applyRows(Imagen* input, Imagen* output, Filter::FilterType filter_type, ThreadPool& pool) {
+    PROFILE_ZONE("filter");
+    
+    return ResultCache::apply(input, output, filter_type, 1, [&]() {
+        if (!Filter::prepareOutput(input, output)) {
+            return false;
+        }
+        
+        int width = input->getWidth();
+        int height = input->getHeight();
+        
+        // Repartir las filas entre los hilos del pool (un bloque contiguo por hilo)
+        std::vector<char> thread_success(std::max(1, pool.getNumThreads()), 1);
+        
+        pool.parallelFor(0, height, [&](int start_row, int end_row, int worker_id) {
+            PROFILE_ZONE("band");
+            if (!Filter::applyFilterRegion(input, output, filter_type, 0, start_row, width, end_row)) {
+                thread_success[worker_id] = 0;
+            }
+        });
+        
+        return std::find(thread_success.begin(), thread_success.end(), 0) == thread_success.end();
+    });
+}
+
+bool PthreadFilter::applyIterative(Imagen* input, Imagen* output, Filter::FilterType filter_type, int iterations,
+                                   int time_block, int tile_width, int tile_height, ThreadPool& pool) {
+    PROFILE_ZONE("filter");
+    
+    // Los tiles de cada pasada se reparten dinámicamente, de uno en uno
+    IterativeFilter::TileRunner runner = [&](int count, const IterativeFilter::TileTask& tile) {
+        pool.parallelFor(0, count, [&](int begin, int end, int) {
+            PROFILE_ZONE("tile");
+            for (int i = begin; i < end; i++) {
+                tile(i);
+            }
+        }, 1);
+    };
+    
+    return IterativeFilter::apply(input, output, filter_type, iterations, runner,
+                                  tile_width, tile_height, time_block);
+}
+
+bool PthreadFilter::applyTiles(Imagen* input, Imagen* output, Filter::FilterType filter_type, TileScheduler& scheduler) {
+    PROFILE_ZONE("filter");
+    
+    return ResultCache::apply(input, output, filter_type, 1, [&]() {
+        if (!Filter::prepareOutput(input, output)) {
+            return false;
+        }
+        
+        std::vector<char> thread_success(std::max(1, scheduler.getNumWorkers()), 1);
+        
+        scheduler.run(input->getWidth(), input->getHeight(), [&](const Tile& tile, int worker_id) {
+            PROFILE_ZONE("tile");
+            if (!Filter::applyFilterRegion(input, output, filter_type, tile.x0, tile.y0, tile.x1, tile.y1)) {
+                thread_success[worker_id] = 0;
+            }
+        });
+        
+        return std::find(thread_success.begin(), thread_success.end(), 0) == thread_success.end();
+    });
+}
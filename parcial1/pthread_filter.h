@@ -0,0 +1,25 @@
+#ifndef PTHREAD_FILTER_H
+#define PTHREAD_FILTER_H
+
+#include "imagen.h"
+#include "filter.h"
+#include "thread_pool.h"
+#include "tile_scheduler.h"
+
+// Backend de pthreads como biblioteca: lo usan processor_pthread y el
+// arnés de rendimiento. Todas las variantes reutilizan un pool persistente
+// y consultan la caché de resultados (ResultCache) si está activa.
+class PthreadFilter {
+public:
+    // Un bloque estático de filas por hilo
+    static bool applyRows(Imagen* input, Imagen* output, Filter::FilterType filter_type, ThreadPool& pool);
+
+    // Tiles 2D con robo de trabajo
+    static bool applyTiles(Imagen* input, Imagen* output, Filter::FilterType filter_type, TileScheduler& scheduler);
+
+    // N iteraciones con bloqueo temporal; los tiles de cada pasada se reparten de uno en uno
+    static bool applyIterative(Imagen* input, Imagen* output, Filter::FilterType filter_type, int iterations,
+                               int time_block, int tile_width, int tile_height, ThreadPool& pool);
+};
+
+#endif
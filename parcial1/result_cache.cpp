@@ -0,0 +1,363 @@
+#include "result_cache.h"
+#include "memory_tracker.h"
+#include "timer.h"
+#include "profiler.h"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+const char* const ResultCache::VERSION = "1";
+const size_t ResultCache::DEFAULT_MAX_BYTES = static_cast<size_t>(1) << 30;
+
+// Header de cada archivo .res; le sigue el raster (pixel_count enteros)
+struct CacheEntryHeader {
+    char magic[8];                  // "PRCACHE1"
+    unsigned long long key_high, key_low;
+    int width, height, channels, max_color;
+    long long pixel_count;
+};
+
+static const char ENTRY_MAGIC[8] = {'P', 'R', 'C', 'A', 'C', 'H', 'E', '1'};
+static const char* const ENTRY_SUFFIX = ".res";
+
+static std::mutex cache_mutex;      // estadísticas y expulsión
+static std::string cache_directory;
+static size_t cache_max_bytes = 0;
+static bool cache_enabled = false;
+static ResultCache::Stats cache_stats = {0, 0, 0, 0, 0.0, 0.0};
+static std::atomic<unsigned int> temp_counter(0);
+
+// true mientras el hilo está dentro de apply: las llamadas anidadas (p. ej.
+// PthreadFilter::applyIterative -> IterativeFilter::apply) no repiten la búsqueda
+static thread_local bool inside_apply = false;
+
+static const unsigned long long PRIME_1 = 0x9E3779B185EBCA87ULL;
+static const unsigned long long PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+static const unsigned long long PRIME_3 = 0x165667B19E3779F9ULL;
+static const unsigned long long PRIME_4 = 0x85EBCA77C2B2AE63ULL;
+
+static inline unsigned long long rotateLeft(unsigned long long x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// Finalizador de splitmix64: cada bit de entrada afecta a todos los de salida
+static inline unsigned long long avalanche(unsigned long long x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// FNV-1a de la descripción del trabajo; es la semilla del hash del raster
+static unsigned long long hashText(const std::string& text) {
+    unsigned long long hash = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < text.size(); i++) {
+        hash ^= static_cast<unsigned char>(text[i]);
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+struct EntryFile {
+    std::string path;
+    size_t bytes;
+    struct timespec modified;
+};
+
+// Resultados guardados en el directorio (los temporales a medio escribir no cuentan)
+static void listEntries(const std::string& directory, std::vector<EntryFile>& entries) {
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        return;
+    }
+    const size_t suffix_length = strlen(ENTRY_SUFFIX);
+    while (struct dirent* item = readdir(dir)) {
+        size_t length = strlen(item->d_name);
+        if (item->d_name[0] == '.' || length <= suffix_length ||
+            strcmp(item->d_name + length - suffix_length, ENTRY_SUFFIX) != 0) {
+            continue;
+        }
+        EntryFile entry;
+        entry.path = directory + "/" + item->d_name;
+        struct stat info;
+        if (stat(entry.path.c_str(), &info) != 0) {
+            continue; // otro proceso lo acaba de borrar
+        }
+        entry.bytes = static_cast<size_t>(info.st_size);
+        entry.modified = info.st_mtim;
+        entries.push_back(entry);
+    }
+    closedir(dir);
+}
+
+bool ResultCache::enable(const char* directory, size_t max_bytes) {
+    if (!directory || !*directory) {
+        std::cerr << "Error: Empty result cache directory" << std::endl;
+        return false;
+    }
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+        std::cerr << "Error: Cannot create result cache directory " << directory << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (stat(directory, &info) != 0 || !S_ISDIR(info.st_mode)) {
+        std::cerr << "Error: Result cache path " << directory << " is not a directory" << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache_directory = directory;
+    cache_max_bytes = max_bytes;
+    cache_enabled = true;
+    // El límite puede ser menor que el de una ejecución anterior
+    evict(max_bytes);
+    return true;
+}
+
+void ResultCache::disable() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache_enabled = false;
+}
+
+bool ResultCache::isEnabled() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    return cache_enabled;
+}
+
+ResultCache::Key ResultCache::computeKey(const Imagen* image, Filter::FilterType filter_type, int iterations) {
+    const int width = image->getWidth();
+    const int height = image->getHeight();
+    const long long count = image->getPixelCount();
+    const int channels = (width > 0 && height > 0) ? static_cast<int>(count / (static_cast<long long>(width) * height)) : 0;
+
+    std::ostringstream description;
+    description << "v" << VERSION << " " << Filter::filterTypeToString(filter_type) << " x" << iterations << " "
+                << width << "x" << height << "x" << channels << " max " << image->getMaxColor();
+    const unsigned long long seed = hashText(description.str());
+
+    // Cuatro carriles independientes de 64 bits (dos muestras por palabra):
+    // el bucle avanza a 32 bytes por vuelta sin cadenas de dependencia largas
+    unsigned long long lanes[4] = {seed + PRIME_1 + PRIME_2, seed + PRIME_2, seed, seed - PRIME_1};
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(image->getPixels());
+    const size_t length = static_cast<size_t>(count) * sizeof(int);
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        for (int lane = 0; lane < 4; lane++) {
+            unsigned long long word;
+            memcpy(&word, bytes + i + 8 * lane, sizeof(word));
+            lanes[lane] = rotateLeft(lanes[lane] + word * PRIME_2, 31) * PRIME_1;
+        }
+    }
+    for (; i < length; i += sizeof(int)) {
+        unsigned int sample;
+        memcpy(&sample, bytes + i, sizeof(sample));
+        lanes[0] = rotateLeft(lanes[0] ^ (sample * PRIME_1), 23) * PRIME_2 + PRIME_3;
+    }
+
+    Key key;
+    key.high = avalanche(rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) +
+                         rotateLeft(lanes[3], 18) + length);
+    key.low = avalanche((lanes[0] ^ PRIME_4) * PRIME_3 + rotateLeft(lanes[1] ^ lanes[3], 29) + lanes[2] + key.high);
+    return key;
+}
+
+std::string ResultCache::entryPath(const Key& key) {
+    char name[40];
+    snprintf(name, sizeof(name), "%016llx%016llx", key.high, key.low);
+    return cache_directory + "/" + name + ENTRY_SUFFIX;
+}
+
+bool ResultCache::lookup(const Key& key, Imagen* input, Imagen* output) {
+    const std::string path = entryPath(key);
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    bool hit = false;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(CacheEntryHeader)) {
+        void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+            CacheEntryHeader header;
+            memcpy(&header, mapping, sizeof(header));
+
+            // Un archivo truncado, de otra versión o (muy improbable) de otra
+            // clave con el mismo nombre se trata como un fallo
+            const bool valid = memcmp(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) == 0 &&
+                               header.key_high == key.high && header.key_low == key.low &&
+                               header.width == input->getWidth() && header.height == input->getHeight() &&
+                               header.max_color == input->getMaxColor() &&
+                               header.pixel_count == input->getPixelCount() &&
+                               static_cast<size_t>(info.st_size) ==
+                                   sizeof(header) + static_cast<size_t>(header.pixel_count) * sizeof(int);
+
+            if (valid && Filter::prepareOutput(input, output) && output->getPixelCount() == header.pixel_count) {
+                memcpy(output->getPixels(), static_cast<const char*>(mapping) + sizeof(header),
+                       static_cast<size_t>(header.pixel_count) * sizeof(int));
+                // Usado ahora: el último candidato a la expulsión LRU
+                futimens(fd, nullptr);
+                hit = true;
+            }
+            munmap(mapping, info.st_size);
+        }
+    }
+    close(fd);
+    return hit;
+}
+
+void ResultCache::store(const Key& key, const Imagen* output) {
+    const size_t count = static_cast<size_t>(output->getPixelCount());
+    const size_t bytes = sizeof(CacheEntryHeader) + count * sizeof(int);
+    if (bytes > cache_max_bytes) {
+        return; // no cabría ni con la caché vacía
+    }
+
+    CacheEntryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+    header.key_high = key.high;
+    header.key_low = key.low;
+    header.width = output->getWidth();
+    header.height = output->getHeight();
+    header.channels = (header.width > 0 && header.height > 0)
+                          ? static_cast<int>(count / (static_cast<size_t>(header.width) * header.height)) : 0;
+    header.max_color = output->getMaxColor();
+    header.pixel_count = static_cast<long long>(count);
+
+    // Temporal oculto (no lo ve listEntries) y rename atómico al nombre final
+    const std::string path = entryPath(key);
+    std::ostringstream temp_path;
+    temp_path << cache_directory << "/.tmp." << getpid() << "." << temp_counter++;
+
+    FILE* file = fopen(temp_path.str().c_str(), "wb");
+    if (!file) {
+        std::cerr << "Warning: Cannot write result cache entry in " << cache_directory << std::endl;
+        return;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(output->getPixels(), sizeof(int), count, file) == count;
+    written = (fclose(file) == 0) && written;
+    if (!written || rename(temp_path.str().c_str(), path.c_str()) != 0) {
+        std::cerr << "Warning: Cannot write result cache entry " << path << std::endl;
+        unlink(temp_path.str().c_str());
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache_stats.stores++;
+    evict(cache_max_bytes);
+}
+
+void ResultCache::evict(size_t max_bytes) {
+    std::vector<EntryFile> entries;
+    listEntries(cache_directory, entries);
+
+    size_t total = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        total += entries[i].bytes;
+    }
+    if (total <= max_bytes) {
+        return;
+    }
+
+    // Los menos usados primero (la fecha se actualiza en cada acierto)
+    std::sort(entries.begin(), entries.end(), [](const EntryFile& a, const EntryFile& b) {
+        return a.modified.tv_sec != b.modified.tv_sec ? a.modified.tv_sec < b.modified.tv_sec
+                                                      : a.modified.tv_nsec < b.modified.tv_nsec;
+    });
+    for (size_t i = 0; i < entries.size() && total > max_bytes; i++) {
+        if (unlink(entries[i].path.c_str()) == 0) {
+            cache_stats.evictions++;
+        }
+        total -= entries[i].bytes; // si otro proceso lo borró antes, tampoco ocupa
+    }
+}
+
+bool ResultCache::apply(Imagen* input, Imagen* output, Filter::FilterType filter_type, int iterations,
+                        const Compute& compute) {
+    if (inside_apply || !isEnabled() || !input || !output || iterations < 1 ||
+        !Filter::getKernel(filter_type) || !input->getPixels()) {
+        return compute();
+    }
+
+    PROFILE_ZONE("result_cache");
+    Timer hash_timer;
+    hash_timer.start();
+    const Key key = computeKey(input, filter_type, iterations);
+    hash_timer.stop();
+
+    Timer serve_timer;
+    serve_timer.start();
+    const bool hit = lookup(key, input, output);
+    serve_timer.stop();
+
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        cache_stats.hash_ms += hash_timer.getElapsedMilliseconds();
+        if (hit) {
+            cache_stats.hits++;
+            cache_stats.serve_ms += serve_timer.getElapsedMilliseconds();
+        } else {
+            cache_stats.misses++;
+        }
+    }
+    if (hit) {
+        return true;
+    }
+
+    inside_apply = true;
+    const bool success = compute();
+    inside_apply = false;
+
+    if (success) {
+        store(key, output);
+    }
+    return success;
+}
+
+ResultCache::Stats ResultCache::getStats() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    return cache_stats;
+}
+
+size_t ResultCache::getUsedBytes() {
+    std::vector<EntryFile> entries;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        listEntries(cache_directory, entries);
+    }
+    size_t total = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        total += entries[i].bytes;
+    }
+    return total;
+}
+
+void ResultCache::printStats(std::ostream& out) {
+    const Stats stats = getStats();
+    const long long lookups = stats.hits + stats.misses;
+    out << "Result cache: " << stats.hits << (stats.hits == 1 ? " hit, " : " hits, ")
+        << stats.misses << (stats.misses == 1 ? " miss" : " misses");
+    if (lookups > 0) {
+        out << " (" << 100.0 * stats.hits / lookups << "% hit rate)";
+    }
+    out << ", " << stats.stores << " stored, " << stats.evictions << " evicted" << std::endl;
+    out << "  " << MemoryTracker::toMegabytes(getUsedBytes()) << " of "
+        << MemoryTracker::toMegabytes(cache_max_bytes) << " MB used in " << cache_directory
+        << " (hashing " << stats.hash_ms << " ms, serving hits " << stats.serve_ms << " ms)" << std::endl;
+}
@@ -0,0 +1,76 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <cstddef>
+#include <string>
+#include <iosfwd>
+#include <functional>
+#include "imagen.h"
+#include "filter.h"
+
+// Caché en disco de resultados de filtros, direccionada por contenido. La
+// clave es un hash rápido de 128 bits del raster ya decodificado (no del
+// archivo: la misma imagen en P2 o P5 da la misma clave) junto con el
+// formato, el tamaño, el filtro, las iteraciones y VERSION. Cada resultado
+// es un archivo <clave>.res en el directorio de la caché con un header y el
+// raster de enteros tal cual; un acierto lo proyecta con mmap y lo copia a
+// la salida sin filtrar nada.
+//
+// El tamaño total se limita con expulsión LRU: un acierto actualiza la fecha
+// de modificación del archivo y al guardar se borran los más antiguos hasta
+// volver al límite. Los archivos se escriben con un nombre temporal y se
+// renombran, así varios procesos (p. ej. un lote MPI) pueden compartir el
+// directorio.
+//
+// Está desactivada por defecto; Filter::applyFilter, IterativeFilter::apply
+// y los procesadores la consultan a través de apply().
+class ResultCache {
+public:
+    // Cambiar cuando un filtro dé resultados distintos: invalida lo guardado
+    static const char* const VERSION;
+    static const size_t DEFAULT_MAX_BYTES;   // 1 GB
+
+    struct Stats {
+        long long hits;
+        long long misses;
+        long long stores;
+        long long evictions;
+        double hash_ms;          // tiempo calculando claves
+        double serve_ms;         // tiempo sirviendo aciertos
+    };
+
+    typedef std::function<bool()> Compute;
+
+    // Crea el directorio si no existe; false (e imprime el motivo) si no se puede
+    static bool enable(const char* directory, size_t max_bytes = DEFAULT_MAX_BYTES);
+    static void disable();
+    static bool isEnabled();
+
+    // Deja en 'output' el resultado de aplicar filter_type 'iterations' veces
+    // a 'input': lo sirve de la caché si está, y si no ejecuta compute (que
+    // debe llenar 'output') y guarda el resultado. Sin caché, o dentro de otra
+    // llamada a apply en el mismo hilo, solo ejecuta compute.
+    static bool apply(Imagen* input, Imagen* output, Filter::FilterType filter_type, int iterations,
+                      const Compute& compute);
+
+    static Stats getStats();
+
+    // Bytes que ocupan ahora los resultados guardados
+    static size_t getUsedBytes();
+
+    // Imprime "Result cache: N hits, M misses (...), S stored, E evicted, X of Y MB in <dir>"
+    static void printStats(std::ostream& out);
+
+private:
+    struct Key {
+        unsigned long long high, low;
+    };
+
+    static Key computeKey(const Imagen* image, Filter::FilterType filter_type, int iterations);
+    static std::string entryPath(const Key& key);
+    static bool lookup(const Key& key, Imagen* input, Imagen* output);
+    static void store(const Key& key, const Imagen* output);
+    static void evict(size_t max_bytes);
+};
+
+#endif
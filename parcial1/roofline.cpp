@@ -0,0 +1,135 @@
+#include "roofline.h"
+#include <iostream>
+#include <algorithm>
+#include "timer.h"
+
+// Cadenas independientes por hilo: suficientes para cubrir la latencia de la
+// unidad de punto flotante y permitir que el compilador las vectorice
+static const int FLOP_CHAINS = 16;
+static const long long FLOP_ITERATIONS = 1LL << 22;
+
+// Evitan que el compilador pliegue las constantes o elimine el cálculo
+static volatile float flop_multiplier = 0.999999f;
+static volatile float flop_addend = 1e-6f;
+static volatile float flop_sink;
+
+static float runFlopKernel(long long iterations) {
+    const float multiplier = flop_multiplier;
+    const float addend = flop_addend;
+    float accumulators[FLOP_CHAINS];
+    for (int j = 0; j < FLOP_CHAINS; j++) {
+        accumulators[j] = static_cast<float>(j) * 0.001f;
+    }
+
+    for (long long i = 0; i < iterations; i++) {
+        for (int j = 0; j < FLOP_CHAINS; j++) {
+            accumulators[j] = accumulators[j] * multiplier + addend;
+        }
+    }
+
+    float sum = 0.0f;
+    for (int j = 0; j < FLOP_CHAINS; j++) {
+        sum += accumulators[j];
+    }
+    return sum;
+}
+
+// Ejecuta [0, count) repartido entre los hilos del pool, o en el hilo actual
+static void runRange(ThreadPool* pool, int count, const ThreadPool::RangeTask& task) {
+    if (pool) {
+        pool->parallelFor(0, count, task);
+    } else {
+        task(0, count, 0);
+    }
+}
+
+Roofline::Ceilings Roofline::measure(ThreadPool* pool, size_t array_bytes, int repetitions) {
+    Ceilings ceilings;
+    ceilings.threads = pool ? pool->getNumThreads() : 1;
+    ceilings.copy_gb_s = 0.0;
+    ceilings.triad_gb_s = 0.0;
+    ceilings.peak_gflop_s = 0.0;
+
+    const int count = static_cast<int>(std::max(static_cast<size_t>(1), array_bytes / sizeof(double)));
+    double* a = new double[count];
+    double* b = new double[count];
+    double* c = new double[count];
+
+    // Primer toque con el mismo reparto que las mediciones: cada hilo lee su parte de su nodo
+    runRange(pool, count, [&](int begin, int end, int) {
+        for (int i = begin; i < end; i++) {
+            a[i] = 0.0;
+            b[i] = 1.0;
+            c[i] = 2.0;
+        }
+    });
+
+    const double scalar = 3.0;
+    const double copy_bytes = 2.0 * sizeof(double) * count;
+    const double triad_bytes = 3.0 * sizeof(double) * count;
+
+    for (int rep = 0; rep < repetitions; rep++) {
+        Timer timer;
+        timer.start();
+        runRange(pool, count, [&](int begin, int end, int) {
+            for (int i = begin; i < end; i++) {
+                a[i] = b[i];
+            }
+        });
+        timer.stop();
+        ceilings.copy_gb_s = std::max(ceilings.copy_gb_s, copy_bytes / (timer.getElapsedMilliseconds() * 1e6));
+
+        timer.start();
+        runRange(pool, count, [&](int begin, int end, int) {
+            for (int i = begin; i < end; i++) {
+                a[i] = b[i] + scalar * c[i];
+            }
+        });
+        timer.stop();
+        ceilings.triad_gb_s = std::max(ceilings.triad_gb_s, triad_bytes / (timer.getElapsedMilliseconds() * 1e6));
+    }
+
+    delete[] a;
+    delete[] b;
+    delete[] c;
+
+    // Pico de cálculo: cada hilo ejecuta el mismo número de iteraciones
+    const double flops = 2.0 * FLOP_CHAINS * FLOP_ITERATIONS * ceilings.threads;
+    for (int rep = 0; rep < repetitions; rep++) {
+        Timer timer;
+        timer.start();
+        runRange(pool, ceilings.threads, [&](int begin, int end, int) {
+            for (int t = begin; t < end; t++) {
+                flop_sink = runFlopKernel(FLOP_ITERATIONS);
+            }
+        });
+        timer.stop();
+        ceilings.peak_gflop_s = std::max(ceilings.peak_gflop_s, flops / (timer.getElapsedMilliseconds() * 1e6));
+    }
+
+    return ceilings;
+}
+
+double Roofline::getFlopsPerPixel(int channels) {
+    // Una multiplicación y una suma por posición del kernel y canal
+    return 2.0 * 9 * channels;
+}
+
+double Roofline::getBytesPerPixel(int channels) {
+    // Leer la entrada y escribir la salida una vez; el halo se reutiliza desde caché
+    return 2.0 * channels * sizeof(int);
+}
+
+double Roofline::getArithmeticIntensity(int channels) {
+    return getFlopsPerPixel(channels) / getBytesPerPixel(channels);
+}
+
+double Roofline::getAttainableGflops(const Ceilings& ceilings, double intensity) {
+    return std::min(ceilings.peak_gflop_s, intensity * ceilings.triad_gb_s);
+}
+
+void Roofline::printCeilings(const Ceilings& ceilings) {
+    std::cout << "  " << ceilings.threads << " thread(s): copy " << ceilings.copy_gb_s << " GB/s, triad "
+              << ceilings.triad_gb_s << " GB/s, peak " << ceilings.peak_gflop_s << " GFLOP/s, ridge point "
+              << ceilings.getRidgePoint() << " flop/byte" << std::endl;
+}
@@ -0,0 +1,44 @@
+#ifndef ROOFLINE_H
+#define ROOFLINE_H
+
+#include <cstddef>
+#include "thread_pool.h"
+
+// Modelo roofline de esta máquina. Mide los dos techos (ancho de banda de
+// memoria sostenido, estilo STREAM, y rendimiento máximo en float con el
+// mismo compilador y banderas que los filtros) y calcula la intensidad
+// aritmética de la convolución 3x3. El rendimiento alcanzable de un kernel
+// con intensidad I es min(pico, I * ancho de banda).
+class Roofline {
+public:
+    struct Ceilings {
+        int threads;
+        double copy_gb_s;      // a[i] = b[i]
+        double triad_gb_s;     // a[i] = b[i] + s * c[i]: techo de memoria
+        double peak_gflop_s;   // multiplicación-suma en float, cadenas independientes
+
+        // Intensidad (flop/byte) a partir de la cual un kernel deja de estar limitado por memoria
+        double getRidgePoint() const { return triad_gb_s > 0 ? peak_gflop_s / triad_gb_s : 0.0; }
+    };
+
+    // Cada arreglo de STREAM debe superar varias veces la caché de último nivel
+    static const size_t DEFAULT_ARRAY_BYTES = static_cast<size_t>(64) << 20;
+
+    // Con pool mide usando todos sus hilos; con nullptr, solo el hilo actual.
+    // Se toma la mejor de 'repetitions' pasadas, como STREAM.
+    static Ceilings measure(ThreadPool* pool, size_t array_bytes = DEFAULT_ARRAY_BYTES, int repetitions = 5);
+
+    // Trabajo y tráfico mínimo por píxel de la convolución 3x3 con 'channels'
+    // enteros por píxel. Los tres filtros recorren las 9 posiciones del kernel
+    // (también los ceros), así que la intensidad es la misma para todos.
+    static double getFlopsPerPixel(int channels);
+    static double getBytesPerPixel(int channels);
+    static double getArithmeticIntensity(int channels);
+
+    // min(pico, intensidad * ancho de banda) en GFLOP/s
+    static double getAttainableGflops(const Ceilings& ceilings, double intensity);
+
+    static void printCeilings(const Ceilings& ceilings);
+};
+
+#endif
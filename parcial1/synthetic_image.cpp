@@ -0,0 +1,301 @@
+#include "synthetic_image.h"
+#include "PGMimage.h"
+#include "PPMimage.h"
+#include "profiler.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+
+static const char* SPEC_PREFIX = "synth:";
+static const int CHECKER_CELL = 16;
+// Octavas del patrón natural: periodos de 2 a 256 píxeles
+static const int NATURAL_OCTAVES = 8;
+
+// Mezclador de splitmix64: cada bit de la entrada afecta a todos los de la salida
+static inline unsigned long long mix(unsigned long long value) {
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+static inline unsigned int hashSample(unsigned int x, unsigned int y, unsigned int z, unsigned int seed) {
+    return static_cast<unsigned int>(mix(mix(mix(seed ^ (static_cast<unsigned long long>(z) << 32)) ^ x) ^
+                                         (static_cast<unsigned long long>(y) << 32)) >> 32);
+}
+
+// Valor pseudoaleatorio en [0, 1) en un nodo de la retícula
+static inline float latticeValue(int x, int y, unsigned int octave, unsigned int seed) {
+    return (hashSample(static_cast<unsigned int>(x), static_cast<unsigned int>(y), octave, seed) >> 8) *
+           (1.0f / 16777216.0f);
+}
+
+// Suma de octavas de ruido de valor (retícula con periodo 2^octava e
+// interpolación suavizada) con amplitud proporcional al periodo: espectro
+// ~1/f. Se calcula una fila entera por octava para evaluar cada nodo de la
+// retícula una sola vez en lugar de cuatro veces por píxel.
+static void fractalRow(int width, int y, int first_octave, unsigned int seed, std::vector<float>& row,
+                       std::vector<float>& top, std::vector<float>& bottom) {
+    row.assign(width, 0.0f);
+    float total = 0.0f;
+
+    for (int octave = first_octave; octave <= NATURAL_OCTAVES; octave++) {
+        const int period = 1 << octave;
+        const int cell_y = y >> octave;
+        const int cells = (width >> octave) + 2;
+        top.resize(cells);
+        bottom.resize(cells);
+        for (int cell_x = 0; cell_x < cells; cell_x++) {
+            top[cell_x] = latticeValue(cell_x, cell_y, octave, seed);
+            bottom[cell_x] = latticeValue(cell_x, cell_y + 1, octave, seed);
+        }
+
+        float fy = static_cast<float>(y & (period - 1)) / period;
+        fy = fy * fy * (3.0f - 2.0f * fy);
+        const float amplitude = static_cast<float>(period);
+
+        for (int x = 0; x < width; x++) {
+            const int cell_x = x >> octave;
+            float fx = static_cast<float>(x & (period - 1)) / period;
+            fx = fx * fx * (3.0f - 2.0f * fx);
+            const float upper = top[cell_x] + (top[cell_x + 1] - top[cell_x]) * fx;
+            const float lower = bottom[cell_x] + (bottom[cell_x + 1] - bottom[cell_x]) * fx;
+            row[x] += amplitude * (upper + (lower - upper) * fy);
+        }
+        total += amplitude;
+    }
+
+    for (int x = 0; x < width; x++) {
+        row[x] /= total;
+    }
+}
+
+static inline int toSample(float value) {
+    int sample = static_cast<int>(value * 256.0f);
+    return sample < 0 ? 0 : (sample > 255 ? 255 : sample);
+}
+
+bool SyntheticImage::stringToPattern(const char* name, Pattern& pattern) {
+    if (strcmp(name, "noise") == 0) {
+        pattern = NOISE;
+    } else if (strcmp(name, "gradient") == 0) {
+        pattern = GRADIENT;
+    } else if (strcmp(name, "checkerboard") == 0 || strcmp(name, "checker") == 0) {
+        pattern = CHECKERBOARD;
+    } else if (strcmp(name, "natural") == 0) {
+        pattern = NATURAL;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* SyntheticImage::patternToString(Pattern pattern) {
+    switch (pattern) {
+        case NOISE: return "noise";
+        case GRADIENT: return "gradient";
+        case CHECKERBOARD: return "checkerboard";
+        case NATURAL: return "natural";
+        default: return "unknown";
+    }
+}
+
+bool SyntheticImage::isSpec(const char* source) {
+    return source && strncmp(source, SPEC_PREFIX, strlen(SPEC_PREFIX)) == 0;
+}
+
+bool SyntheticImage::parseSpec(const char* source, Spec& spec) {
+    if (!isSpec(source)) {
+        return false;
+    }
+
+    // synth:patrón[:WxH][:pgm|ppm][:semilla], en cualquier orden tras el patrón
+    std::stringstream fields(source + strlen(SPEC_PREFIX));
+    std::string field;
+    bool first = true;
+    while (std::getline(fields, field, ':')) {
+        int width, height;
+        char extra;
+        if (first) {
+            if (!stringToPattern(field.c_str(), spec.pattern)) {
+                std::cerr << "Error: Unknown synthetic pattern '" << field
+                          << "' (noise, gradient, checkerboard, natural)" << std::endl;
+                return false;
+            }
+            first = false;
+        } else if (sscanf(field.c_str(), "%dx%d%c", &width, &height, &extra) == 2) {
+            spec.width = width;
+            spec.height = height;
+        } else if (field == "pgm") {
+            spec.channels = 1;
+        } else if (field == "ppm") {
+            spec.channels = 3;
+        } else if (!field.empty() && field.find_first_not_of("0123456789") == std::string::npos) {
+            spec.seed = static_cast<unsigned int>(strtoul(field.c_str(), nullptr, 10));
+        } else {
+            std::cerr << "Error: Invalid field '" << field << "' in " << source << std::endl;
+            return false;
+        }
+    }
+
+    if (first || spec.width <= 0 || spec.height <= 0 || spec.width > MAX_DIMENSION ||
+        spec.height > MAX_DIMENSION) {
+        std::cerr << "Error: Invalid synthetic image " << source << " (sizes from 1x1 to " << MAX_DIMENSION
+                  << "x" << MAX_DIMENSION << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void SyntheticImage::generateRow(const Spec& spec, int y, int* row) {
+    const int channels = spec.channels;
+
+    if (spec.pattern == NATURAL) {
+        // Luminancia fractal con contraste ampliado (la suma de octavas se
+        // concentra cerca de 0.5) y, en color, un tinte de baja frecuencia
+        std::vector<float> luminance, tint, top, bottom;
+        fractalRow(spec.width, y, 1, spec.seed, luminance, top, bottom);
+        for (int x = 0; x < spec.width; x++) {
+            luminance[x] = 0.5f + 2.0f * (luminance[x] - 0.5f);
+        }
+
+        if (channels == 1) {
+            for (int x = 0; x < spec.width; x++) {
+                row[x] = toSample(luminance[x]);
+            }
+            return;
+        }
+        for (int c = 0; c < 3; c++) {
+            fractalRow(spec.width, y, NATURAL_OCTAVES - 1, spec.seed + 1 + c, tint, top, bottom);
+            for (int x = 0; x < spec.width; x++) {
+                row[static_cast<size_t>(x) * 3 + c] = toSample(luminance[x] + 0.5f * (tint[x] - 0.5f));
+            }
+        }
+        return;
+    }
+
+    for (int x = 0; x < spec.width; x++) {
+        int* sample = row + static_cast<size_t>(x) * channels;
+
+        switch (spec.pattern) {
+            case NOISE:
+                for (int c = 0; c < channels; c++) {
+                    sample[c] = static_cast<int>(hashSample(x, y, c, spec.seed) & 255);
+                }
+                break;
+
+            case GRADIENT: {
+                const long long horizontal = 255LL * x / (spec.width > 1 ? spec.width - 1 : 1);
+                const long long vertical = 255LL * y / (spec.height > 1 ? spec.height - 1 : 1);
+                if (channels == 1) {
+                    sample[0] = static_cast<int>((horizontal + vertical) / 2);
+                } else {
+                    sample[0] = static_cast<int>(horizontal);
+                    sample[1] = static_cast<int>(vertical);
+                    sample[2] = static_cast<int>(255 - (horizontal + vertical) / 2);
+                }
+                break;
+            }
+
+            case CHECKERBOARD:
+            default: {
+                const int value = (((x / CHECKER_CELL) + (y / CHECKER_CELL)) & 1) ? 255 : 0;
+                for (int c = 0; c < channels; c++) {
+                    sample[c] = value;
+                }
+                break;
+            }
+        }
+    }
+}
+
+Imagen* SyntheticImage::create(const Spec& spec) {
+    PROFILE_ZONE("synthesize");
+
+    const long long samples = static_cast<long long>(spec.width) * spec.height * spec.channels;
+    if (samples > INT_MAX) {
+        std::cerr << "Error: Synthetic image " << spec.width << "x" << spec.height << "x" << spec.channels
+                  << " exceeds " << INT_MAX << " samples; generate it to disk instead" << std::endl;
+        return nullptr;
+    }
+
+    Imagen* image = nullptr;
+    if (spec.channels == 3) {
+        image = new PPMImage();
+    } else {
+        image = new PGMImage();
+    }
+    image->setWidth(spec.width);
+    image->setHeight(spec.height);
+    image->setMaxColor(255);
+    image->setBinary(true);
+    image->allocatePixels();
+
+    int* pixels = image->getPixels();
+    if (!pixels) {
+        std::cerr << "Error: Cannot allocate " << spec.width << "x" << spec.height << " synthetic image" << std::endl;
+        delete image;
+        return nullptr;
+    }
+
+    const size_t row_samples = static_cast<size_t>(spec.width) * spec.channels;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int y = 0; y < spec.height; y++) {
+        generateRow(spec, y, pixels + row_samples * y);
+    }
+    return image;
+}
+
+Imagen* SyntheticImage::createFromSpec(const char* source) {
+    Spec spec;
+    if (!parseSpec(source, spec)) {
+        return nullptr;
+    }
+    return create(spec);
+}
+
+bool SyntheticImage::write(const Spec& spec, const char* filename, bool binary) {
+    PROFILE_ZONE("synthesize");
+
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        std::cerr << "Error: Cannot create file " << filename << std::endl;
+        return false;
+    }
+
+    const char* magic = (spec.channels == 3) ? (binary ? "P6" : "P3") : (binary ? "P5" : "P2");
+    fprintf(file, "%s\n%d %d\n%d\n", magic, spec.width, spec.height, 255);
+
+    // Una fila a la vez: el tamaño no está limitado por la memoria
+    const size_t row_samples = static_cast<size_t>(spec.width) * spec.channels;
+    std::vector<int> row(row_samples);
+    std::vector<unsigned char> bytes(binary ? row_samples : 0);
+    bool written = true;
+
+    for (int y = 0; y < spec.height && written; y++) {
+        generateRow(spec, y, row.data());
+        if (binary) {
+            for (size_t i = 0; i < row_samples; i++) {
+                bytes[i] = static_cast<unsigned char>(row[i]);
+            }
+            written = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+        } else {
+            for (size_t i = 0; i < row_samples && written; i++) {
+                written = fprintf(file, "%d\n", row[i]) > 0;
+            }
+        }
+    }
+
+    written = (fclose(file) == 0) && written;
+    if (!written) {
+        std::cerr << "Error: Cannot write pixel data to " << filename << std::endl;
+    }
+    return written;
+}
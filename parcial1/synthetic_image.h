@@ -0,0 +1,56 @@
+#ifndef SYNTHETIC_IMAGE_H
+#define SYNTHETIC_IMAGE_H
+
+#include "imagen.h"
+
+// Generador de imágenes sintéticas deterministas para estudios de escalado.
+// Cada muestra depende solo de (x, y, canal, semilla), así que las filas se
+// generan en cualquier orden y en paralelo con el mismo resultado. Se puede
+// escribir a disco fila a fila (sin el raster completo en memoria) o crear
+// directamente en memoria y pasar al filtro sin tocar el disco.
+//
+// Los programas aceptan como archivo de entrada una especificación
+// "synth:patrón:WxH[:pgm|ppm][:semilla]", p. ej. "synth:natural:8192x8192:ppm".
+class SyntheticImage {
+public:
+    enum Pattern {
+        NOISE,          // ruido blanco uniforme
+        GRADIENT,       // rampas horizontal, vertical y diagonal
+        CHECKERBOARD,   // casillas de 16x16 blanco/negro
+        NATURAL         // ruido fractal con espectro ~1/f, como una foto
+    };
+
+    struct Spec {
+        Pattern pattern;
+        int width;
+        int height;
+        int channels;   // 1 = PGM, 3 = PPM
+        unsigned int seed;
+
+        Spec() : pattern(NATURAL), width(1024), height(1024), channels(1), seed(1) {}
+    };
+
+    // Lado máximo admitido (32K x 32K)
+    static const int MAX_DIMENSION = 32768;
+
+    // Indica si 'source' es una especificación "synth:..." en lugar de un archivo
+    static bool isSpec(const char* source);
+    static bool parseSpec(const char* source, Spec& spec);
+
+    // Imagen en memoria (binaria, max_color 255). El raster usa índices int,
+    // así que el total de muestras no puede superar INT_MAX (una PPM de 32K x
+    // 32K solo puede generarse a disco con write).
+    static Imagen* create(const Spec& spec);
+    static Imagen* createFromSpec(const char* source);
+
+    // Escribe el archivo fila a fila, en P5/P6 o P2/P3 según 'binary'
+    static bool write(const Spec& spec, const char* filename, bool binary);
+
+    // Rellena la fila y con width * channels muestras
+    static void generateRow(const Spec& spec, int y, int* row);
+
+    static bool stringToPattern(const char* name, Pattern& pattern);
+    static const char* patternToString(Pattern pattern);
+};
+
+#endif
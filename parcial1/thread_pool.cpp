@@ -0,0 +1,165 @@
+#include "thread_pool.h"
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <unistd.h>
+
+// Marca los hilos del pool para detectar llamadas anidadas
+static __thread bool tls_is_worker = false;
+
+ThreadPool::ThreadPool(int num_threads)
+    : current_task(nullptr), generation(0), pending_workers(0), shutting_down(false) {
+    if (num_threads <= 0) {
+        num_threads = getHardwareConcurrency();
+    }
+
+    pthread_mutex_init(&submit_mutex, nullptr);
+    pthread_mutex_init(&mutex, nullptr);
+    pthread_cond_init(&work_cond, nullptr);
+    pthread_cond_init(&done_cond, nullptr);
+
+    // Reservar antes de crear hilos: workerMain recibe punteros a estos elementos
+    worker_args.resize(num_threads);
+    threads.reserve(num_threads);
+
+    for (int i = 0; i < num_threads; i++) {
+        worker_args[i].pool = this;
+        worker_args[i].worker_id = i;
+
+        pthread_t thread;
+        int result = pthread_create(&thread, nullptr, workerMain, &worker_args[i]);
+        if (result != 0) {
+            std::cerr << "Warning: Could not create pool thread " << i
+                      << ", continuing with " << threads.size() << " threads" << std::endl;
+            break;
+        }
+        threads.push_back(thread);
+    }
+
+    if (threads.empty()) {
+        std::cerr << "Error: Thread pool has no threads, work will run on the caller" << std::endl;
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    pthread_mutex_lock(&mutex);
+    shutting_down = true;
+    pthread_cond_broadcast(&work_cond);
+    pthread_mutex_unlock(&mutex);
+
+    for (size_t i = 0; i < threads.size(); i++) {
+        pthread_join(threads[i], nullptr);
+    }
+
+    pthread_cond_destroy(&done_cond);
+    pthread_cond_destroy(&work_cond);
+    pthread_mutex_destroy(&mutex);
+    pthread_mutex_destroy(&submit_mutex);
+}
+
+int ThreadPool::getHardwareConcurrency() {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? static_cast<int>(cpus) : 1;
+}
+
+bool ThreadPool::isWorkerThread() {
+    return tls_is_worker;
+}
+
+void* ThreadPool::workerMain(void* arg) {
+    WorkerArgs* args = static_cast<WorkerArgs*>(arg);
+    tls_is_worker = true;
+    args->pool->workerLoop(args->worker_id);
+    return nullptr;
+}
+
+void ThreadPool::workerLoop(int worker_id) {
+    unsigned long seen_generation = 0;
+
+    while (true) {
+        pthread_mutex_lock(&mutex);
+        while (!shutting_down && generation == seen_generation) {
+            pthread_cond_wait(&work_cond, &mutex);
+        }
+        if (shutting_down) {
+            pthread_mutex_unlock(&mutex);
+            return;
+        }
+        seen_generation = generation;
+        const WorkerTask* task = current_task;
+        pthread_mutex_unlock(&mutex);
+
+        (*task)(worker_id);
+
+        pthread_mutex_lock(&mutex);
+        pending_workers--;
+        if (pending_workers == 0) {
+            pthread_cond_signal(&done_cond);
+        }
+        pthread_mutex_unlock(&mutex);
+    }
+}
+
+void ThreadPool::runOnAll(const WorkerTask& task) {
+    // Sin hilos, o llamada desde dentro de otro trabajo: ejecutar en línea
+    if (threads.empty() || tls_is_worker) {
+        task(0);
+        return;
+    }
+
+    // La ranura current_task/pending_workers es única: otro hilo que envíe
+    // un trabajo al mismo tiempo espera a que termine este
+    pthread_mutex_lock(&submit_mutex);
+    pthread_mutex_lock(&mutex);
+    current_task = &task;
+    pending_workers = static_cast<int>(threads.size());
+    generation++;
+    pthread_cond_broadcast(&work_cond);
+
+    while (pending_workers > 0) {
+        pthread_cond_wait(&done_cond, &mutex);
+    }
+    current_task = nullptr;
+    pthread_mutex_unlock(&mutex);
+    pthread_mutex_unlock(&submit_mutex);
+}
+
+void ThreadPool::parallelFor(int begin, int end, const RangeTask& task, int chunk) {
+    if (end <= begin) {
+        return;
+    }
+
+    if (threads.empty() || tls_is_worker) {
+        task(begin, end, 0);
+        return;
+    }
+
+    const int num_workers = getNumThreads();
+    const int total = end - begin;
+
+    if (chunk <= 0) {
+        // Reparto estático: el resto se reparte una fila por hilo entre los primeros
+        runOnAll([&](int worker_id) {
+            int base = total / num_workers;
+            int extra = total % num_workers;
+            int start = begin + worker_id * base + std::min(worker_id, extra);
+            int stop = start + base + (worker_id < extra ? 1 : 0);
+            if (start < stop) {
+                task(start, stop, worker_id);
+            }
+        });
+        return;
+    }
+
+    // Reparto dinámico por bloques
+    std::atomic<int> next(begin);
+    runOnAll([&](int worker_id) {
+        while (true) {
+            int start = next.fetch_add(chunk);
+            if (start >= end) {
+                break;
+            }
+            task(start, std::min(end, start + chunk), worker_id);
+        }
+    });
+}
@@ -0,0 +1,65 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <pthread.h>
+#include <functional>
+#include <vector>
+
+// Pool persistente de hilos POSIX. Los hilos se crean una sola vez y quedan
+// dormidos entre trabajos, de modo que cada llamada a parallelFor solo paga
+// una señal y una espera en lugar de pthread_create/pthread_join.
+class ThreadPool {
+public:
+    // Cuerpo de un parallelFor: rango [begin, end) y número de hilo que lo ejecuta
+    typedef std::function<void(int begin, int end, int worker_id)> RangeTask;
+    // Tarea que se ejecuta una vez en cada hilo del pool
+    typedef std::function<void(int worker_id)> WorkerTask;
+
+    // num_threads <= 0 usa la concurrencia del hardware
+    explicit ThreadPool(int num_threads = 0);
+    ~ThreadPool();
+
+    int getNumThreads() const { return static_cast<int>(threads.size()); }
+
+    // Reparte [begin, end) entre los hilos y espera a que terminen.
+    // chunk <= 0: un bloque contiguo por hilo (reparto estático).
+    // chunk > 0: bloques de 'chunk' elementos repartidos dinámicamente.
+    void parallelFor(int begin, int end, const RangeTask& task, int chunk = 0);
+
+    // Ejecuta task(worker_id) en todos los hilos y espera a que terminen.
+    // Varios hilos pueden enviar trabajos al mismo pool: se ejecutan de uno en uno.
+    void runOnAll(const WorkerTask& task);
+
+    // Indica si el hilo actual pertenece a algún pool (las llamadas anidadas se ejecutan en línea)
+    static bool isWorkerThread();
+
+    // Número de CPUs en línea
+    static int getHardwareConcurrency();
+
+private:
+    std::vector<pthread_t> threads;
+    pthread_mutex_t submit_mutex;   // un trabajo a la vez (se toma antes que 'mutex')
+    pthread_mutex_t mutex;
+    pthread_cond_t work_cond;
+    pthread_cond_t done_cond;
+
+    const WorkerTask* current_task;
+    unsigned long generation;
+    int pending_workers;
+    bool shutting_down;
+
+    struct WorkerArgs {
+        ThreadPool* pool;
+        int worker_id;
+    };
+    std::vector<WorkerArgs> worker_args;
+
+    static void* workerMain(void* arg);
+    void workerLoop(int worker_id);
+
+    // No copiable
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+};
+
+#endif
@@ -0,0 +1,213 @@
+#include "tile_autotuner.h"
+#include "PGMimage.h"
+#include "PPMimage.h"
+#include "filter.h"
+#include "timer.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdio>
+#include <unistd.h>
+
+const char* TileAutotuner::DEFAULT_PROFILE_PATH = "tile_profile.conf";
+const double TileAutotuner::MIN_GAIN = 0.10;
+
+// Candidatos: anchos en píxeles y altos en filas (filas completas es la referencia)
+static const int CANDIDATE_WIDTHS[] = {128, 256, 512, 1024, 2048, 4096};
+static const int CANDIDATE_HEIGHTS[] = {8, 16, 32, 64};
+
+void TileProfile::getTileSize(const Imagen* image, int& width, int& height) const {
+    if (image && strcmp(image->getMagic(), "P3") == 0) {
+        width = ppm_width;
+        height = ppm_height;
+    } else {
+        width = pgm_width;
+        height = pgm_height;
+    }
+}
+
+std::string TileAutotuner::machineSignature() {
+    char hostname[256] = "unknown";
+    gethostname(hostname, sizeof(hostname) - 1);
+
+    std::ostringstream signature;
+    signature << hostname << "/" << sysconf(_SC_NPROCESSORS_ONLN) << "cpu/"
+              << sysconf(_SC_LEVEL1_DCACHE_SIZE) << "/" << sysconf(_SC_LEVEL2_CACHE_SIZE) << "/"
+              << sysconf(_SC_LEVEL3_CACHE_SIZE);
+    return signature.str();
+}
+
+bool TileAutotuner::loadProfile(const char* path, TileProfile& profile) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    std::string line, machine;
+    TileProfile result;
+    int fields = 0;
+
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, eq);
+        std::string value = line.substr(eq + 1);
+
+        if (key == "machine") {
+            machine = value;
+        } else if (key == "pgm" && sscanf(value.c_str(), "%dx%d", &result.pgm_width, &result.pgm_height) == 2) {
+            fields++;
+        } else if (key == "ppm" && sscanf(value.c_str(), "%dx%d", &result.ppm_width, &result.ppm_height) == 2) {
+            fields++;
+        }
+    }
+
+    // Un perfil de otra máquina no sirve
+    if (fields != 2 || machine != machineSignature()) {
+        return false;
+    }
+
+    result.loaded = true;
+    profile = result;
+    return true;
+}
+
+bool TileAutotuner::saveProfile(const char* path, const TileProfile& profile) {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Error: Cannot write tile profile " << path << std::endl;
+        return false;
+    }
+
+    file << "# Tile sizes chosen by the autotuner (WxH, 0x0 = no blocking)" << std::endl;
+    file << "machine=" << machineSignature() << std::endl;
+    file << "pgm=" << profile.pgm_width << "x" << profile.pgm_height << std::endl;
+    file << "ppm=" << profile.ppm_width << "x" << profile.ppm_height << std::endl;
+    return true;
+}
+
+// Mejor de varias repeticiones (la primera también calienta la caché)
+static double measure(Imagen* input, Imagen* output, int width, int height, int repetitions) {
+    double best = -1.0;
+    for (int rep = 0; rep < repetitions; rep++) {
+        Timer timer;
+        timer.start();
+        Filter::applyFilterBlocked(input, output, Filter::BLUR, width, height);
+        timer.stop();
+        double elapsed = timer.getElapsedMilliseconds();
+        if (best < 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+void TileAutotuner::benchmark(Imagen* input, Imagen* output, int& best_width, int& best_height, bool verbose) {
+    const int num_widths = sizeof(CANDIDATE_WIDTHS) / sizeof(CANDIDATE_WIDTHS[0]);
+    const int num_heights = sizeof(CANDIDATE_HEIGHTS) / sizeof(CANDIDATE_HEIGHTS[0]);
+
+    // Referencia: filas completas, como applyFilter sin bloqueo
+    const double baseline_time = measure(input, output, 0, 0, TUNE_REPETITIONS);
+    if (verbose) {
+        std::cout << "    full rows: " << baseline_time << " ms" << std::endl;
+    }
+
+    double best_time = -1.0;
+    int candidate_width = 0, candidate_height = 0;
+    for (int wi = 0; wi < num_widths; wi++) {
+        for (int hi = 0; hi < num_heights; hi++) {
+            int width = CANDIDATE_WIDTHS[wi];
+            int height = CANDIDATE_HEIGHTS[hi];
+            double candidate_time = measure(input, output, width, height, TUNE_REPETITIONS);
+
+            if (verbose) {
+                std::cout << "    " << width << "x" << height << ": " << candidate_time << " ms" << std::endl;
+            }
+
+            if (best_time < 0 || candidate_time < best_time) {
+                best_time = candidate_time;
+                candidate_width = width;
+                candidate_height = height;
+            }
+        }
+    }
+
+    // Una diferencia dentro del ruido de medida no justifica bloquear
+    if (best_time >= 0 && best_time < baseline_time * (1.0 - MIN_GAIN)) {
+        best_width = candidate_width;
+        best_height = candidate_height;
+    } else {
+        best_width = 0;
+        best_height = 0;
+    }
+}
+
+TileProfile TileAutotuner::tune(bool verbose) {
+    TileProfile profile;
+
+    // Imágenes sintéticas con un patrón determinista
+    PGMImage pgm_input, pgm_output;
+    PPMImage ppm_input, ppm_output;
+    Imagen* inputs[2] = {&pgm_input, &ppm_input};
+
+    for (int i = 0; i < 2; i++) {
+        inputs[i]->setWidth(TUNE_WIDTH);
+        inputs[i]->setHeight(TUNE_HEIGHT);
+        inputs[i]->setMaxColor(255);
+        inputs[i]->allocatePixels();
+        int* pixels = inputs[i]->getPixels();
+        if (!pixels) {
+            std::cerr << "Warning: Cannot allocate the autotuning images, using default tile sizes" << std::endl;
+            return profile;
+        }
+        for (int p = 0; p < inputs[i]->getPixelCount(); p++) {
+            pixels[p] = (p * 7 + (p >> 5)) & 255;
+        }
+    }
+
+    if (verbose) {
+        std::cout << "Autotuning convolution tile size on " << TUNE_WIDTH << "x" << TUNE_HEIGHT << " images..." << std::endl;
+        std::cout << "  PGM:" << std::endl;
+    }
+    benchmark(&pgm_input, &pgm_output, profile.pgm_width, profile.pgm_height, verbose);
+
+    if (verbose) {
+        std::cout << "  PPM:" << std::endl;
+    }
+    benchmark(&ppm_input, &ppm_output, profile.ppm_width, profile.ppm_height, verbose);
+
+    if (verbose) {
+        std::cout << "  Best: PGM " << profile.pgm_width << "x" << profile.pgm_height
+                  << ", PPM " << profile.ppm_width << "x" << profile.ppm_height << std::endl;
+    }
+
+    profile.loaded = true;
+    return profile;
+}
+
+TileProfile TileAutotuner::loadOrTune(const char* path, bool force_tune, bool verbose) {
+    if (!path) {
+        path = DEFAULT_PROFILE_PATH;
+    }
+
+    TileProfile profile;
+    if (!force_tune && loadProfile(path, profile)) {
+        if (verbose) {
+            std::cout << "Tile profile loaded from " << path << ": PGM " << profile.pgm_width << "x"
+                      << profile.pgm_height << ", PPM " << profile.ppm_width << "x" << profile.ppm_height << std::endl;
+        }
+        return profile;
+    }
+
+    profile = tune(verbose);
+    if (profile.loaded && saveProfile(path, profile) && verbose) {
+        std::cout << "Tile profile saved to " << path << std::endl;
+    }
+    return profile;
+}
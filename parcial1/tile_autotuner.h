@@ -0,0 +1,54 @@
+#ifndef TILE_AUTOTUNER_H
+#define TILE_AUTOTUNER_H
+
+#include <string>
+#include "imagen.h"
+
+// Tamaños de bloque elegidos para cada formato (0x0 = sin bloqueo: ningún
+// candidato ganó con margen a recorrer filas completas)
+struct TileProfile {
+    int pgm_width, pgm_height;
+    int ppm_width, ppm_height;
+    bool loaded;
+
+    TileProfile() : pgm_width(0), pgm_height(0), ppm_width(0), ppm_height(0), loaded(false) {}
+
+    // Tamaño que corresponde al formato de la imagen
+    void getTileSize(const Imagen* image, int& width, int& height) const;
+};
+
+// Busca el mejor tamaño de bloque para la convolución en esta máquina.
+// Mide una imagen sintética ancha con cada candidato y con filas completas;
+// un bloque solo se elige si gana por MIN_GAIN. Los procesadores solo lo
+// usan con --autotune o un --profile explícito: el ganador se guarda en el
+// archivo de perfil y las ejecuciones siguientes solo lo leen.
+class TileAutotuner {
+public:
+    static const char* DEFAULT_PROFILE_PATH;
+
+    // Lee el perfil; falla si no existe o se generó en otra máquina
+    static bool loadProfile(const char* path, TileProfile& profile);
+    static bool saveProfile(const char* path, const TileProfile& profile);
+
+    // Ejecuta la búsqueda (algunos segundos)
+    static TileProfile tune(bool verbose);
+
+    // Carga el perfil y, si no hay uno válido o force_tune, lo genera y lo guarda.
+    // Sin path usa DEFAULT_PROFILE_PATH
+    static TileProfile loadOrTune(const char* path, bool force_tune, bool verbose);
+
+    // Host, CPUs y tamaños de caché: un perfil de otra máquina se descarta
+    static std::string machineSignature();
+
+private:
+    // Imagen sintética: 16K columnas, donde tres filas ya no caben en L1/L2
+    static const int TUNE_WIDTH = 16384;
+    static const int TUNE_HEIGHT = 64;
+    static const int TUNE_REPETITIONS = 3;
+    // Fracción de tiempo que un bloque debe ahorrar frente a filas completas
+    static const double MIN_GAIN;
+
+    static void benchmark(Imagen* input, Imagen* output, int& best_width, int& best_height, bool verbose);
+};
+
+#endif
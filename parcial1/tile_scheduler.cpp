@@ -0,0 +1,152 @@
+#include "tile_scheduler.h"
+#include <algorithm>
+#include <unistd.h>
+
+// L2 supuesta cuando el sistema no informa su tamaño
+static const long FALLBACK_L2_BYTES = 256 * 1024;
+
+TileScheduler::TileScheduler(ThreadPool& thread_pool, int width, int height)
+    : pool(thread_pool), tile_width(0), tile_height(0), total_tiles(0) {
+    int num_queues = std::max(1, pool.getNumThreads());
+    for (int i = 0; i < num_queues; i++) {
+        WorkerQueue* queue = new WorkerQueue();
+        pthread_mutex_init(&queue->lock, nullptr);
+        queue->executed = 0;
+        queue->stolen = 0;
+        queues.push_back(queue);
+    }
+    setTileSize(width, height);
+}
+
+TileScheduler::~TileScheduler() {
+    for (size_t i = 0; i < queues.size(); i++) {
+        pthread_mutex_destroy(&queues[i]->lock);
+        delete queues[i];
+    }
+}
+
+void TileScheduler::getDefaultTileSize(int bytes_per_pixel, int& width, int& height) {
+    long l2_bytes = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (l2_bytes <= 0) {
+        l2_bytes = FALLBACK_L2_BYTES;
+    }
+
+    // Filas de 256 píxeles: varias líneas de caché contiguas por fila
+    width = 256;
+
+    // Entrada (h + 2 filas de halo) + salida (h filas) en la mitad de la L2
+    long row_bytes = static_cast<long>(width) * std::max(1, bytes_per_pixel);
+    long rows = (l2_bytes / 2) / (2 * row_bytes) - 1;
+    height = static_cast<int>(std::max(8L, std::min(256L, rows)));
+}
+
+void TileScheduler::setTileSize(int width, int height) {
+    int default_width, default_height;
+    // Caso más pesado del repositorio: PPM con 3 enteros por píxel
+    getDefaultTileSize(3 * static_cast<int>(sizeof(int)), default_width, default_height);
+    tile_width = width > 0 ? width : default_width;
+    tile_height = height > 0 ? height : default_height;
+}
+
+int TileScheduler::getTilesExecuted(int worker_id) const {
+    if (worker_id < 0 || worker_id >= static_cast<int>(queues.size())) {
+        return 0;
+    }
+    return queues[worker_id]->executed;
+}
+
+int TileScheduler::getTilesStolen(int worker_id) const {
+    if (worker_id < 0 || worker_id >= static_cast<int>(queues.size())) {
+        return 0;
+    }
+    return queues[worker_id]->stolen;
+}
+
+int TileScheduler::getTotalStolen() const {
+    int total = 0;
+    for (size_t i = 0; i < queues.size(); i++) {
+        total += queues[i]->stolen;
+    }
+    return total;
+}
+
+bool TileScheduler::popLocal(int worker_id, Tile& tile) {
+    WorkerQueue* queue = queues[worker_id];
+    pthread_mutex_lock(&queue->lock);
+    bool found = !queue->tiles.empty();
+    if (found) {
+        tile = queue->tiles.front();
+        queue->tiles.pop_front();
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return found;
+}
+
+bool TileScheduler::steal(int thief_id, Tile& tile) {
+    int num_queues = static_cast<int>(queues.size());
+
+    // Recorrer las demás colas empezando por la vecina
+    for (int offset = 1; offset < num_queues; offset++) {
+        WorkerQueue* victim = queues[(thief_id + offset) % num_queues];
+        pthread_mutex_lock(&victim->lock);
+        bool found = !victim->tiles.empty();
+        if (found) {
+            // Robar del final: lo más lejano a lo que procesa el dueño
+            tile = victim->tiles.back();
+            victim->tiles.pop_back();
+        }
+        pthread_mutex_unlock(&victim->lock);
+        if (found) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TileScheduler::run(int width, int height, const TileTask& task) {
+    int num_queues = static_cast<int>(queues.size());
+    int tiles_x = (width + tile_width - 1) / tile_width;
+    int tiles_y = (height + tile_height - 1) / tile_height;
+    total_tiles = (width > 0 && height > 0) ? tiles_x * tiles_y : 0;
+
+    // Repartir los tiles en orden de filas: bloques contiguos por hilo
+    for (int q = 0; q < num_queues; q++) {
+        queues[q]->tiles.clear();
+        queues[q]->executed = 0;
+        queues[q]->stolen = 0;
+    }
+    for (int t = 0; t < total_tiles; t++) {
+        int tx = t % tiles_x;
+        int ty = t / tiles_x;
+        Tile tile(tx * tile_width, ty * tile_height,
+                  std::min(width, (tx + 1) * tile_width), std::min(height, (ty + 1) * tile_height));
+        int owner = static_cast<int>(static_cast<long long>(t) * num_queues / total_tiles);
+        queues[owner]->tiles.push_back(tile);
+    }
+
+    if (total_tiles == 0) {
+        return;
+    }
+
+    pool.runOnAll([&](int worker_id) {
+        // Llamada anidada o pool vacío: un único "hilo" recorre todas las colas
+        if (worker_id >= num_queues) {
+            return;
+        }
+
+        Tile tile;
+        while (true) {
+            if (popLocal(worker_id, tile)) {
+                task(tile, worker_id);
+                queues[worker_id]->executed++;
+            } else if (steal(worker_id, tile)) {
+                task(tile, worker_id);
+                queues[worker_id]->executed++;
+                queues[worker_id]->stolen++;
+            } else {
+                // No se generan tiles nuevos: si todas las colas están vacías, terminamos
+                break;
+            }
+        }
+    });
+}
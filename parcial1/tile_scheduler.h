@@ -0,0 +1,70 @@
+#ifndef TILE_SCHEDULER_H
+#define TILE_SCHEDULER_H
+
+#include <pthread.h>
+#include <deque>
+#include <functional>
+#include <vector>
+#include "thread_pool.h"
+
+// Región rectangular [x0, x1) x [y0, y1) de la imagen
+struct Tile {
+    int x0, y0, x1, y1;
+    Tile(int left = 0, int top = 0, int right = 0, int bottom = 0)
+        : x0(left), y0(top), x1(right), y1(bottom) {}
+};
+
+// Planificador de tiles 2D con robo de trabajo. Cada hilo del pool recibe una
+// cola propia con un bloque contiguo de tiles; consume la suya por el frente
+// y, cuando se vacía, roba tiles del final de la cola de otro hilo. Así un
+// núcleo lento o compartido no retrasa la imagen completa.
+class TileScheduler {
+public:
+    typedef std::function<void(const Tile& tile, int worker_id)> TileTask;
+
+    // tile_width/tile_height <= 0 usan el tamaño por defecto según la caché
+    explicit TileScheduler(ThreadPool& pool, int tile_width = 0, int tile_height = 0);
+    ~TileScheduler();
+
+    // Recorre la imagen width x height en tiles y espera a que terminen
+    void run(int width, int height, const TileTask& task);
+
+    // Configuración
+    void setTileSize(int tile_width, int tile_height);
+    int getTileWidth() const { return tile_width; }
+    int getTileHeight() const { return tile_height; }
+    int getNumWorkers() const { return static_cast<int>(queues.size()); }
+
+    // Estadísticas de la última ejecución
+    int getTilesExecuted(int worker_id) const;
+    int getTilesStolen(int worker_id) const;
+    int getTotalTiles() const { return total_tiles; }
+    int getTotalStolen() const;
+
+    // Tamaño de tile que hace caber la entrada (con halo) y la salida en
+    // la mitad de la L2 para el número de bytes por píxel indicado
+    static void getDefaultTileSize(int bytes_per_pixel, int& tile_width, int& tile_height);
+
+private:
+    struct WorkerQueue {
+        pthread_mutex_t lock;
+        std::deque<Tile> tiles;
+        int executed;
+        int stolen;
+    };
+
+    ThreadPool& pool;
+    int tile_width;
+    int tile_height;
+    int total_tiles;
+    std::vector<WorkerQueue*> queues;
+
+    bool popLocal(int worker_id, Tile& tile);
+    bool steal(int thief_id, Tile& tile);
+
+    // No copiable
+    TileScheduler(const TileScheduler&);
+    TileScheduler& operator=(const TileScheduler&);
+};
+
+#endif
@@ -68,4 +68,9 @@ double Timer::getCurrentElapsedMilliseconds() const {
 
 double Timer::getCurrentElapsedSeconds() const {
     return getCurrentElapsedMilliseconds() / 1000.0;
-}
\ No newline at end of file
+}
+
+long long Timer::getTimestampMicroseconds() {
+    auto now = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+}
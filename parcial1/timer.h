@@ -32,6 +32,9 @@ public:
     // Obtener tiempo actual sin detener el timer
     double getCurrentElapsedMilliseconds() const;
     double getCurrentElapsedSeconds() const;
+    
+    // Marca de tiempo absoluta del mismo reloj (para trazas)
+    static long long getTimestampMicroseconds();
 };
 
 #endif
\ No newline at end of file